@@ -4,11 +4,13 @@
 #include <ryml_std.hpp>
 #include <c4/fs/fs.hpp>
 #include "c4/yml/parse.hpp"
+#include "c4/yml/alloc_stats.hpp"
 
 #include <vector>
 #include <iostream>
 
 #include "./libyaml.hpp"
+#include "./bm_perf.hpp"
 #include <benchmark/benchmark.h>
 
 // warning suppressions for thirdparty code
@@ -97,8 +99,43 @@ enum : int {
       kAll=kClearTree|kClearTreeArena|kResetInPlace,
 };
 
+/** count the allocations done through the ryml callbacks, by
+ * installing instrumented global callbacks while the object is alive.
+ * Declare it before any tree or parser, so that they use the
+ * instrumented callbacks. */
+struct BmAllocStats
+{
+    ryml::AllocStats stats;
+    BmAllocStats() : stats() { ryml::set_callbacks(stats.callbacks()); }
+    ~BmAllocStats() { ryml::set_callbacks(stats.wrapped()); }
+
+    /** publish the allocations done since the previous call as
+     * counters, and restart counting. The bytes and the number of
+     * allocations are given per iteration, and the peak is the
+     * maximum of the bytes allocated at any time. */
+    void report(bm::State &st)
+    {
+        using C = bm::Counter;
+        ryml::AllocCounts const& total = stats.total();
+        st.counters["alloc_bytes"] = C(static_cast<double>(total.bytes_total), C::kAvgIterations);
+        st.counters["alloc_count"] = C(static_cast<double>(total.num_allocs), C::kAvgIterations);
+        st.counters["alloc_peak"] = C(static_cast<double>(total.bytes_peak));
+        for(int i = 0; i < ryml::ALLOC_NUM_SITES; ++i)
+        {
+            const ryml::AllocSite_e site = static_cast<ryml::AllocSite_e>(i);
+            ryml::AllocCounts const& c = stats.site(site);
+            if(c.num_allocs)
+                st.counters[std::string("alloc_bytes_") + ryml::AllocStats::site_name(site)] = C(static_cast<double>(c.bytes_total), C::kAvgIterations);
+        }
+        stats.reset();
+    }
+};
+
+
 struct BmCase
 {
+    BmAllocStats           allocs; // first, to be used by the trees and parsers below
+    BmPerfCounters         perf;
     std::string            bm_name;
     c4::csubstr            filename;
     std::vector<char>      src;
@@ -141,6 +178,19 @@ USAGE: bm <case.yml>
         C4_ASSERT_MSG(strlen(in_place.data()) == in_place.size()-1,
                       "len=%zu sz=%zu",
                       strlen(in_place.data()), in_place.size());
+        start_counters();
+    }
+
+    /** start the allocation and performance counters from now, so that
+     * the setup done by a benchmark before its loop is not counted in
+     * its report() */
+    void start_counters()
+    {
+        allocs.stats.reset();
+        perf.start();
+        #ifdef RYML_PROFILE
+        ryml_parser.reset_profile();
+        #endif
     }
 
     void prepare(bm::State &st, int what)
@@ -167,19 +217,38 @@ USAGE: bm <case.yml>
         }
     }
 
-    void report(bm::State &st) const
+    void report(bm::State &st)
     {
         // number of times the source was parsed
         st.SetItemsProcessed(st.iterations());
         // number of bytes parsed in the source
         st.SetBytesProcessed(st.iterations() * src.size());
+        allocs.report(st);
+        perf.report(st);
+        #ifdef RYML_PROFILE
+        // the phases of ryml_parser, per iteration
+        using C = bm::Counter;
+        ryml::ParserProfile const& prof = ryml_parser.profile();
+        for(int i = 0; i < ryml::PARSER_NUM_PHASES; ++i)
+        {
+            ryml::ParserProfile::Phase const& ph = prof.phases[i];
+            if(!ph.calls)
+                continue;
+            std::string name = std::string("prof_") + ryml::ParserProfile::phase_name((ryml::ParserPhase_e)i);
+            st.counters[name + "_calls"] = C(static_cast<double>(ph.calls), C::kAvgIterations);
+            #ifdef RYML_PROFILE_CYCLES
+            st.counters[name + "_ticks"] = C(static_cast<double>(ph.ticks), C::kAvgIterations);
+            #endif
+        }
+        ryml_parser.reset_profile();
+        #endif
     }
 
     bool skip_libyaml_if_needed(bm::State &st) const
     {
-        if(filename.basename() == "trusty.yml")
+        if(filename.basename() == "trusty.yml" || filename.basename().begins_with("gen_anchors"))
         {
-            st.SkipWithError("trusty.yml has anchors/references, which do not parse successfully in our parser wrapper for libyaml");
+            st.SkipWithError("this case has anchors/references, which do not parse successfully in our parser wrapper for libyaml");
             return true;
         }
         return false;
@@ -1,4 +1,9 @@
 #include "./bm_common.hpp"
+#include <c4/yml/emit_parallel.hpp>
+#include <c4/yml/emit_events.hpp>
+#ifdef RYML_HAS_WRITER_FD
+#include <fcntl.h>
+#endif
 
 
 /** this is used by the benchmarks.
@@ -32,6 +37,7 @@ void bm_rapidjson(bm::State& st)
     rapidjson::StringBuffer buffer;
     if(s_bm_case->is_json)
         doc.Parse(src);
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         ONLY_FOR_JSON;
@@ -50,6 +56,7 @@ void bm_jsoncpp(bm::State& st)
         reader.parse(b, e, root);
     std::string str;
     std::ostringstream os;
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         ONLY_FOR_JSON;
@@ -67,6 +74,7 @@ void bm_nlohmann(bm::State& st)
         root = nlohmann::json::parse(src);
     std::string str;
     std::ostringstream os;
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         ONLY_FOR_JSON;
@@ -107,6 +115,7 @@ void bm_fyaml_ostream(bm::State& st)
     cfg.diag = nullptr;
     fy_emitter *emitter = fy_emitter_create(&cfg);
     fy_document *doc = fy_document_build_from_string(nullptr, src.str, src.len);
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         fy_emit_document(emitter, doc);
@@ -128,6 +137,7 @@ void bm_fyaml_str(bm::State& st)
     cfg.diag = nullptr;
     fy_emitter *emitter = fy_emitter_create(&cfg);
     fy_document *doc = fy_document_build_from_string(nullptr, src.str, src.len);
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         fy_emit_document(emitter, doc);
@@ -150,6 +160,7 @@ void bm_fyaml_str_reserve(bm::State& st)
     cfg.diag = nullptr;
     fy_emitter *emitter = fy_emitter_create(&cfg);
     fy_document *doc = fy_document_build_from_string(nullptr, src.str, src.len);
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         fy_emit_document(emitter, doc);
@@ -167,6 +178,7 @@ void bm_yamlcpp(bm::State& st)
     YAML::Node node = YAML::Load(src);
     std::string str;
     std::ostringstream os;
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         os << node;
@@ -181,6 +193,7 @@ void bm_ryml_ostream(bm::State& st)
     ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
     std::string str;
     std::ostringstream os;
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         os << tree;
@@ -194,6 +207,7 @@ void bm_ryml_str(bm::State& st)
     c4::csubstr src = c4::to_csubstr(s_bm_case->src);
     ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
     std::string str;
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         emitrs(tree, &str);
@@ -207,6 +221,7 @@ void bm_ryml_str_reserve(bm::State& st)
     std::string str;
     str.resize(2 * src.size());
     ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    s_bm_case->start_counters();
     for(auto _ : st)
     {
         emitrs(tree, &str);
@@ -214,9 +229,274 @@ void bm_ryml_str_reserve(bm::State& st)
     s_bm_case->report(st);
 }
 
+/** emit to a string using all the hardware threads */
+void bm_ryml_str_parallel(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    std::string str;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        ryml::emitrs_parallel(tree, &str);
+    }
+    s_bm_case->report(st);
+    st.counters["threads"] = (double)ryml::detail::emit_parallel_num_threads(0);
+}
+
+/** emit to a file, discarding the output */
+void bm_ryml_file(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    FILE *f = fopen("/dev/null", "wb");
+    if(!f) { st.SkipWithError("could not open /dev/null"); return; }
+    size_t sz = 0;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        sz += ryml::emit(tree, f);
+    }
+    bm::DoNotOptimize(sz);
+    fclose(f);
+    s_bm_case->report(st);
+}
+
+#ifdef RYML_HAS_WRITER_FD
+/** emit to a file descriptor with a large staging buffer, discarding
+ * the output */
+void bm_ryml_fd(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    int fd = open("/dev/null", O_WRONLY);
+    if(fd < 0) { st.SkipWithError("could not open /dev/null"); return; }
+    std::vector<char> stage(size_t(1) << 16);
+    size_t sz = 0;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        ryml::EmitterFd em(fd, c4::to_substr(stage));
+        sz += em.emit(ryml::YAML, tree).len;
+    }
+    bm::DoNotOptimize(sz);
+    close(fd);
+    s_bm_case->report(st);
+}
+
+/** emit to a list of chunks referencing the tree in place, and write
+ * them with writev(2), discarding the output */
+void bm_ryml_iovec(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    int fd = open("/dev/null", O_WRONLY);
+    if(fd < 0) { st.SkipWithError("could not open /dev/null"); return; }
+    size_t sz = 0, num_chunks = 0;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        ryml::EmitterIovec em;
+        em.emit(ryml::YAML, tree);
+        sz += em.writev(fd);
+        num_chunks = em.num_chunks();
+    }
+    bm::DoNotOptimize(sz);
+    close(fd);
+    s_bm_case->report(st);
+    st.counters["num_chunks"] = (double)num_chunks;
+}
+#endif
+
+/** emit to a buffer with the given style, and report the size of
+ * the output relative to the source */
+void bm_ryml_style(bm::State& st, ryml::EmitType_e style)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    // find out the needed size with a dry run
+    size_t len = ryml::EmitterBuf(c4::substr{}).emit(style, tree, /*error_on_excess*/false).len;
+    std::vector<char> buf(len);
+    size_t sz = 0;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        ryml::EmitterBuf em(c4::to_substr(buf));
+        sz += em.emit(style, tree).len;
+    }
+    bm::DoNotOptimize(sz);
+    s_bm_case->report(st);
+    st.counters["output_bytes"] = (double)len;
+    st.counters["output_ratio"] = (double)len / (double)src.len;
+}
+
+/** an event of the event emitter, recorded from a tree */
+struct EmitEvent
+{
+    typedef enum { BEGIN_MAP, BEGIN_SEQ, END_MAP, END_SEQ, KEY, VAL } Kind_e;
+    Kind_e kind;
+    c4::csubstr scalar;
+    bool quoted;
+};
+
+/** record the events which emit the node. Return false if the node
+ * has something which the event emitter does not write: streams,
+ * tags, anchors or references. */
+bool record_events(ryml::Tree const& t, size_t node, std::vector<EmitEvent> *events)
+{
+    if(t.is_stream(node) || t.has_key_tag(node) || t.has_val_tag(node) || t.has_anchor(node) || t.is_ref(node))
+        return false;
+    if(t.has_key(node))
+        events->push_back({EmitEvent::KEY, t.key(node), t.is_key_quoted(node)});
+    if(t.is_container(node))
+    {
+        const bool is_map = t.is_map(node);
+        events->push_back({is_map ? EmitEvent::BEGIN_MAP : EmitEvent::BEGIN_SEQ, {}, false});
+        for(size_t ich = t.first_child(node); ich != ryml::NONE; ich = t.next_sibling(ich))
+            if(!record_events(t, ich, events))
+                return false;
+        events->push_back({is_map ? EmitEvent::END_MAP : EmitEvent::END_SEQ, {}, false});
+    }
+    else
+    {
+        events->push_back({EmitEvent::VAL, t.val(node), t.is_val_quoted(node)});
+    }
+    return true;
+}
+
+/** build a tree from the events, reusing the memory of the tree */
+void build_tree(std::vector<EmitEvent> const& events, ryml::Tree *t)
+{
+    t->clear();
+    t->clear_arena();
+    size_t parent = ryml::NONE;
+    c4::csubstr key;
+    ryml::type_bits key_flags = 0;
+    for(EmitEvent const& e : events)
+    {
+        switch(e.kind)
+        {
+        case EmitEvent::KEY:
+            key = e.scalar;
+            key_flags = e.quoted ? ryml::KEYQUO : ryml::NOTYPE;
+            break;
+        case EmitEvent::VAL:
+        {
+            const ryml::type_bits val_flags = e.quoted ? ryml::VALQUO : ryml::NOTYPE;
+            if(parent == ryml::NONE)
+                t->to_val(t->root_id(), e.scalar, val_flags);
+            else if(t->is_map(parent))
+                t->to_keyval(t->append_child(parent), key, e.scalar, key_flags|val_flags);
+            else
+                t->to_val(t->append_child(parent), e.scalar, val_flags);
+            break;
+        }
+        case EmitEvent::BEGIN_MAP:
+        case EmitEvent::BEGIN_SEQ:
+        {
+            const bool is_map = e.kind == EmitEvent::BEGIN_MAP;
+            size_t node = parent == ryml::NONE ? t->root_id() : t->append_child(parent);
+            const bool has_key = parent != ryml::NONE && t->is_map(parent);
+            if(is_map && has_key)
+                t->to_map(node, key, key_flags);
+            else if(is_map)
+                t->to_map(node);
+            else if(has_key)
+                t->to_seq(node, key, key_flags);
+            else
+                t->to_seq(node);
+            parent = node;
+            break;
+        }
+        case EmitEvent::END_MAP:
+        case EmitEvent::END_SEQ:
+            parent = t->parent(parent);
+            break;
+        }
+    }
+}
+
+/** emit the recorded events with the event emitter, ie without a
+ * tree */
+void bm_ryml_events_str(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    std::vector<EmitEvent> events;
+    if(!record_events(tree, tree.root_id(), &events))
+    {
+        st.SkipWithError("the event emitter does not write streams, tags, anchors or references");
+        return;
+    }
+    std::string str;
+    size_t sz = 0;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        ryml::EventEmitterResizable<std::string> em(ryml::YAML, &str);
+        for(EmitEvent const& e : events)
+        {
+            switch(e.kind)
+            {
+            case EmitEvent::BEGIN_MAP: em.begin_map(); break;
+            case EmitEvent::BEGIN_SEQ: em.begin_seq(); break;
+            case EmitEvent::END_MAP: em.end_map(); break;
+            case EmitEvent::END_SEQ: em.end_seq(); break;
+            case EmitEvent::KEY: em.key(e.scalar, e.quoted); break;
+            case EmitEvent::VAL: em.val(e.scalar, e.quoted); break;
+            }
+        }
+        sz += em.finish().len;
+    }
+    bm::DoNotOptimize(sz);
+    s_bm_case->report(st);
+    st.counters["num_events"] = (double)events.size();
+}
+
+/** the baseline for bm_ryml_events_str: build a tree from the same
+ * events, and emit the tree */
+void bm_ryml_events_tree_str(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    std::vector<EmitEvent> events;
+    if(!record_events(tree, tree.root_id(), &events))
+    {
+        st.SkipWithError("the event emitter does not write streams, tags, anchors or references");
+        return;
+    }
+    ryml::Tree built;
+    std::string str;
+    size_t sz = 0;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        build_tree(events, &built);
+        sz += emitrs(built, &str).len;
+    }
+    bm::DoNotOptimize(sz);
+    s_bm_case->report(st);
+    st.counters["num_events"] = (double)events.size();
+}
+
+void bm_ryml_buf_block(bm::State& st) { bm_ryml_style(st, ryml::YAML); }
+void bm_ryml_buf_flow_sl(bm::State& st) { bm_ryml_style(st, ryml::YAML_FLOW_SL); }
+void bm_ryml_buf_flow_ml(bm::State& st) { bm_ryml_style(st, ryml::YAML_FLOW_ML); }
+
 BENCHMARK(bm_ryml_str_reserve);
+BENCHMARK(bm_ryml_buf_block);
+BENCHMARK(bm_ryml_buf_flow_sl);
+BENCHMARK(bm_ryml_buf_flow_ml);
 BENCHMARK(bm_ryml_str);
+BENCHMARK(bm_ryml_str_parallel);
+BENCHMARK(bm_ryml_events_str);
+BENCHMARK(bm_ryml_events_tree_str);
 BENCHMARK(bm_ryml_ostream);
+BENCHMARK(bm_ryml_file);
+#ifdef RYML_HAS_WRITER_FD
+BENCHMARK(bm_ryml_fd);
+BENCHMARK(bm_ryml_iovec);
+#endif
 #ifdef RYML_HAVE_LIBFYAML
 BENCHMARK(bm_fyaml_str_reserve);
 BENCHMARK(bm_fyaml_str);
@@ -0,0 +1,208 @@
+#include "./bm_common.hpp"
+
+#include <cstdlib>
+#include <cstdio>
+
+
+/** this is used by the benchmarks.
+ *
+ * @note We cannot declare the case as value-static as there is no guarantee
+ * that the allocator's lifetime starts before and ends after the case's
+ * lifetime. So use a pointer to control the lifetime. */
+static BmCase * C4_RESTRICT s_bm_case = nullptr;
+
+
+/** the numeric leaves of the case, collected once after parsing. The
+ * throughput is measured in terms of the size of the numeric
+ * scalars, not of the whole source. */
+struct FloatLeaves
+{
+    ryml::Tree tree;
+    std::vector<size_t> ids;
+    std::vector<double> vals;
+    std::vector<std::string> strs; // zero-terminated, for strtod()
+    size_t num_bytes = 0;
+
+    void load(BmCase const& c)
+    {
+        tree = ryml::parse_in_arena(c.filename, c4::to_csubstr(c.src));
+        for(size_t id = 0; id < tree.size(); ++id)
+        {
+            if(!tree.is_val(id) && !tree.is_keyval(id))
+                continue;
+            double d;
+            if(!ryml::from_chars_float(tree.val(id), &d))
+                continue;
+            ids.push_back(id);
+            vals.push_back(d);
+            strs.emplace_back(tree.val(id).str, tree.val(id).len);
+            num_bytes += tree.val(id).len;
+        }
+    }
+
+    bool skip_if_needed(bm::State &st) const
+    {
+        if(ids.empty())
+        {
+            st.SkipWithError("no floating point values in this file");
+            return true;
+        }
+        return false;
+    }
+
+    void report(bm::State &st) const
+    {
+        st.SetItemsProcessed(st.iterations() * (int64_t)ids.size());
+        st.SetBytesProcessed(st.iterations() * (int64_t)num_bytes);
+    }
+};
+static FloatLeaves * C4_RESTRICT s_leaves = nullptr;
+
+
+int main(int argc, char** argv)
+{
+    BmCase fixture;
+    FloatLeaves leaves;
+    s_bm_case = &fixture;
+    s_leaves = &leaves;
+    bm::Initialize(&argc, argv);
+    if(argc < 2)
+    {
+        std::cout << "USAGE: bm <case.json>\n";
+        return 1;
+    }
+    fixture.bm_name = "FLOAT";
+    fixture.load(argv[1]);
+    leaves.load(fixture);
+    bm::RunSpecifiedBenchmarks();
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+// deserialize: text -> value
+
+template<class T>
+void bm_ryml_read(bm::State& st)
+{
+    if(s_leaves->skip_if_needed(st))
+        return;
+    ryml::Tree const& tree = s_leaves->tree;
+    T val = {}, sum = {};
+    for(auto _ : st)
+    {
+        for(size_t id : s_leaves->ids)
+        {
+            ryml::NodeRef(const_cast<ryml::Tree*>(&tree), id) >> val;
+            sum += val;
+        }
+        bm::DoNotOptimize(sum);
+    }
+    s_leaves->report(st);
+}
+
+void bm_ryml_read_double(bm::State& st) { bm_ryml_read<double>(st); }
+void bm_ryml_read_float(bm::State& st) { bm_ryml_read<float>(st); }
+
+void bm_c4_from_chars_double(bm::State& st)
+{
+    if(s_leaves->skip_if_needed(st))
+        return;
+    ryml::Tree const& tree = s_leaves->tree;
+    double val = 0., sum = 0.;
+    for(auto _ : st)
+    {
+        for(size_t id : s_leaves->ids)
+        {
+            c4::from_chars(tree.val(id), &val);
+            sum += val;
+        }
+        bm::DoNotOptimize(sum);
+    }
+    s_leaves->report(st);
+}
+
+void bm_std_strtod(bm::State& st)
+{
+    if(s_leaves->skip_if_needed(st))
+        return;
+    double sum = 0.;
+    for(auto _ : st)
+    {
+        for(std::string const& s : s_leaves->strs)
+            sum += std::strtod(s.c_str(), nullptr);
+        bm::DoNotOptimize(sum);
+    }
+    s_leaves->report(st);
+}
+
+
+//-----------------------------------------------------------------------------
+
+// serialize: value -> text
+
+template<class T>
+void bm_ryml_write(bm::State& st)
+{
+    if(s_leaves->skip_if_needed(st))
+        return;
+    ryml::Tree tree = s_leaves->tree;
+    std::vector<T> vals(s_leaves->vals.begin(), s_leaves->vals.end());
+    tree.reserve_arena(2 * tree.arena_capacity());
+    for(auto _ : st)
+    {
+        st.PauseTiming();
+        tree.clear_arena();
+        st.ResumeTiming();
+        size_t i = 0;
+        for(size_t id : s_leaves->ids)
+            ryml::NodeRef(&tree, id) << vals[i++];
+        bm::DoNotOptimize(tree.arena_size());
+    }
+    s_leaves->report(st);
+}
+
+void bm_ryml_write_double(bm::State& st) { bm_ryml_write<double>(st); }
+void bm_ryml_write_float(bm::State& st) { bm_ryml_write<float>(st); }
+
+void bm_c4_to_chars_double(bm::State& st)
+{
+    if(s_leaves->skip_if_needed(st))
+        return;
+    char buf_[64];
+    c4::substr buf(buf_);
+    size_t sum = 0;
+    for(auto _ : st)
+    {
+        for(double d : s_leaves->vals)
+            sum += c4::to_chars(buf, d);
+        bm::DoNotOptimize(sum);
+    }
+    s_leaves->report(st);
+}
+
+void bm_std_snprintf_double(bm::State& st)
+{
+    if(s_leaves->skip_if_needed(st))
+        return;
+    char buf[64];
+    size_t sum = 0;
+    for(auto _ : st)
+    {
+        for(double d : s_leaves->vals)
+            sum += (size_t)std::snprintf(buf, sizeof(buf), "%.17g", d);
+        bm::DoNotOptimize(sum);
+    }
+    s_leaves->report(st);
+}
+
+BENCHMARK(bm_ryml_read_double);
+BENCHMARK(bm_ryml_read_float);
+BENCHMARK(bm_c4_from_chars_double);
+BENCHMARK(bm_std_strtod);
+BENCHMARK(bm_ryml_write_double);
+BENCHMARK(bm_ryml_write_float);
+BENCHMARK(bm_c4_to_chars_double);
+BENCHMARK(bm_std_snprintf_double);
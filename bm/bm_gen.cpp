@@ -0,0 +1,377 @@
+/** Generate synthetic benchmark cases: deterministic documents of a
+ * given shape and (approximate) size, so that the benchmarks can be
+ * run on inputs larger and more varied than the files in bm/cases.
+ *
+ * USAGE: ryml-bm-gen <shape> <size> <output> [seed]
+ *
+ * The size is the target number of bytes, and may have a suffix K, M
+ * or G (powers of 1024). The output stops at the first record boundary
+ * after the target size. The same shape, size and seed always produce
+ * the same output, on every platform.
+ *
+ * This does not use ryml: the inputs of the benchmarks do not depend
+ * on the code being benchmarked. */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <string>
+
+
+namespace {
+
+/** splitmix64: small, fast, and with the same sequence everywhere
+ * (unlike the std distributions) */
+struct Rng
+{
+    uint64_t state;
+
+    uint64_t next()
+    {
+        uint64_t z = (state += UINT64_C(0x9e3779b97f4a7c15));
+        z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+        z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+        return z ^ (z >> 31);
+    }
+    /** a number in [0, n) */
+    size_t below(size_t n) { return n ? (size_t)(next() % n) : 0u; }
+    /** a number in [lo, hi] */
+    size_t between(size_t lo, size_t hi) { return lo + below(hi - lo + 1); }
+    /** true with the given percent probability */
+    bool chance(unsigned percent) { return below(100) < percent; }
+};
+
+
+const char *const s_words[] = {
+    "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf",
+    "hotel", "india", "juliet", "kilo", "lima", "mike", "november",
+    "oscar", "papa", "quebec", "romeo", "sierra", "tango", "uniform",
+    "victor", "whiskey", "xray", "yankee", "zulu", "build", "deploy",
+    "release", "config", "server", "client", "cache", "index", "value",
+};
+constexpr size_t s_num_words = sizeof(s_words) / sizeof(s_words[0]);
+
+
+/** accumulates the output, and flushes it to the file in large chunks */
+struct Gen
+{
+    Rng rng;
+    FILE *file;
+    std::string buf;
+    size_t written;
+    size_t target;
+
+    Gen(uint64_t seed, FILE *f, size_t target_size) : rng{seed}, file(f), buf(), written(0), target(target_size)
+    {
+        buf.reserve(2u << 20u);
+    }
+    ~Gen()
+    {
+        flush();
+    }
+
+    bool done() const { return written + buf.size() >= target; }
+
+    void flush()
+    {
+        if(!buf.empty())
+            fwrite(buf.data(), 1, buf.size(), file);
+        written += buf.size();
+        buf.clear();
+    }
+    void maybe_flush()
+    {
+        if(buf.size() >= (1u << 20u))
+            flush();
+    }
+
+    void put(const char *s) { buf += s; }
+    void put(char c) { buf += c; }
+    void put(std::string const& s) { buf += s; }
+    void indent(size_t level) { buf.append(2 * level, ' '); }
+    void num(uint64_t n) { char tmp[32]; snprintf(tmp, sizeof(tmp), "%" PRIu64, n); buf += tmp; }
+    void word() { buf += s_words[rng.below(s_num_words)]; }
+    void words(size_t n)
+    {
+        for(size_t i = 0; i < n; ++i)
+        {
+            if(i)
+                put(' ');
+            word();
+        }
+    }
+    void real()
+    {
+        char tmp[64];
+        snprintf(tmp, sizeof(tmp), "%" PRIu64 ".%03u", rng.below(100000), (unsigned)rng.below(1000));
+        buf += tmp;
+    }
+
+    /** a scalar in one of the styles of YAML */
+    void scalar(size_t level)
+    {
+        switch(rng.below(10))
+        {
+        case 0: num(rng.next() % 1000000u); break;
+        case 1: real(); break;
+        case 2: put(rng.chance(50) ? "true" : "false"); break;
+        case 3: put('\''); word(); put(": "); words(rng.between(1, 4)); put('\''); break;
+        case 4: put('"'); words(rng.between(1, 4)); put("\\t"); word(); put('"'); break;
+        case 5:
+        case 6:
+        {
+            put(rng.chance(50) ? "|\n" : ">\n");
+            const size_t nlines = rng.between(1, 4);
+            for(size_t i = 0; i < nlines; ++i)
+            {
+                indent(level + 1);
+                words(rng.between(3, 10));
+                if(i + 1 < nlines)
+                    put('\n');
+            }
+            break;
+        }
+        default: words(rng.between(1, 3)); break;
+        }
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+
+/** a seq of config-like records mixing all the scalar styles, nested
+ * maps, flow seqs and seqs of maps */
+void gen_mixed(Gen &g)
+{
+    for(uint64_t i = 0; !g.done(); ++i)
+    {
+        g.put("- id: "); g.num(i); g.put('\n');
+        g.put("  name: "); g.word(); g.put('_'); g.num(i); g.put('\n');
+        g.put("  price: "); g.real(); g.put('\n');
+        g.put("  tags: [");
+        for(size_t t = 0, nt = g.rng.between(1, 5); t < nt; ++t)
+        {
+            if(t)
+                g.put(", ");
+            g.word();
+        }
+        g.put("]\n");
+        g.put("  description: "); g.scalar(1); g.put('\n');
+        g.put("  attrs:\n");
+        for(size_t a = 0, na = g.rng.between(1, 6); a < na; ++a)
+        {
+            g.put("    "); g.word(); g.put('_'); g.num(a); g.put(": "); g.scalar(2); g.put('\n');
+        }
+        if(g.rng.chance(50))
+        {
+            g.put("  items:\n");
+            for(size_t it = 0, nit = g.rng.between(1, 4); it < nit; ++it)
+            {
+                g.put("    - sku: "); g.num(g.rng.next() % 100000u); g.put('\n');
+                g.put("      qty: "); g.num(g.rng.between(1, 100)); g.put('\n');
+                g.put("      note: "); g.scalar(3); g.put('\n');
+            }
+        }
+        g.maybe_flush();
+    }
+}
+
+/** a single map with very many keys */
+void gen_wide(Gen &g)
+{
+    for(uint64_t i = 0; !g.done(); ++i)
+    {
+        g.put("key_"); g.num(i); g.put(": "); g.scalar(0); g.put('\n');
+        g.maybe_flush();
+    }
+}
+
+/** a seq of deeply nested subtrees, alternating maps and seqs */
+void gen_deep(Gen &g)
+{
+    const size_t depth = 64;
+    for(uint64_t i = 0; !g.done(); ++i)
+    {
+        g.put("- root_"); g.num(i); g.put(":\n");
+        size_t level = 2;
+        for(size_t d = 0; d < depth; ++d, ++level)
+        {
+            g.indent(level);
+            if(d & 1u)
+            {
+                g.put("- "); g.word(); g.put(": "); g.scalar(level + 1); g.put('\n');
+                g.indent(level + 1);
+                g.put("sub:\n");
+                ++level;
+            }
+            else
+            {
+                g.word(); g.put(": "); g.scalar(level); g.put('\n');
+                g.indent(level);
+                g.put("nest:\n");
+            }
+        }
+        g.indent(level);
+        g.put("leaf: "); g.scalar(level); g.put('\n');
+        g.maybe_flush();
+    }
+}
+
+/** a map of anchored definitions, followed by a seq of items referring
+ * to them with aliases and merge keys */
+void gen_anchors(Gen &g)
+{
+    const uint64_t num_defs = 256;
+    g.put("defs:\n");
+    for(uint64_t i = 0; i < num_defs; ++i)
+    {
+        g.put("  def_"); g.num(i); g.put(": &a"); g.num(i); g.put('\n');
+        for(size_t k = 0, nk = g.rng.between(2, 5); k < nk; ++k)
+        {
+            g.put("    "); g.word(); g.put('_'); g.num(k); g.put(": "); g.scalar(2); g.put('\n');
+        }
+    }
+    g.put("items:\n");
+    for(uint64_t i = 0; !g.done(); ++i)
+    {
+        g.put("  - <<: *a"); g.num(g.rng.below(num_defs)); g.put('\n');
+        g.put("    id: "); g.num(i); g.put('\n');
+        g.put("    ref: *a"); g.num(g.rng.below(num_defs)); g.put('\n');
+        if(g.rng.chance(30))
+        {
+            g.put("    own: &b"); g.num(i); g.put(' '); g.word(); g.put('\n');
+            g.put("    again: *b"); g.num(i); g.put('\n');
+        }
+        g.maybe_flush();
+    }
+}
+
+/** a stream of many small documents */
+void gen_docs(Gen &g)
+{
+    for(uint64_t i = 0; !g.done(); ++i)
+    {
+        g.put("---\n");
+        g.put("doc: "); g.num(i); g.put('\n');
+        for(size_t k = 0, nk = g.rng.between(1, 8); k < nk; ++k)
+        {
+            g.word(); g.put('_'); g.num(k); g.put(": "); g.scalar(0); g.put('\n');
+        }
+        g.maybe_flush();
+    }
+}
+
+/** an array of JSON objects, for the json parsers as well */
+void gen_json(Gen &g)
+{
+    g.put("[\n");
+    for(uint64_t i = 0; ; ++i)
+    {
+        g.put("{\"id\": "); g.num(i);
+        g.put(", \"name\": \""); g.word(); g.put('_'); g.num(i);
+        g.put("\", \"price\": "); g.real();
+        g.put(", \"active\": "); g.put(g.rng.chance(50) ? "true" : "false");
+        g.put(", \"tags\": [");
+        for(size_t t = 0, nt = g.rng.between(0, 5); t < nt; ++t)
+        {
+            if(t)
+                g.put(", ");
+            g.put('"'); g.word(); g.put('"');
+        }
+        g.put("], \"attrs\": {");
+        for(size_t a = 0, na = g.rng.between(1, 5); a < na; ++a)
+        {
+            if(a)
+                g.put(", ");
+            g.put('"'); g.word(); g.put('_'); g.num(a); g.put("\": \""); g.words(g.rng.between(1, 4)); g.put("\\n\"");
+        }
+        g.put("}}");
+        if(g.done())
+            break;
+        g.put(",\n");
+        g.maybe_flush();
+    }
+    g.put("\n]\n");
+}
+
+
+struct Shape
+{
+    const char *name;
+    void (*fn)(Gen &g);
+};
+const Shape s_shapes[] = {
+    {"mixed", &gen_mixed},
+    {"wide", &gen_wide},
+    {"deep", &gen_deep},
+    {"anchors", &gen_anchors},
+    {"docs", &gen_docs},
+    {"json", &gen_json},
+};
+
+
+bool parse_size(const char *s, size_t *size)
+{
+    char *end = nullptr;
+    unsigned long long n = strtoull(s, &end, 10);
+    if(end == s)
+        return false;
+    switch(*end)
+    {
+    case '\0': break;
+    case 'k': case 'K': n <<= 10u; ++end; break;
+    case 'm': case 'M': n <<= 20u; ++end; break;
+    case 'g': case 'G': n <<= 30u; ++end; break;
+    default: return false;
+    }
+    if(*end != '\0')
+        return false;
+    *size = (size_t)n;
+    return true;
+}
+
+void usage()
+{
+    fprintf(stderr, "USAGE: ryml-bm-gen <shape> <size>[K|M|G] <output> [seed]\n");
+    fprintf(stderr, "shapes:");
+    for(Shape const& s : s_shapes)
+        fprintf(stderr, " %s", s.name);
+    fprintf(stderr, "\n");
+}
+
+} // namespace
+
+
+int main(int argc, char **argv)
+{
+    if(argc < 4 || argc > 5)
+    {
+        usage();
+        return 1;
+    }
+    Shape const* shape = nullptr;
+    for(Shape const& s : s_shapes)
+        if(strcmp(s.name, argv[1]) == 0)
+            shape = &s;
+    size_t size = 0;
+    if(shape == nullptr || !parse_size(argv[2], &size))
+    {
+        usage();
+        return 1;
+    }
+    const uint64_t seed = (argc == 5) ? (uint64_t)strtoull(argv[4], nullptr, 10) : 1u;
+    FILE *f = fopen(argv[3], "wb");
+    if(f == nullptr)
+    {
+        fprintf(stderr, "could not open %s\n", argv[3]);
+        return 1;
+    }
+    {
+        Gen g(seed, f, size);
+        shape->fn(g);
+    }
+    const bool ok = (ferror(f) == 0);
+    fclose(f);
+    return ok ? 0 : 1;
+}
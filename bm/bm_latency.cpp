@@ -0,0 +1,232 @@
+#include "./bm_common.hpp"
+
+#include <chrono>
+
+
+/** latency of a single parse or emit, including the construction,
+ * reservation and teardown of the parser and tree where the variant
+ * does them. This matters for small documents (eg request bodies),
+ * where these fixed costs dominate, and where the distribution of the
+ * latency matters more than the throughput.
+ *
+ * Each operation is timed individually with a steady clock (so the
+ * resolution is that of the clock, and its overhead is included),
+ * and recorded in a histogram. The counters p50_ns, p90_ns, p99_ns,
+ * p999_ns and max_ns are the percentiles of the latency, in
+ * nanoseconds; the reported time is the mean latency. As in the parse
+ * benchmarks, resetting the in-place buffer and clearing a reused tree
+ * are not timed. */
+
+
+static BmCase * C4_RESTRICT s_bm_case = nullptr;
+
+
+int main(int argc, char** argv)
+{
+    BmCase fixture;
+    s_bm_case = &fixture;
+    s_bm_case->run("LATENCY", argc, argv);
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+/** a histogram of latencies in nanoseconds, with 32 buckets per power
+ * of two, so that the error of a percentile is below 1/32 of its
+ * value. Values below 64ns are exact. */
+struct LatencyHistogram
+{
+    enum : uint64_t { sub_bits = 5, num_sub = 1u << sub_bits };
+    enum : size_t { num_buckets = 64 * num_sub };
+
+    std::vector<uint64_t> counts;
+    uint64_t num = 0;
+    uint64_t max = 0;
+
+    LatencyHistogram() : counts(num_buckets, 0u) {}
+
+    static size_t bucket(uint64_t ns)
+    {
+        if(ns < 2 * num_sub)
+            return (size_t)ns;
+        size_t msb = 0;
+        for(uint64_t v = ns; v > 1u; v >>= 1u)
+            ++msb;
+        const size_t shift = msb - sub_bits;
+        const size_t b = shift * num_sub + (size_t)(ns >> shift);
+        return b < num_buckets ? b : num_buckets - 1;
+    }
+
+    /** the middle of the range of values of the bucket */
+    static uint64_t value(size_t b)
+    {
+        if(b < 2 * num_sub)
+            return b;
+        const size_t shift = b / num_sub - 1u;
+        const uint64_t mantissa = b - shift * num_sub;
+        return (mantissa << shift) + ((uint64_t(1) << shift) >> 1u);
+    }
+
+    void record(uint64_t ns)
+    {
+        ++counts[bucket(ns)];
+        ++num;
+        if(ns > max)
+            max = ns;
+    }
+
+    /** @p q in [0,1] */
+    uint64_t percentile(double q) const
+    {
+        if(!num)
+            return 0;
+        uint64_t rank = (uint64_t)(q * (double)num);
+        rank = rank < num ? rank : num - 1;
+        uint64_t seen = 0;
+        for(size_t b = 0; b < num_buckets; ++b)
+        {
+            seen += counts[b];
+            if(seen > rank)
+            {
+                const uint64_t v = value(b);
+                return v < max ? v : max;
+            }
+        }
+        return max;
+    }
+
+    void report(bm::State &st) const
+    {
+        st.counters["p50_ns"] = static_cast<double>(percentile(0.5));
+        st.counters["p90_ns"] = static_cast<double>(percentile(0.9));
+        st.counters["p99_ns"] = static_cast<double>(percentile(0.99));
+        st.counters["p999_ns"] = static_cast<double>(percentile(0.999));
+        st.counters["max_ns"] = static_cast<double>(max);
+    }
+};
+
+
+/** time each call to @p op, after calling @p prepare untimed */
+template<class Prepare, class Op>
+void measure(bm::State &st, Prepare &&prepare, Op &&op)
+{
+    using clock = std::chrono::steady_clock;
+    LatencyHistogram hist;
+    s_bm_case->start_counters();
+    for(auto _ : st)
+    {
+        prepare();
+        const auto t0 = clock::now();
+        op();
+        const auto t1 = clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        hist.record((uint64_t)ns);
+        st.SetIterationTime(1.e-9 * (double)ns);
+    }
+    hist.report(st);
+    s_bm_case->report(st);
+}
+
+void nop() {}
+
+
+//-----------------------------------------------------------------------------
+
+void bm_ryml_arena(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    measure(st, nop, [&]{
+        ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    });
+}
+
+void bm_ryml_inplace(bm::State& st)
+{
+    c4::substr src = c4::to_substr(s_bm_case->in_place);
+    measure(st, []{ s_bm_case->prepare(kResetInPlace); }, [&]{
+        ryml::Tree tree = ryml::parse_in_place(s_bm_case->filename, src);
+    });
+}
+
+void bm_ryml_arena_reuse(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    measure(st, []{ s_bm_case->prepare(kClearTree|kClearTreeArena); }, [&]{
+        s_bm_case->ryml_parser.parse_in_arena(s_bm_case->filename, src, &s_bm_case->ryml_tree);
+    });
+}
+
+void bm_ryml_inplace_reuse(bm::State& st)
+{
+    c4::substr src = c4::to_substr(s_bm_case->in_place);
+    measure(st, []{ s_bm_case->prepare(kResetInPlace|kClearTree|kClearTreeArena); }, [&]{
+        s_bm_case->ryml_parser.parse_in_place(s_bm_case->filename, src, &s_bm_case->ryml_tree);
+    });
+}
+
+/** a new parser and tree, with the tree reserved for the source */
+void bm_ryml_arena_reserve(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    const size_t num_nodes = ryml::parse_in_arena(s_bm_case->filename, src).size();
+    measure(st, nop, [&]{
+        ryml::Parser parser;
+        ryml::Tree tree(num_nodes, src.len);
+        parser.parse_in_arena(s_bm_case->filename, src, &tree);
+    });
+}
+
+void bm_ryml_emit_str(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    measure(st, nop, [&]{
+        std::string str = ryml::emitrs<std::string>(tree);
+        bm::DoNotOptimize(str.data());
+    });
+}
+
+void bm_ryml_emit_str_reuse(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+    std::string str;
+    measure(st, nop, [&]{
+        ryml::emitrs(tree, &str);
+        bm::DoNotOptimize(str.data());
+    });
+}
+
+/** parse a request and emit the response, as done by a server */
+void bm_ryml_roundtrip(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    measure(st, nop, [&]{
+        ryml::Tree tree = ryml::parse_in_arena(s_bm_case->filename, src);
+        std::string str = ryml::emitrs<std::string>(tree);
+        bm::DoNotOptimize(str.data());
+    });
+}
+
+void bm_ryml_roundtrip_reuse(bm::State& st)
+{
+    c4::csubstr src = c4::to_csubstr(s_bm_case->src);
+    std::string str;
+    measure(st, []{ s_bm_case->prepare(kClearTree|kClearTreeArena); }, [&]{
+        s_bm_case->ryml_parser.parse_in_arena(s_bm_case->filename, src, &s_bm_case->ryml_tree);
+        ryml::emitrs(s_bm_case->ryml_tree, &str);
+        bm::DoNotOptimize(str.data());
+    });
+}
+
+BENCHMARK(bm_ryml_inplace_reuse)->UseManualTime();
+BENCHMARK(bm_ryml_arena_reuse)->UseManualTime();
+BENCHMARK(bm_ryml_inplace)->UseManualTime();
+BENCHMARK(bm_ryml_arena)->UseManualTime();
+BENCHMARK(bm_ryml_arena_reserve)->UseManualTime();
+BENCHMARK(bm_ryml_emit_str)->UseManualTime();
+BENCHMARK(bm_ryml_emit_str_reuse)->UseManualTime();
+BENCHMARK(bm_ryml_roundtrip)->UseManualTime();
+BENCHMARK(bm_ryml_roundtrip_reuse)->UseManualTime();
@@ -0,0 +1,166 @@
+#ifndef C4_YML_BM_PERF_HPP_
+#define C4_YML_BM_PERF_HPP_
+
+/** hardware performance counters for the benchmarks, read with
+ * perf_event_open() (linux only). They are compiled only with
+ * RYML_BM_PERF_COUNTERS (see the cmake option RYML_BM_PERF); otherwise,
+ * or when the counters cannot be opened (eg because of
+ * /proc/sys/kernel/perf_event_paranoid), nothing is reported.
+ *
+ * Only the user space is counted. The counters are inherited by the
+ * threads created afterwards, and are scaled when the kernel multiplexes
+ * them. */
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(RYML_BM_PERF_COUNTERS) && defined(__linux__)
+#   include <linux/perf_event.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#   include <cerrno>
+#   include <cstring>
+#   define RYML_BM_HAVE_PERF_COUNTERS
+#endif
+
+
+struct BmPerfCounters
+{
+    typedef enum {
+        CYCLES,
+        INSTRUCTIONS,
+        BRANCHES,
+        BRANCH_MISSES,
+        L1D_MISSES,
+        LLC_MISSES,
+        NUM_COUNTERS
+    } Counter_e;
+
+    static const char* name(int i)
+    {
+        switch(i)
+        {
+        case CYCLES: return "cycles";
+        case INSTRUCTIONS: return "instructions";
+        case BRANCHES: return "branches";
+        case BRANCH_MISSES: return "branch_misses";
+        case L1D_MISSES: return "l1d_misses";
+        case LLC_MISSES: return "llc_misses";
+        default: return "unknown";
+        }
+    }
+
+    int      fds[NUM_COUNTERS];
+    uint64_t last[NUM_COUNTERS];
+
+    BmPerfCounters() : fds(), last()
+    {
+        for(int &fd : fds)
+            fd = -1;
+        #ifdef RYML_BM_HAVE_PERF_COUNTERS
+        for(int i = 0; i < NUM_COUNTERS; ++i)
+        {
+            fds[i] = _open(i);
+            if(fds[i] < 0)
+                fprintf(stderr, "warning: could not open the perf counter %s: %s\n", name(i), strerror(errno));
+        }
+        #endif
+        start();
+    }
+
+    ~BmPerfCounters()
+    {
+        #ifdef RYML_BM_HAVE_PERF_COUNTERS
+        for(int fd : fds)
+            if(fd >= 0)
+                close(fd);
+        #endif
+    }
+
+    BmPerfCounters(BmPerfCounters const&) = delete;
+    BmPerfCounters& operator= (BmPerfCounters const&) = delete;
+
+    bool has(int i) const { return fds[i] >= 0; }
+
+    /** start counting from now */
+    void start()
+    {
+        for(int i = 0; i < NUM_COUNTERS; ++i)
+            last[i] = _read(i);
+    }
+
+    /** publish the counts since the previous call (or since start())
+     * as counters per iteration, along with the instructions per cycle
+     * and the percentage of mispredicted branches; then start counting
+     * again */
+    void report(benchmark::State &st)
+    {
+        using C = benchmark::Counter;
+        uint64_t delta[NUM_COUNTERS] = {};
+        for(int i = 0; i < NUM_COUNTERS; ++i)
+        {
+            if(!has(i))
+                continue;
+            const uint64_t curr = _read(i);
+            delta[i] = curr - last[i];
+            st.counters[name(i)] = C(static_cast<double>(delta[i]), C::kAvgIterations);
+        }
+        if(has(CYCLES) && has(INSTRUCTIONS) && delta[CYCLES])
+            st.counters["ipc"] = static_cast<double>(delta[INSTRUCTIONS]) / static_cast<double>(delta[CYCLES]);
+        if(has(BRANCHES) && has(BRANCH_MISSES) && delta[BRANCHES])
+            st.counters["branch_miss_pct"] = 100. * static_cast<double>(delta[BRANCH_MISSES]) / static_cast<double>(delta[BRANCHES]);
+        start();
+    }
+
+private:
+
+    uint64_t _read(int i) const
+    {
+        #ifdef RYML_BM_HAVE_PERF_COUNTERS
+        if(fds[i] < 0)
+            return 0;
+        uint64_t vals[3] = {}; // value, time enabled, time running
+        if(read(fds[i], vals, sizeof(vals)) != (ssize_t)sizeof(vals))
+            return 0;
+        if(vals[2] && vals[2] < vals[1]) // multiplexed: scale up
+            return (uint64_t)(static_cast<double>(vals[0]) * static_cast<double>(vals[1]) / static_cast<double>(vals[2]));
+        return vals[0];
+        #else
+        (void)i;
+        return 0;
+        #endif
+    }
+
+    #ifdef RYML_BM_HAVE_PERF_COUNTERS
+    static int _open(int i)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        switch(i)
+        {
+        case CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case BRANCHES: attr.config = PERF_COUNT_HW_BRANCH_INSTRUCTIONS; break;
+        case BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case LLC_MISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        default: return -1;
+        }
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        return (int)syscall(__NR_perf_event_open, &attr, /*pid*/0, /*cpu*/-1, /*group_fd*/-1, /*flags*/0);
+    }
+    #endif
+};
+
+#endif /* C4_YML_BM_PERF_HPP_ */
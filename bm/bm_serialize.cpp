@@ -0,0 +1,425 @@
+#include "./bm_common.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+/** benchmarks of the serialization of user data to a tree, and of its
+ * deserialization back from the tree, through NodeRef (operator<<,
+ * operator>>, set_val_serialized(), fmt::base64()) and through the
+ * std adapters (std/vector.hpp, std/map.hpp, std/string.hpp). The
+ * same data is also converted to/from the DOMs of nlohmann::json and
+ * rapidjson, for comparison. These do not use case files: the data is
+ * generated for each size. The items processed are the elements
+ * written or read. */
+
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+uint64_t next_rnd(uint64_t *state)
+{
+    *state = *state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+    return *state >> 33;
+}
+
+template<class T> struct Data;
+
+template<> struct Data<int>
+{
+    static std::vector<int> make(size_t num)
+    {
+        std::vector<int> v(num);
+        uint64_t rnd = 1;
+        for(int &i : v)
+            i = (int)(next_rnd(&rnd) % 2000000u) - 1000000;
+        return v;
+    }
+};
+
+template<> struct Data<double>
+{
+    static std::vector<double> make(size_t num)
+    {
+        std::vector<double> v(num);
+        uint64_t rnd = 2;
+        for(double &d : v)
+            d = (double)(int64_t)(next_rnd(&rnd) % 2000000u - 1000000) / 1024.0;
+        return v;
+    }
+};
+
+template<> struct Data<std::string>
+{
+    static std::vector<std::string> make(size_t num)
+    {
+        std::vector<std::string> v(num);
+        uint64_t rnd = 3;
+        for(std::string &s : v)
+            s = "string_" + std::string(next_rnd(&rnd) % 24u, 'x') + std::to_string(next_rnd(&rnd));
+        return v;
+    }
+};
+
+std::map<std::string, int> make_map(size_t num)
+{
+    std::map<std::string, int> m;
+    const std::vector<int> vals = Data<int>::make(num);
+    for(size_t i = 0; i < num; ++i)
+        m["key_" + std::to_string(i)] = vals[i];
+    return m;
+}
+
+std::vector<char> make_blob(size_t num)
+{
+    std::vector<char> blob(num);
+    uint64_t rnd = 4;
+    for(char &c : blob)
+        c = (char)(next_rnd(&rnd) & 0xffu);
+    return blob;
+}
+
+void reset(ryml::Tree *t)
+{
+    t->clear();
+    t->clear_arena();
+}
+
+rapidjson::Value to_rapidjson(int v, rapidjson::Document::AllocatorType &) { return rapidjson::Value(v); }
+rapidjson::Value to_rapidjson(double v, rapidjson::Document::AllocatorType &) { return rapidjson::Value(v); }
+rapidjson::Value to_rapidjson(std::string const& v, rapidjson::Document::AllocatorType &a) { return rapidjson::Value(v.data(), (rapidjson::SizeType)v.size(), a); }
+
+void from_rapidjson(rapidjson::Value const& v, int *out) { *out = v.GetInt(); }
+void from_rapidjson(rapidjson::Value const& v, double *out) { *out = v.GetDouble(); }
+void from_rapidjson(rapidjson::Value const& v, std::string *out) { out->assign(v.GetString(), v.GetStringLength()); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+// vectors: element by element, with NodeRef::operator<< and operator>>
+
+template<class T>
+void bm_ryml_write_elements(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    ryml::Tree t;
+    for(auto _ : st)
+    {
+        reset(&t);
+        ryml::NodeRef root = t.rootref();
+        root |= ryml::SEQ;
+        for(T const& v : data)
+            root.append_child() << v;
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+template<class T>
+void bm_ryml_read_elements(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    ryml::Tree t;
+    t.rootref() << data;
+    std::vector<T> out(data.size());
+    for(auto _ : st)
+    {
+        size_t i = 0;
+        for(ryml::NodeRef const ch : t.rootref())
+            ch >> out[i++];
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+
+//-----------------------------------------------------------------------------
+// vectors: whole, with the std adapters (bulk for numbers)
+
+template<class T>
+void bm_ryml_write_vector(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    ryml::Tree t;
+    for(auto _ : st)
+    {
+        reset(&t);
+        t.rootref() << data;
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+template<class T>
+void bm_ryml_read_vector(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    ryml::Tree t;
+    t.rootref() << data;
+    std::vector<T> out;
+    for(auto _ : st)
+    {
+        t.rootref() >> out;
+        bm::DoNotOptimize(out.data());
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+template<class T>
+void bm_nlohmann_write_vector(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    for(auto _ : st)
+    {
+        nlohmann::json j = data;
+        bm::DoNotOptimize(j);
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+template<class T>
+void bm_nlohmann_read_vector(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    const nlohmann::json j = data;
+    std::vector<T> out;
+    for(auto _ : st)
+    {
+        j.get_to(out);
+        bm::DoNotOptimize(out.data());
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+template<class T>
+void bm_rapidjson_write_vector(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    for(auto _ : st)
+    {
+        rapidjson::Document doc;
+        auto &alloc = doc.GetAllocator();
+        doc.SetArray();
+        doc.Reserve((rapidjson::SizeType)data.size(), alloc);
+        for(T const& v : data)
+            doc.PushBack(to_rapidjson(v, alloc), alloc);
+        bm::DoNotOptimize(doc);
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+template<class T>
+void bm_rapidjson_read_vector(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    rapidjson::Document doc;
+    doc.SetArray();
+    for(T const& v : data)
+        doc.PushBack(to_rapidjson(v, doc.GetAllocator()), doc.GetAllocator());
+    std::vector<T> out;
+    for(auto _ : st)
+    {
+        out.resize(doc.Size());
+        size_t i = 0;
+        for(rapidjson::Value const& v : doc.GetArray())
+            from_rapidjson(v, &out[i++]);
+        bm::DoNotOptimize(out.data());
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+
+//-----------------------------------------------------------------------------
+// scalars, bypassing NodeRef: Tree::to_arena() + Tree::to_val()
+
+template<class T>
+void bm_ryml_write_tree_to_arena(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    ryml::Tree t;
+    for(auto _ : st)
+    {
+        reset(&t);
+        const size_t root = t.root_id();
+        t.to_seq(root);
+        for(T const& v : data)
+            t.to_val(t.append_child(root), t.to_arena(v));
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+template<class T>
+void bm_ryml_write_set_val_serialized(bm::State &st)
+{
+    const std::vector<T> data = Data<T>::make((size_t)st.range(0));
+    ryml::Tree t;
+    for(auto _ : st)
+    {
+        reset(&t);
+        ryml::NodeRef root = t.rootref();
+        root |= ryml::SEQ;
+        for(T const& v : data)
+            root.append_child().set_val_serialized(v);
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+
+//-----------------------------------------------------------------------------
+// maps
+
+void bm_ryml_write_map(bm::State &st)
+{
+    const std::map<std::string, int> data = make_map((size_t)st.range(0));
+    ryml::Tree t;
+    for(auto _ : st)
+    {
+        reset(&t);
+        t.rootref() << data;
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+void bm_ryml_read_map(bm::State &st)
+{
+    const std::map<std::string, int> data = make_map((size_t)st.range(0));
+    ryml::Tree t;
+    t.rootref() << data;
+    std::map<std::string, int> out;
+    for(auto _ : st)
+    {
+        out.clear();
+        t.rootref() >> out;
+        bm::DoNotOptimize(out.size());
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+void bm_nlohmann_write_map(bm::State &st)
+{
+    const std::map<std::string, int> data = make_map((size_t)st.range(0));
+    for(auto _ : st)
+    {
+        nlohmann::json j = data;
+        bm::DoNotOptimize(j);
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+void bm_nlohmann_read_map(bm::State &st)
+{
+    const std::map<std::string, int> data = make_map((size_t)st.range(0));
+    const nlohmann::json j = data;
+    std::map<std::string, int> out;
+    for(auto _ : st)
+    {
+        out.clear();
+        j.get_to(out);
+        bm::DoNotOptimize(out.size());
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+void bm_rapidjson_write_map(bm::State &st)
+{
+    const std::map<std::string, int> data = make_map((size_t)st.range(0));
+    for(auto _ : st)
+    {
+        rapidjson::Document doc;
+        auto &alloc = doc.GetAllocator();
+        doc.SetObject();
+        for(auto const& kv : data)
+            doc.AddMember(to_rapidjson(kv.first, alloc), rapidjson::Value(kv.second), alloc);
+        bm::DoNotOptimize(doc);
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+void bm_rapidjson_read_map(bm::State &st)
+{
+    const std::map<std::string, int> data = make_map((size_t)st.range(0));
+    rapidjson::Document doc;
+    doc.SetObject();
+    for(auto const& kv : data)
+        doc.AddMember(to_rapidjson(kv.first, doc.GetAllocator()), rapidjson::Value(kv.second), doc.GetAllocator());
+    std::map<std::string, int> out;
+    for(auto _ : st)
+    {
+        out.clear();
+        for(auto const& m : doc.GetObject())
+            out[std::string(m.name.GetString(), m.name.GetStringLength())] = m.value.GetInt();
+        bm::DoNotOptimize(out.size());
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)data.size());
+}
+
+
+//-----------------------------------------------------------------------------
+// base64 blobs; the items processed are bytes of the blob
+
+void bm_ryml_write_base64(bm::State &st)
+{
+    const std::vector<char> blob = make_blob((size_t)st.range(0));
+    const ryml::csubstr data(blob.data(), blob.size());
+    ryml::Tree t;
+    for(auto _ : st)
+    {
+        reset(&t);
+        t.rootref() << ryml::fmt::base64(data);
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)blob.size());
+    st.SetBytesProcessed(st.iterations() * (int64_t)blob.size());
+}
+
+void bm_ryml_read_base64(bm::State &st)
+{
+    const std::vector<char> blob = make_blob((size_t)st.range(0));
+    ryml::Tree t;
+    t.rootref() << ryml::fmt::base64(ryml::csubstr(blob.data(), blob.size()));
+    std::vector<char> out(blob.size());
+    ryml::substr buf(out.data(), out.size());
+    for(auto _ : st)
+    {
+        size_t len = t.rootref().deserialize_val(ryml::fmt::base64(buf));
+        bm::DoNotOptimize(len);
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)blob.size());
+    st.SetBytesProcessed(st.iterations() * (int64_t)blob.size());
+}
+
+
+//-----------------------------------------------------------------------------
+
+#define RYML_BM_SIZES RangeMultiplier(16)->Range(16, 1 << 20)
+#define RYML_BM_SERIALIZE(T)                                           \
+    BENCHMARK_TEMPLATE(bm_ryml_write_elements, T)->RYML_BM_SIZES;       \
+    BENCHMARK_TEMPLATE(bm_ryml_write_set_val_serialized, T)->RYML_BM_SIZES; \
+    BENCHMARK_TEMPLATE(bm_ryml_write_tree_to_arena, T)->RYML_BM_SIZES;  \
+    BENCHMARK_TEMPLATE(bm_ryml_write_vector, T)->RYML_BM_SIZES;         \
+    BENCHMARK_TEMPLATE(bm_nlohmann_write_vector, T)->RYML_BM_SIZES;     \
+    BENCHMARK_TEMPLATE(bm_rapidjson_write_vector, T)->RYML_BM_SIZES;    \
+    BENCHMARK_TEMPLATE(bm_ryml_read_elements, T)->RYML_BM_SIZES;        \
+    BENCHMARK_TEMPLATE(bm_ryml_read_vector, T)->RYML_BM_SIZES;          \
+    BENCHMARK_TEMPLATE(bm_nlohmann_read_vector, T)->RYML_BM_SIZES;      \
+    BENCHMARK_TEMPLATE(bm_rapidjson_read_vector, T)->RYML_BM_SIZES
+
+RYML_BM_SERIALIZE(int);
+RYML_BM_SERIALIZE(double);
+RYML_BM_SERIALIZE(std::string);
+
+BENCHMARK(bm_ryml_write_map)->RYML_BM_SIZES;
+BENCHMARK(bm_nlohmann_write_map)->RYML_BM_SIZES;
+BENCHMARK(bm_rapidjson_write_map)->RYML_BM_SIZES;
+BENCHMARK(bm_ryml_read_map)->RYML_BM_SIZES;
+BENCHMARK(bm_nlohmann_read_map)->RYML_BM_SIZES;
+BENCHMARK(bm_rapidjson_read_map)->RYML_BM_SIZES;
+
+BENCHMARK(bm_ryml_write_base64)->RYML_BM_SIZES;
+BENCHMARK(bm_ryml_read_base64)->RYML_BM_SIZES;
+
+
+int main(int argc, char** argv)
+{
+    bm::Initialize(&argc, argv);
+    bm::RunSpecifiedBenchmarks();
+}
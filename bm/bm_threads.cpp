@@ -0,0 +1,256 @@
+#include <ryml.hpp>
+#include <ryml_std.hpp>
+#include <c4/fs/fs.hpp>
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bm = benchmark;
+
+
+/** throughput of concurrent parsing and emitting: N threads work on the
+ * same source, each with its own parser, trees and buffers, as is done
+ * by a server where each request handler owns its ryml objects. N
+ * sweeps from 1 to the number of hardware threads.
+ *
+ * Each thread processes the whole source per iteration, so the bytes
+ * per second are the aggregate of all the threads. The counters are:
+ *   - thread_MBps: the mean throughput of each thread
+ *   - efficiency: thread_MBps divided by the throughput with a single
+ *     thread; 1 means perfect scaling
+ *
+ * The variants differ in where the memory comes from:
+ *   - reuse: the parser and tree of each thread are reused across
+ *     iterations, so there are (nearly) no allocations once warmed up
+ *   - fresh_global: each iteration creates its parser and tree, which
+ *     use the global callbacks (get_callbacks()) and thus the default
+ *     allocator, shared by all threads
+ *   - fresh_local: as fresh_global, but the parser and tree use
+ *     callbacks allocating from a per-thread arena, so the difference
+ *     to fresh_global is the cost of sharing the allocator
+ *
+ * The global callbacks are set only before the benchmarks run, as
+ * set_callbacks() must not race with the threads using them. */
+
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+std::string s_src;
+std::string s_filename;
+
+/** a monotonic arena owned by a thread: its deallocations are no-ops,
+ * and it is rewound at each iteration once its objects are gone. When
+ * an iteration does not fit, the excess goes to the heap, and the arena
+ * grows on the next rewind. */
+struct ThreadArena
+{
+    std::vector<char> buf;
+    size_t pos = 0;
+    size_t needed = 0;
+    size_t num_overflows = 0;
+
+    explicit ThreadArena(size_t cap) : buf(cap) {}
+
+    void rewind()
+    {
+        if(needed > buf.size())
+            buf.resize(needed + needed / 4u);
+        pos = 0;
+        needed = 0;
+    }
+
+    bool owns(void *mem) const
+    {
+        return mem >= (void const*)buf.data() && mem < (void const*)(buf.data() + buf.size());
+    }
+
+    static void* allocate(size_t len, void * /*hint*/, void *user_data)
+    {
+        ThreadArena *a = static_cast<ThreadArena*>(user_data);
+        const size_t start = (a->pos + 15u) & ~size_t(15u);
+        a->needed = ((a->needed + 15u) & ~size_t(15u)) + len;
+        if(start + len <= a->buf.size())
+        {
+            a->pos = start + len;
+            return a->buf.data() + start;
+        }
+        ++a->num_overflows;
+        void *mem = ::malloc(len);
+        if(mem == nullptr)
+        {
+            fprintf(stderr, "out of memory: %zu bytes\n", len);
+            std::abort();
+        }
+        return mem;
+    }
+
+    static void free(void *mem, size_t /*len*/, void *user_data)
+    {
+        ThreadArena *a = static_cast<ThreadArena*>(user_data);
+        if(!a->owns(mem))
+            ::free(mem);
+    }
+
+    static void error(const char *msg, size_t len, ryml::Location /*loc*/, void * /*user_data*/)
+    {
+        fprintf(stderr, "%.*s\n", (int)len, msg);
+        std::abort();
+    }
+
+    ryml::Callbacks callbacks()
+    {
+        return ryml::Callbacks(this, &ThreadArena::allocate, &ThreadArena::free, &ThreadArena::error);
+    }
+};
+
+
+typedef enum {
+    PARSE_REUSE,
+    PARSE_FRESH_GLOBAL,
+    PARSE_FRESH_LOCAL,
+    EMIT_REUSE,
+    PARSE_EMIT_FRESH_GLOBAL,
+    PARSE_EMIT_FRESH_LOCAL,
+    NUM_VARIANTS
+} Variant_e;
+
+const char *const s_variant_names[NUM_VARIANTS] = {
+    "parse_reuse",
+    "parse_fresh_global",
+    "parse_fresh_local",
+    "emit_reuse",
+    "parse_emit_fresh_global",
+    "parse_emit_fresh_local",
+};
+
+/** the throughput of each variant with a single thread, in MB/s. These
+ * are written only by the single-thread run, which the sweep does
+ * first, so that the runs with more threads only read them. */
+double s_single_thread_MBps[NUM_VARIANTS] = {};
+
+
+/** run the loop of one thread of the given variant */
+void run_variant(bm::State &st, Variant_e variant)
+{
+    const ryml::csubstr src = ryml::to_csubstr(s_src);
+    const ryml::csubstr filename = ryml::to_csubstr(s_filename);
+    // objects owned by this thread
+    ThreadArena arena(4u * src.len + (1u << 20u));
+    ryml::Parser parser;
+    ryml::Tree tree;
+    std::string out;
+    if(variant == PARSE_REUSE || variant == EMIT_REUSE)
+    {
+        parser.parse_in_arena(filename, src, &tree); // warm up the capacities
+        if(variant == EMIT_REUSE)
+            ryml::emitrs(tree, &out);
+    }
+    size_t num_nodes = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for(auto _ : st)
+    {
+        switch(variant)
+        {
+        case PARSE_REUSE:
+            tree.clear();
+            tree.clear_arena();
+            parser.parse_in_arena(filename, src, &tree);
+            num_nodes = tree.size();
+            break;
+        case PARSE_FRESH_GLOBAL:
+        {
+            ryml::Tree t = ryml::parse_in_arena(filename, src);
+            num_nodes = t.size();
+            break;
+        }
+        case PARSE_FRESH_LOCAL:
+        {
+            {
+                ryml::Parser p(arena.callbacks());
+                ryml::Tree t = p.parse_in_arena(filename, src);
+                num_nodes = t.size();
+            }
+            arena.rewind();
+            break;
+        }
+        case EMIT_REUSE:
+            ryml::emitrs(tree, &out);
+            bm::DoNotOptimize(out.data());
+            break;
+        case PARSE_EMIT_FRESH_GLOBAL:
+        {
+            ryml::Tree t = ryml::parse_in_arena(filename, src);
+            std::string s = ryml::emitrs<std::string>(t);
+            bm::DoNotOptimize(s.data());
+            break;
+        }
+        case PARSE_EMIT_FRESH_LOCAL:
+        {
+            {
+                ryml::Parser p(arena.callbacks());
+                ryml::Tree t = p.parse_in_arena(filename, src);
+                ryml::emitrs(t, &out);
+                bm::DoNotOptimize(out.data());
+            }
+            arena.rewind();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    bm::DoNotOptimize(num_nodes);
+    // this thread's share of the aggregate counts
+    st.SetItemsProcessed(st.iterations());
+    st.SetBytesProcessed(st.iterations() * (int64_t)src.len);
+    const double secs = std::chrono::duration<double>(t1 - t0).count();
+    const double thread_MBps = secs > 0. ? ((double)st.iterations() * (double)src.len / secs) / double(1u << 20u) : 0.;
+    if(st.threads() == 1)
+        s_single_thread_MBps[variant] = thread_MBps;
+    using C = bm::Counter;
+    st.counters["thread_MBps"] = C(thread_MBps, C::kAvgThreads);
+    if(s_single_thread_MBps[variant] > 0.)
+        st.counters["efficiency"] = C(thread_MBps / s_single_thread_MBps[variant], C::kAvgThreads);
+    if(arena.num_overflows)
+        st.counters["arena_overflows"] = C((double)arena.num_overflows, C::kAvgThreads); // while the arena is warming up
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    bm::Initialize(&argc, argv);
+    if(argc < 2)
+    {
+        std::cout << R"(
+USAGE: bm <case.yml>
+)";
+        std::exit(1);
+    }
+    s_filename = argv[1];
+    c4::fs::file_get_contents(argv[1], &s_src);
+    std::cout << "-----------------------------------\n";
+    std::cout << "running case: THREADS/" << c4::to_csubstr(s_filename).basename() << "\n";
+    std::cout << "file: " << s_filename << "\n";
+    std::cout << "-----------------------------------\n";
+    int max_threads = (int)std::thread::hardware_concurrency();
+    if(max_threads < 1)
+        max_threads = 1;
+    for(int v = 0; v < NUM_VARIANTS; ++v)
+    {
+        bm::RegisterBenchmark(s_variant_names[v], [v](bm::State &st){ run_variant(st, (Variant_e)v); })
+            ->ThreadRange(1, max_threads)
+            ->UseRealTime();
+    }
+    bm::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,429 @@
+#include <ryml.hpp>
+#include <ryml_std.hpp>
+#include <c4/yml/alloc_stats.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace bm = benchmark;
+
+
+/** benchmarks of the tree operations, on synthetic trees from 1e2 to
+ * 1e7 nodes. The trees are a map of maps:
+ *
+ * @code
+ * k0: {a0: 0, a1: 1, ..., a8: 8}
+ * k1: {a0: 0, a1: 1, ..., a8: 8}
+ * ...
+ * @endcode
+ *
+ * so the root has one tenth of the nodes as children. The items
+ * processed are nodes (or operations, where it is noted), and the
+ * counters alloc_bytes and alloc_count are the memory and the number
+ * of allocations done through the ryml callbacks by each iteration. */
+
+
+//-----------------------------------------------------------------------------
+
+/** counts the allocations; set in main(), once the callbacks can be
+ * wrapped */
+static ryml::AllocStats *s_alloc = nullptr;
+
+void* bm_allocate(size_t len, void * /*hint*/, void * /*user_data*/)
+{
+    void *mem = ::malloc(len);
+    if(mem == nullptr)
+    {
+        fprintf(stderr, "out of memory: %zu bytes\n", len);
+        std::abort();
+    }
+    return mem;
+}
+
+void bm_free(void *mem, size_t /*len*/, void * /*user_data*/)
+{
+    ::free(mem);
+}
+
+void bm_error(const char *msg, size_t len, ryml::Location /*loc*/, void * /*user_data*/)
+{
+    fprintf(stderr, "%.*s\n", (int)len, msg);
+    std::abort();
+}
+
+/** count the allocations done while the object is alive, and publish
+ * them as counters. The allocations done between pause() and resume()
+ * are not counted. */
+struct AllocScope
+{
+    bm::State &st;
+    size_t untracked_bytes;
+    size_t untracked_count;
+    ryml::AllocCounts paused;
+    AllocScope(bm::State &st_) : st(st_), untracked_bytes(0), untracked_count(0), paused() { s_alloc->reset(); }
+    ~AllocScope()
+    {
+        ryml::AllocCounts const& c = s_alloc->total();
+        st.counters["alloc_bytes"] = bm::Counter(static_cast<double>(c.bytes_total - untracked_bytes), bm::Counter::kAvgIterations);
+        st.counters["alloc_count"] = bm::Counter(static_cast<double>(c.num_allocs - untracked_count), bm::Counter::kAvgIterations);
+        st.counters["alloc_peak"] = bm::Counter(static_cast<double>(c.bytes_peak));
+    }
+    void pause() { paused = s_alloc->total(); }
+    void resume()
+    {
+        ryml::AllocCounts const& c = s_alloc->total();
+        untracked_bytes += c.bytes_total - paused.bytes_total;
+        untracked_count += c.num_allocs - paused.num_allocs;
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+
+constexpr size_t num_members = 9;
+const ryml::csubstr s_members[num_members] = {"a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "a8"};
+
+ryml::csubstr to_key(char (&buf)[32], size_t i)
+{
+    return ryml::csubstr(buf, (size_t)snprintf(buf, sizeof(buf), "k%zu", i));
+}
+
+ryml::csubstr to_ref(char (&buf)[32], size_t i)
+{
+    return ryml::csubstr(buf, (size_t)snprintf(buf, sizeof(buf), "*k%zu", i));
+}
+
+/** append the map k<i> to the root */
+size_t add_entry(ryml::Tree *t, size_t i)
+{
+    char buf[32];
+    const size_t root = t->root_id();
+    const size_t entry = t->append_child(root);
+    t->to_map(entry, t->copy_to_arena(to_key(buf, i)));
+    for(size_t m = 0; m < num_members; ++m)
+        t->to_keyval(t->append_child(entry), s_members[m], t->to_arena(m));
+    return entry;
+}
+
+size_t num_entries(size_t num_nodes)
+{
+    return num_nodes >= 2 * (num_members + 1) ? num_nodes / (num_members + 1) : 1u;
+}
+
+void build_tree(ryml::Tree *t, size_t num_nodes)
+{
+    const size_t num = num_entries(num_nodes);
+    t->clear();
+    t->clear_arena();
+    t->reserve(num * (num_members + 1) + 1);
+    t->to_map(t->root_id());
+    for(size_t i = 0; i < num; ++i)
+        add_entry(t, i);
+}
+
+/** a tree whose entries are anchored, and referred to from later
+ * entries with aliases and merge keys */
+void build_tree_with_refs(ryml::Tree *t, size_t num_nodes)
+{
+    build_tree(t, num_nodes);
+    char buf[32];
+    const size_t root = t->root_id();
+    size_t i = 0;
+    uint64_t rnd = 1;
+    for(size_t entry = t->first_child(root); entry != ryml::NONE; entry = t->next_sibling(entry), ++i)
+    {
+        if(i % 4 == 0)
+        {
+            t->set_val_anchor(entry, t->key(entry));
+        }
+        else
+        {
+            // refer to a random earlier anchor
+            rnd = rnd * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+            const size_t target = (size_t)((rnd >> 33) % (i / 4 + 1)) * 4;
+            const ryml::csubstr ref = t->copy_to_arena(to_ref(buf, target));
+            t->set_val_ref(t->first_child(entry), ref);
+            if(i % 4 == 1)
+            {
+                const size_t merge = t->prepend_child(entry);
+                t->to_keyval(merge, "<<", ref);
+                t->set_key_ref(merge, "<<");
+                t->set_val_ref(merge, ref);
+            }
+        }
+    }
+}
+
+/** random picks, in [0,num) */
+std::vector<size_t> make_picks(size_t num)
+{
+    std::vector<size_t> picks(1024);
+    uint64_t rnd = 7;
+    for(size_t &p : picks)
+    {
+        rnd = rnd * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+        p = (size_t)((rnd >> 33) % num);
+    }
+    return picks;
+}
+
+
+//-----------------------------------------------------------------------------
+
+void bm_build(bm::State &st)
+{
+    const size_t num_nodes = (size_t)st.range(0);
+    size_t size = 0;
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            ryml::Tree t;
+            build_tree(&t, num_nodes);
+            size = t.size();
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)size);
+}
+
+void bm_find_child(bm::State &st)
+{
+    ryml::Tree t;
+    build_tree(&t, (size_t)st.range(0));
+    const size_t num = num_entries((size_t)st.range(0));
+    std::vector<std::string> keys;
+    for(size_t p : make_picks(num))
+        keys.emplace_back("k" + std::to_string(p));
+    const size_t root = t.root_id();
+    size_t i = 0;
+    for(auto _ : st)
+    {
+        size_t id = t.find_child(root, ryml::to_csubstr(keys[i++ & 1023u]));
+        bm::DoNotOptimize(id);
+    }
+    // items: lookups
+    st.SetItemsProcessed(st.iterations());
+}
+
+void bm_child_pos(bm::State &st)
+{
+    ryml::Tree t;
+    build_tree(&t, (size_t)st.range(0));
+    const std::vector<size_t> picks = make_picks(num_entries((size_t)st.range(0)));
+    const size_t root = t.root_id();
+    size_t i = 0;
+    for(auto _ : st)
+    {
+        size_t id = t.child(root, picks[i++ & 1023u]);
+        bm::DoNotOptimize(id);
+    }
+    // items: lookups
+    st.SetItemsProcessed(st.iterations());
+}
+
+void bm_num_children(bm::State &st)
+{
+    ryml::Tree t;
+    build_tree(&t, (size_t)st.range(0));
+    size_t id = t.root_id();
+    for(auto _ : st)
+    {
+        bm::DoNotOptimize(id);
+        size_t num = t.num_children(id);
+        bm::DoNotOptimize(num);
+    }
+    // items: calls
+    st.SetItemsProcessed(st.iterations());
+}
+
+void bm_lookup_path(bm::State &st)
+{
+    ryml::Tree t;
+    build_tree(&t, (size_t)st.range(0));
+    const size_t num = num_entries((size_t)st.range(0));
+    std::vector<std::string> paths;
+    for(size_t p : make_picks(num))
+        paths.emplace_back("k" + std::to_string(p) + ".a" + std::to_string(p % num_members));
+    size_t i = 0;
+    for(auto _ : st)
+    {
+        ryml::Tree::lookup_result r = t.lookup_path(ryml::to_csubstr(paths[i++ & 1023u]));
+        bm::DoNotOptimize(r.target);
+    }
+    // items: lookups
+    st.SetItemsProcessed(st.iterations());
+}
+
+void bm_duplicate(bm::State &st)
+{
+    ryml::Tree src;
+    build_tree(&src, (size_t)st.range(0));
+    ryml::Tree dst;
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            dst.clear();
+            dst.to_map(dst.root_id());
+            dst.duplicate_children(&src, src.root_id(), dst.root_id(), ryml::NONE);
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)src.size());
+}
+
+void bm_merge_with(bm::State &st)
+{
+    ryml::Tree src;
+    build_tree(&src, (size_t)st.range(0));
+    ryml::Tree dst;
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            dst.clear();
+            dst.clear_arena();
+            dst.merge_with(&src);
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)src.size());
+}
+
+void bm_resolve(bm::State &st)
+{
+    ryml::Tree orig;
+    build_tree_with_refs(&orig, (size_t)st.range(0));
+    ryml::Tree t;
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            st.PauseTiming();
+            as.pause();
+            t = orig;
+            as.resume();
+            st.ResumeTiming();
+            t.resolve();
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)orig.size());
+}
+
+void bm_reorder(bm::State &st)
+{
+    ryml::Tree orig;
+    build_tree(&orig, (size_t)st.range(0));
+    // shuffle the node buffer: move every other entry to the end
+    {
+        const size_t root = orig.root_id();
+        size_t entry = orig.first_child(root);
+        const size_t last = orig.last_child(root);
+        while(entry != ryml::NONE && entry != last)
+        {
+            const size_t next = orig.next_sibling(entry);
+            orig.move(entry, orig.last_child(root));
+            entry = next != ryml::NONE ? orig.next_sibling(next) : ryml::NONE;
+        }
+    }
+    ryml::Tree t;
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            st.PauseTiming();
+            as.pause();
+            t = orig;
+            as.resume();
+            st.ResumeTiming();
+            t.reorder();
+        }
+    }
+    st.SetItemsProcessed(st.iterations() * (int64_t)orig.size());
+}
+
+void bm_remove_append_churn(bm::State &st)
+{
+    ryml::Tree t;
+    build_tree(&t, (size_t)st.range(0));
+    const size_t root = t.root_id();
+    size_t i = num_entries((size_t)st.range(0));
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            t.remove(t.first_child(root));
+            add_entry(&t, i++);
+        }
+    }
+    // items: removed+appended entries
+    st.SetItemsProcessed(st.iterations());
+}
+
+void bm_arena_to_arena(bm::State &st)
+{
+    const size_t num = (size_t)st.range(0);
+    size_t arena_size = 0;
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            ryml::Tree t(0, 0);
+            for(size_t i = 0; i < num; ++i)
+            {
+                ryml::csubstr s = t.to_arena(i);
+                bm::DoNotOptimize(s.str);
+            }
+            arena_size = t.arena_size();
+        }
+    }
+    // items: serialized integers
+    st.SetItemsProcessed(st.iterations() * (int64_t)num);
+    st.SetBytesProcessed(st.iterations() * (int64_t)arena_size);
+}
+
+void bm_arena_copy_to_arena(bm::State &st)
+{
+    const size_t num = (size_t)st.range(0);
+    const ryml::csubstr s = "a scalar of some length";
+    {
+        AllocScope as(st);
+        for(auto _ : st)
+        {
+            ryml::Tree t(0, 0);
+            for(size_t i = 0; i < num; ++i)
+            {
+                ryml::substr cp = t.copy_to_arena(s);
+                bm::DoNotOptimize(cp.str);
+            }
+        }
+    }
+    // items: copied strings
+    st.SetItemsProcessed(st.iterations() * (int64_t)num);
+    st.SetBytesProcessed(st.iterations() * (int64_t)(num * s.len));
+}
+
+#define RYML_BM_TREE_SIZES RangeMultiplier(10)->Range(100, 10000000)
+BENCHMARK(bm_build)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_find_child)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_child_pos)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_num_children)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_lookup_path)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_duplicate)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_merge_with)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_resolve)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_reorder)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_remove_append_churn)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_arena_to_arena)->RYML_BM_TREE_SIZES;
+BENCHMARK(bm_arena_copy_to_arena)->RYML_BM_TREE_SIZES;
+
+
+int main(int argc, char** argv)
+{
+    ryml::AllocStats stats(ryml::Callbacks(nullptr, &bm_allocate, &bm_free, &bm_error));
+    s_alloc = &stats;
+    ryml::set_callbacks(stats.callbacks());
+    bm::Initialize(&argc, argv);
+    bm::RunSpecifiedBenchmarks();
+}
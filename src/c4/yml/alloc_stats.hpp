@@ -0,0 +1,167 @@
+#ifndef _C4_YML_ALLOC_STATS_HPP_
+#define _C4_YML_ALLOC_STATS_HPP_
+
+/** @file alloc_stats.hpp Instrumented callbacks, counting the
+ * allocations done by ryml. This header is not included by ryml.hpp.
+ *
+ * @code
+ * ryml::AllocStats stats; // wraps the current global callbacks
+ * ryml::Tree tree(stats.callbacks());
+ * ryml::parse_in_arena(src, &tree);
+ * printf("peak=%zu nodes=%zu arena=%zu\n",
+ *        stats.total().bytes_peak,
+ *        stats.site(ryml::ALLOC_SITE_TREE_NODES).bytes_total,
+ *        stats.site(ryml::ALLOC_SITE_TREE_ARENA).bytes_total);
+ * @endcode
+ *
+ * @warning the counters are not atomic, so callbacks from a single
+ * AllocStats must not be used concurrently from several threads. */
+
+#ifndef _C4_YML_COMMON_HPP_
+#include "./common.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+/** the allocation counts of a site (or of all sites) */
+struct AllocCounts
+{
+    size_t num_allocs;  ///< the number of allocations
+    size_t num_frees;   ///< the number of deallocations
+    size_t bytes_total; ///< the sum of the bytes of all the allocations
+    size_t bytes_live;  ///< the bytes currently allocated
+    size_t bytes_peak;  ///< the maximum of bytes_live
+
+    void add(size_t len)
+    {
+        ++num_allocs;
+        bytes_total += len;
+        bytes_live += len;
+        if(bytes_live > bytes_peak)
+            bytes_peak = bytes_live;
+    }
+    void rem(size_t len)
+    {
+        ++num_frees;
+        bytes_live = len < bytes_live ? bytes_live - len : 0u;
+    }
+    /** zero the counts, except for the live bytes, which are still
+     * allocated */
+    void reset()
+    {
+        num_allocs = 0;
+        num_frees = 0;
+        bytes_total = 0;
+        bytes_peak = bytes_live;
+    }
+};
+
+
+/** callbacks which count the allocations and deallocations, both in
+ * total and per site (see AllocSite_e), and forward them to other
+ * callbacks. The object must outlive the trees and parsers using its
+ * callbacks, and it cannot be copied, as its callbacks refer to it. */
+class AllocStats
+{
+public:
+
+    /** wrap the current global callbacks */
+    AllocStats() : AllocStats(get_callbacks()) {}
+    /** wrap the given callbacks */
+    explicit AllocStats(Callbacks const& wrapped) : m_wrapped(wrapped), m_total(), m_sites() {}
+
+    AllocStats(AllocStats const&) = delete;
+    AllocStats& operator= (AllocStats const&) = delete;
+
+public:
+
+    /** the callbacks counting into this object, to give to trees and
+     * parsers, or to set_callbacks() */
+    Callbacks callbacks() const
+    {
+        return Callbacks(const_cast<AllocStats*>(this), &AllocStats::_allocate, &AllocStats::_free, &AllocStats::_error);
+    }
+
+    /** the callbacks which are wrapped */
+    Callbacks const& wrapped() const { return m_wrapped; }
+
+    AllocCounts const& total() const { return m_total; }
+    AllocCounts const& site(AllocSite_e s) const { RYML_ASSERT((size_t)s < (size_t)ALLOC_NUM_SITES); return m_sites[s]; }
+
+    /** zero the counts, but not the live bytes. The peak restarts from
+     * the live bytes. */
+    void reset()
+    {
+        m_total.reset();
+        for(AllocCounts &c : m_sites)
+            c.reset();
+    }
+
+    /** zero everything, including the live bytes */
+    void reset_all()
+    {
+        m_total = {};
+        for(AllocCounts &c : m_sites)
+            c = {};
+    }
+
+    /** a short name for the site, usable as an identifier */
+    static const char* site_name(AllocSite_e s)
+    {
+        switch(s)
+        {
+        case ALLOC_SITE_OTHER: return "other";
+        case ALLOC_SITE_TREE_NODES: return "tree_nodes";
+        case ALLOC_SITE_TREE_ARENA: return "tree_arena";
+        case ALLOC_SITE_TREE_SPANS: return "tree_spans";
+        case ALLOC_SITE_STACK: return "stack";
+        case ALLOC_SITE_FILTER_ARENA: return "filter_arena";
+        case ALLOC_SITE_LOCATIONS: return "locations";
+        case ALLOC_SITE_WRITER_STAGE: return "writer_stage";
+        default: return "unknown";
+        }
+    }
+
+private:
+
+    static void* _allocate(size_t len, void *hint, void *user_data)
+    {
+        AllocStats *self = static_cast<AllocStats*>(user_data);
+        void *mem = self->m_wrapped.m_allocate(len, hint, self->m_wrapped.m_user_data);
+        self->m_total.add(len);
+        self->m_sites[_site()].add(len);
+        return mem;
+    }
+
+    static void _free(void *mem, size_t len, void *user_data)
+    {
+        AllocStats *self = static_cast<AllocStats*>(user_data);
+        self->m_wrapped.m_free(mem, len, self->m_wrapped.m_user_data);
+        self->m_total.rem(len);
+        self->m_sites[_site()].rem(len);
+    }
+
+    static void _error(const char *msg, size_t len, Location loc, void *user_data)
+    {
+        AllocStats *self = static_cast<AllocStats*>(user_data);
+        self->m_wrapped.m_error(msg, len, loc, self->m_wrapped.m_user_data);
+    }
+
+    static size_t _site()
+    {
+        const AllocSite_e s = detail::get_alloc_site();
+        return (size_t)s < (size_t)ALLOC_NUM_SITES ? (size_t)s : (size_t)ALLOC_SITE_OTHER;
+    }
+
+private:
+
+    Callbacks   m_wrapped;
+    AllocCounts m_total;
+    AllocCounts m_sites[ALLOC_NUM_SITES];
+};
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_ALLOC_STATS_HPP_ */
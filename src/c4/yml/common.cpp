@@ -10,6 +10,7 @@ namespace yml {
 
 namespace {
 Callbacks s_default_callbacks;
+thread_local AllocSite_e s_alloc_site = ALLOC_SITE_OTHER;
 } // anon namespace
 
 #ifndef RYML_NO_DEFAULT_CALLBACKS
@@ -105,6 +106,17 @@ void reset_callbacks()
     set_callbacks(Callbacks());
 }
 
+namespace detail {
+void set_alloc_site(AllocSite_e site) noexcept
+{
+    s_alloc_site = site;
+}
+AllocSite_e get_alloc_site() noexcept
+{
+    return s_alloc_site;
+}
+} // namespace detail
+
 void error(const char *msg, size_t msg_len, Location loc)
 {
     s_default_callbacks.m_error(msg, msg_len, loc, s_default_callbacks.m_user_data);
@@ -158,6 +158,31 @@ struct RYML_EXPORT Callbacks
     }
 };
 
+/** the parts of ryml which allocate memory through the callbacks.
+ * While an allocation or deallocation is in progress, its site can be
+ * obtained from the callbacks with detail::get_alloc_site(); this is
+ * used by the instrumentation in AllocStats (see alloc_stats.hpp). */
+typedef enum {
+    ALLOC_SITE_OTHER = 0,    ///< anything else, eg allocations done by the user through the callbacks
+    ALLOC_SITE_TREE_NODES,   ///< Tree: the node buffer
+    ALLOC_SITE_TREE_ARENA,   ///< Tree: the string arena
+    ALLOC_SITE_TREE_SPANS,   ///< Tree: the source spans (see Tree::enable_src_spans())
+    ALLOC_SITE_STACK,        ///< detail::stack: the parser state, and the references when resolving
+    ALLOC_SITE_FILTER_ARENA, ///< Parser: the arena for filtering scalars
+    ALLOC_SITE_LOCATIONS,    ///< Parser: the newline offsets, used to compute locations
+    ALLOC_SITE_WRITER_STAGE, ///< the writers: the staging buffer of WriterFile, WriterOStream and WriterFd when none is given, and the copied scalars of WriterIovec
+    ALLOC_NUM_SITES
+} AllocSite_e;
+
+namespace detail {
+/** set the site of the allocations and deallocations which follow
+ * in the current thread */
+RYML_EXPORT void set_alloc_site(AllocSite_e site) noexcept;
+/** get the site of the allocation or deallocation in progress in the
+ * current thread */
+RYML_EXPORT AllocSite_e get_alloc_site() noexcept;
+} // namespace detail
+
 /// get the global callbacks
 RYML_EXPORT Callbacks const& get_callbacks();
 /// set the global callbacks
@@ -195,6 +220,28 @@ do                                                                      \
         (cb).m_free((buf), (num) * sizeof(T), (cb).m_user_data);    \
         (buf) = nullptr;                                            \
     } while(0)
+// these also make the site known to the callbacks
+#define _RYML_CB_ALLOC_SITE(cb, T, num, hint, site) (T*) c4::yml::detail::alloc_at((cb), (num) * sizeof(T), (hint), (site))
+#define _RYML_CB_FREE_SITE(cb, buf, T, num, site)                   \
+    do {                                                            \
+        c4::yml::detail::free_at((cb), (buf), (num) * sizeof(T), (site)); \
+        (buf) = nullptr;                                            \
+    } while(0)
+namespace detail {
+inline void* alloc_at(Callbacks const& cb, size_t len, void *hint, AllocSite_e site)
+{
+    set_alloc_site(site);
+    void *mem = cb.m_allocate(len, hint, cb.m_user_data);
+    set_alloc_site(ALLOC_SITE_OTHER);
+    return mem;
+}
+inline void free_at(Callbacks const& cb, void *mem, size_t len, AllocSite_e site)
+{
+    set_alloc_site(site);
+    cb.m_free(mem, len, cb.m_user_data);
+    set_alloc_site(ALLOC_SITE_OTHER);
+}
+} // namespace detail
 /// @endcond
 
 } // namespace yml
@@ -0,0 +1,566 @@
+#ifndef _C4_YML_DETAIL_FPCONV_HPP_
+#define _C4_YML_DETAIL_FPCONV_HPP_
+
+/** @file fpconv.hpp Conversion of floating point values to and from
+ * text, used by to_chars_float() and from_chars_float().
+ *
+ * Formatting produces the shortest decimal representation which
+ * reads back to the same value (Grisu2, see Florian Loitsch,
+ * "Printing Floating-Point Numbers Quickly and Accurately with
+ * Integers", PLDI 2010). The digit layout follows the one from
+ * printf("%g"), so that common values such as 0.124 or 1e+22 are
+ * printed as before, but without the precision loss of a fixed
+ * number of significant digits.
+ *
+ * Parsing uses a fast path for the overwhelmingly common case of
+ * short decimal numbers which can be converted exactly (Clinger's
+ * algorithm). Everything else is delegated to c4core's from_chars(),
+ * which in turn uses fast_float (Eisel-Lemire). */
+
+#ifndef _C4_YML_COMMON_HPP_
+#include "../common.hpp"
+#endif
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <string.h>
+
+
+namespace c4 {
+namespace yml {
+namespace detail {
+
+/** the maximum number of characters needed to format a float or
+ * double with format_float_shortest(). eg -1.2345678901234567e-308 */
+enum : size_t { fpconv_max_chars = 25 };
+
+
+//-----------------------------------------------------------------------------
+
+/** a "do-it-yourself" floating point number: f * 2^e */
+struct fpconv_diyfp
+{
+    uint64_t f;
+    int e;
+};
+
+inline fpconv_diyfp fpconv_sub(fpconv_diyfp x, fpconv_diyfp y) noexcept
+{
+    RYML_ASSERT(x.e == y.e);
+    RYML_ASSERT(x.f >= y.f);
+    return fpconv_diyfp{x.f - y.f, x.e};
+}
+
+/** multiply, keeping the rounded upper 64 bits of the product */
+inline fpconv_diyfp fpconv_mul(fpconv_diyfp x, fpconv_diyfp y) noexcept
+{
+    const uint64_t u_lo = x.f & 0xffffffffu;
+    const uint64_t u_hi = x.f >> 32u;
+    const uint64_t v_lo = y.f & 0xffffffffu;
+    const uint64_t v_hi = y.f >> 32u;
+    const uint64_t p0 = u_lo * v_lo;
+    const uint64_t p1 = u_lo * v_hi;
+    const uint64_t p2 = u_hi * v_lo;
+    const uint64_t p3 = u_hi * v_hi;
+    uint64_t q = (p0 >> 32u) + (p1 & 0xffffffffu) + (p2 & 0xffffffffu);
+    q += uint64_t(1) << 31u; // round, ties up
+    const uint64_t h = p3 + (p2 >> 32u) + (p1 >> 32u) + (q >> 32u);
+    return fpconv_diyfp{h, x.e + y.e + 64};
+}
+
+inline fpconv_diyfp fpconv_normalize(fpconv_diyfp x) noexcept
+{
+    RYML_ASSERT(x.f != 0);
+    while((x.f >> 63u) == 0)
+    {
+        x.f <<= 1u;
+        --x.e;
+    }
+    return x;
+}
+
+inline fpconv_diyfp fpconv_normalize_to(fpconv_diyfp x, int target_exponent) noexcept
+{
+    const int delta = x.e - target_exponent;
+    RYML_ASSERT(delta >= 0);
+    RYML_ASSERT(((x.f << delta) >> delta) == x.f);
+    return fpconv_diyfp{x.f << delta, target_exponent};
+}
+
+
+/** the value v and its boundaries m- and m+, normalized to the same
+ * exponent */
+struct fpconv_boundaries
+{
+    fpconv_diyfp w;
+    fpconv_diyfp minus;
+    fpconv_diyfp plus;
+};
+
+template<class T> struct fpconv_bits;
+template<> struct fpconv_bits<float>  { using type = uint32_t; };
+template<> struct fpconv_bits<double> { using type = uint64_t; };
+
+/** compute the boundaries of a finite positive value. The
+ * boundaries are computed with the precision of T, so that floats
+ * get the shortest representation for a float, not for a double. */
+template<class T>
+fpconv_boundaries fpconv_compute_boundaries(T value) noexcept
+{
+    static_assert(std::numeric_limits<T>::is_iec559, "must be IEEE-754");
+    using bits_type = typename fpconv_bits<T>::type;
+    static_assert(sizeof(bits_type) == sizeof(T), "inconsistent sizes");
+    constexpr const int precision = std::numeric_limits<T>::digits; // including the hidden bit
+    constexpr const int bias = std::numeric_limits<T>::max_exponent - 1 + (precision - 1);
+    constexpr const int min_exp = 1 - bias;
+    constexpr const uint64_t hidden_bit = uint64_t(1) << (precision - 1);
+    bits_type bits;
+    memcpy(&bits, &value, sizeof(T));
+    const uint64_t E = static_cast<uint64_t>(bits) >> (precision - 1);
+    const uint64_t F = static_cast<uint64_t>(bits) & (hidden_bit - 1);
+    const fpconv_diyfp v = (E == 0) ? // denormal?
+        fpconv_diyfp{F, min_exp} :
+        fpconv_diyfp{F + hidden_bit, static_cast<int>(E) - bias};
+    // the boundaries are halfway to the neighbours. The lower
+    // boundary is closer when the significand is a power of two.
+    const bool lower_is_closer = (F == 0 && E > 1);
+    const fpconv_diyfp m_plus = fpconv_diyfp{2 * v.f + 1, v.e - 1};
+    const fpconv_diyfp m_minus = lower_is_closer ?
+        fpconv_diyfp{4 * v.f - 1, v.e - 2} :
+        fpconv_diyfp{2 * v.f - 1, v.e - 1};
+    const fpconv_diyfp w_plus = fpconv_normalize(m_plus);
+    const fpconv_diyfp w_minus = fpconv_normalize_to(m_minus, w_plus.e);
+    return fpconv_boundaries{fpconv_normalize(v), w_minus, w_plus};
+}
+
+
+//-----------------------------------------------------------------------------
+
+struct fpconv_cached_power
+{
+    uint64_t f;
+    int e;
+    int k;
+};
+
+/** get a cached power of ten c = 10^-k such that the exponent of
+ * the product of c with a number of binary exponent e lands in
+ * [alpha, gamma] = [-60, -32] */
+inline fpconv_cached_power fpconv_get_cached_power(int e) noexcept
+{
+    // 10^k for k = -348, -340, ..., 340
+    static const fpconv_cached_power powers[] = {
+        {0xFA8FD5A0081C0288, -1220, -348},
+        {0xBAAEE17FA23EBF76, -1193, -340},
+        {0x8B16FB203055AC76, -1166, -332},
+        {0xCF42894A5DCE35EA, -1140, -324},
+        {0x9A6BB0AA55653B2D, -1113, -316},
+        {0xE61ACF033D1A45DF, -1087, -308},
+        {0xAB70FE17C79AC6CA, -1060, -300},
+        {0xFF77B1FCBEBCDC4F, -1034, -292},
+        {0xBE5691EF416BD60C, -1007, -284},
+        {0x8DD01FAD907FFC3C,  -980, -276},
+        {0xD3515C2831559A83,  -954, -268},
+        {0x9D71AC8FADA6C9B5,  -927, -260},
+        {0xEA9C227723EE8BCB,  -901, -252},
+        {0xAECC49914078536D,  -874, -244},
+        {0x823C12795DB6CE57,  -847, -236},
+        {0xC21094364DFB5637,  -821, -228},
+        {0x9096EA6F3848984F,  -794, -220},
+        {0xD77485CB25823AC7,  -768, -212},
+        {0xA086CFCD97BF97F4,  -741, -204},
+        {0xEF340A98172AACE5,  -715, -196},
+        {0xB23867FB2A35B28E,  -688, -188},
+        {0x84C8D4DFD2C63F3B,  -661, -180},
+        {0xC5DD44271AD3CDBA,  -635, -172},
+        {0x936B9FCEBB25C996,  -608, -164},
+        {0xDBAC6C247D62A584,  -582, -156},
+        {0xA3AB66580D5FDAF6,  -555, -148},
+        {0xF3E2F893DEC3F126,  -529, -140},
+        {0xB5B5ADA8AAFF80B8,  -502, -132},
+        {0x87625F056C7C4A8B,  -475, -124},
+        {0xC9BCFF6034C13053,  -449, -116},
+        {0x964E858C91BA2655,  -422, -108},
+        {0xDFF9772470297EBD,  -396, -100},
+        {0xA6DFBD9FB8E5B88F,  -369,  -92},
+        {0xF8A95FCF88747D94,  -343,  -84},
+        {0xB94470938FA89BCF,  -316,  -76},
+        {0x8A08F0F8BF0F156B,  -289,  -68},
+        {0xCDB02555653131B6,  -263,  -60},
+        {0x993FE2C6D07B7FAC,  -236,  -52},
+        {0xE45C10C42A2B3B06,  -210,  -44},
+        {0xAA242499697392D3,  -183,  -36},
+        {0xFD87B5F28300CA0E,  -157,  -28},
+        {0xBCE5086492111AEB,  -130,  -20},
+        {0x8CBCCC096F5088CC,  -103,  -12},
+        {0xD1B71758E219652C,   -77,   -4},
+        {0x9C40000000000000,   -50,    4},
+        {0xE8D4A51000000000,   -24,   12},
+        {0xAD78EBC5AC620000,     3,   20},
+        {0x813F3978F8940984,    30,   28},
+        {0xC097CE7BC90715B3,    56,   36},
+        {0x8F7E32CE7BEA5C70,    83,   44},
+        {0xD5D238A4ABE98068,   109,   52},
+        {0x9F4F2726179A2245,   136,   60},
+        {0xED63A231D4C4FB27,   162,   68},
+        {0xB0DE65388CC8ADA8,   189,   76},
+        {0x83C7088E1AAB65DB,   216,   84},
+        {0xC45D1DF942711D9A,   242,   92},
+        {0x924D692CA61BE758,   269,  100},
+        {0xDA01EE641A708DEA,   295,  108},
+        {0xA26DA3999AEF774A,   322,  116},
+        {0xF209787BB47D6B85,   348,  124},
+        {0xB454E4A179DD1877,   375,  132},
+        {0x865B86925B9BC5C2,   402,  140},
+        {0xC83553C5C8965D3D,   428,  148},
+        {0x952AB45CFA97A0B3,   455,  156},
+        {0xDE469FBD99A05FE3,   481,  164},
+        {0xA59BC234DB398C25,   508,  172},
+        {0xF6C69A72A3989F5C,   534,  180},
+        {0xB7DCBF5354E9BECE,   561,  188},
+        {0x88FCF317F22241E2,   588,  196},
+        {0xCC20CE9BD35C78A5,   614,  204},
+        {0x98165AF37B2153DF,   641,  212},
+        {0xE2A0B5DC971F303A,   667,  220},
+        {0xA8D9D1535CE3B396,   694,  228},
+        {0xFB9B7CD9A4A7443C,   720,  236},
+        {0xBB764C4CA7A44410,   747,  244},
+        {0x8BAB8EEFB6409C1A,   774,  252},
+        {0xD01FEF10A657842C,   800,  260},
+        {0x9B10A4E5E9913129,   827,  268},
+        {0xE7109BFBA19C0C9D,   853,  276},
+        {0xAC2820D9623BF429,   880,  284},
+        {0x80444B5E7AA7CF85,   907,  292},
+        {0xBF21E44003ACDD2D,   933,  300},
+        {0x8E679C2F5E44FF8F,   960,  308},
+        {0xD433179D9C8CB841,   986,  316},
+        {0x9E19DB92B4E31BA9,  1013,  324},
+        {0xEB96BF6EBADF77D9,  1039,  332},
+        {0xAF87023B9BF0EE6B,  1066,  340},
+    };
+    enum : int { alpha = -60, min_dec_exp = -348, dec_step = 8 };
+    // k = ceil((alpha - e - 1) * log10(2))
+    const int f = alpha - e - 1;
+    const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+    const int index = (-min_dec_exp + k + (dec_step - 1)) / dec_step;
+    RYML_ASSERT(index >= 0 && static_cast<size_t>(index) < sizeof(powers) / sizeof(powers[0]));
+    return powers[index];
+}
+
+/** @return the number of decimal digits of n, and set pow10 to 10^(digits-1) */
+inline int fpconv_find_largest_pow10(uint32_t n, uint32_t *C4_RESTRICT pow10) noexcept
+{
+    if(n >= 1000000000u) { *pow10 = 1000000000u; return 10; }
+    if(n >=  100000000u) { *pow10 =  100000000u; return  9; }
+    if(n >=   10000000u) { *pow10 =   10000000u; return  8; }
+    if(n >=    1000000u) { *pow10 =    1000000u; return  7; }
+    if(n >=     100000u) { *pow10 =     100000u; return  6; }
+    if(n >=      10000u) { *pow10 =      10000u; return  5; }
+    if(n >=       1000u) { *pow10 =       1000u; return  4; }
+    if(n >=        100u) { *pow10 =        100u; return  3; }
+    if(n >=         10u) { *pow10 =         10u; return  2; }
+    *pow10 = 1u;
+    return 1;
+}
+
+/** move the last digit towards w while staying within the boundaries */
+inline void fpconv_round(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) noexcept
+{
+    RYML_ASSERT(len >= 1);
+    RYML_ASSERT(dist <= delta);
+    RYML_ASSERT(rest <= delta);
+    RYML_ASSERT(ten_k > 0);
+    while(rest < dist
+          && delta - rest >= ten_k
+          && (rest + ten_k < dist || dist - rest > rest + ten_k - dist))
+    {
+        RYML_ASSERT(buf[len - 1] != '0');
+        buf[len - 1]--;
+        rest += ten_k;
+    }
+}
+
+/** generate the digits of the shortest representation of w within
+ * the interval [m_minus, m_plus] */
+inline void fpconv_digit_gen(char *buf, int *len, int *dec_exp, fpconv_diyfp m_minus, fpconv_diyfp w, fpconv_diyfp m_plus) noexcept
+{
+    RYML_ASSERT(m_plus.e >= -60 && m_plus.e <= -32);
+    uint64_t delta = fpconv_sub(m_plus, m_minus).f;
+    uint64_t dist = fpconv_sub(m_plus, w).f;
+    const fpconv_diyfp one{uint64_t(1) << -m_plus.e, m_plus.e};
+    uint32_t p1 = static_cast<uint32_t>(m_plus.f >> -one.e); // integral part
+    uint64_t p2 = m_plus.f & (one.f - 1); // fractional part
+    RYML_ASSERT(p1 > 0);
+    uint32_t pow10;
+    int n = fpconv_find_largest_pow10(p1, &pow10);
+    while(n > 0)
+    {
+        const uint32_t d = p1 / pow10;
+        const uint32_t r = p1 % pow10;
+        RYML_ASSERT(d <= 9);
+        buf[(*len)++] = static_cast<char>('0' + d);
+        p1 = r;
+        --n;
+        const uint64_t rest = (uint64_t(p1) << -one.e) + p2;
+        if(rest <= delta)
+        {
+            *dec_exp += n;
+            fpconv_round(buf, *len, dist, delta, rest, uint64_t(pow10) << -one.e);
+            return;
+        }
+        pow10 /= 10;
+    }
+    int m = 0;
+    for(;;)
+    {
+        RYML_ASSERT(p2 <= (std::numeric_limits<uint64_t>::max)() / 10);
+        p2 *= 10;
+        const uint64_t d = p2 >> -one.e;
+        const uint64_t r = p2 & (one.f - 1);
+        RYML_ASSERT(d <= 9);
+        buf[(*len)++] = static_cast<char>('0' + d);
+        p2 = r;
+        ++m;
+        delta *= 10;
+        dist *= 10;
+        if(p2 <= delta)
+            break;
+    }
+    *dec_exp -= m;
+    fpconv_round(buf, *len, dist, delta, p2, one.f);
+}
+
+/** compute the shortest digits of a finite positive value, such
+ * that value == digits * 10^dec_exp after reading back.
+ * @return the number of digits */
+template<class T>
+int fpconv_grisu2(char *digits, int *dec_exp, T value) noexcept
+{
+    RYML_ASSERT(value > 0);
+    const fpconv_boundaries b = fpconv_compute_boundaries(value);
+    const fpconv_cached_power cached = fpconv_get_cached_power(b.plus.e);
+    const fpconv_diyfp c_minus_k{cached.f, cached.e};
+    const fpconv_diyfp w = fpconv_mul(b.w, c_minus_k);
+    const fpconv_diyfp w_minus = fpconv_mul(b.minus, c_minus_k);
+    const fpconv_diyfp w_plus = fpconv_mul(b.plus, c_minus_k);
+    // narrow the interval by one ulp to account for the imprecision
+    // of the multiplication
+    const fpconv_diyfp m_minus{w_minus.f + 1, w_minus.e};
+    const fpconv_diyfp m_plus{w_plus.f - 1, w_plus.e};
+    int len = 0;
+    *dec_exp = -cached.k;
+    fpconv_digit_gen(digits, &len, dec_exp, m_minus, w, m_plus);
+    return len;
+}
+
+
+//-----------------------------------------------------------------------------
+
+/** write the exponent of the scientific notation, with at least two
+ * digits as done by printf() */
+inline char* fpconv_write_exponent(char *buf, int e) noexcept
+{
+    *buf++ = 'e';
+    if(e < 0)
+    {
+        *buf++ = '-';
+        e = -e;
+    }
+    else
+    {
+        *buf++ = '+';
+    }
+    if(e >= 100)
+    {
+        *buf++ = static_cast<char>('0' + e / 100);
+        e %= 100;
+    }
+    *buf++ = static_cast<char>('0' + e / 10);
+    *buf++ = static_cast<char>('0' + e % 10);
+    return buf;
+}
+
+/** lay out the digits using printf("%g") rules: scientific
+ * notation is used when the exponent is less than -4 or not less
+ * than the maximum number of significant digits of T. Trailing
+ * zeros are not printed.
+ * @return the number of characters written */
+inline size_t fpconv_format_digits(char *buf, char const* digits, int ndigits, int dec_exp, int max_digits) noexcept
+{
+    char *pos = buf;
+    const int x = ndigits + dec_exp - 1; // exponent of the first digit
+    if(x < -4 || x >= max_digits)
+    {
+        *pos++ = digits[0];
+        if(ndigits > 1)
+        {
+            *pos++ = '.';
+            memcpy(pos, digits + 1, static_cast<size_t>(ndigits - 1));
+            pos += ndigits - 1;
+        }
+        pos = fpconv_write_exponent(pos, x);
+    }
+    else if(dec_exp >= 0) // integral: ddd000
+    {
+        memcpy(pos, digits, static_cast<size_t>(ndigits));
+        pos += ndigits;
+        memset(pos, '0', static_cast<size_t>(dec_exp));
+        pos += dec_exp;
+    }
+    else if(x >= 0) // ddd.ddd
+    {
+        memcpy(pos, digits, static_cast<size_t>(x + 1));
+        pos += x + 1;
+        *pos++ = '.';
+        memcpy(pos, digits + x + 1, static_cast<size_t>(ndigits - x - 1));
+        pos += ndigits - x - 1;
+    }
+    else // 0.000ddd
+    {
+        *pos++ = '0';
+        *pos++ = '.';
+        memset(pos, '0', static_cast<size_t>(-x - 1));
+        pos += -x - 1;
+        memcpy(pos, digits, static_cast<size_t>(ndigits));
+        pos += ndigits;
+    }
+    return static_cast<size_t>(pos - buf);
+}
+
+/** format a finite value with the shortest representation which
+ * reads back to the same value. Like to_chars(), the return value
+ * is the required size; nothing is written if the buffer is too
+ * small. */
+template<class T>
+size_t format_float_shortest(substr buf, T value) noexcept
+{
+    C4_SUPPRESS_WARNING_GCC_CLANG_WITH_PUSH("-Wfloat-equal");
+    static_assert(std::is_floating_point<T>::value, "must be floating point");
+    char tmp[fpconv_max_chars];
+    char *pos = tmp;
+    if(std::signbit(value))
+    {
+        *pos++ = '-';
+        value = -value;
+    }
+    if(value == T(0))
+    {
+        *pos++ = '0';
+    }
+    else
+    {
+        char digits[20];
+        int dec_exp = 0;
+        const int ndigits = fpconv_grisu2(digits, &dec_exp, value);
+        pos += fpconv_format_digits(pos, digits, ndigits, dec_exp, std::numeric_limits<T>::max_digits10);
+    }
+    const size_t len = static_cast<size_t>(pos - tmp);
+    RYML_ASSERT(len <= fpconv_max_chars);
+    if(len <= buf.len)
+        memcpy(buf.str, tmp, len);
+    return len;
+    C4_SUPPRESS_WARNING_GCC_CLANG_POP
+}
+
+
+//-----------------------------------------------------------------------------
+
+template<class T> struct fpconv_exact;
+/** doubles: integers up to 2^53 and powers of ten up to 10^22 are exact */
+template<> struct fpconv_exact<double>
+{
+    enum : uint64_t { max_mantissa = uint64_t(1) << 53 };
+    enum : int { max_exp10 = 22 };
+};
+/** floats: integers up to 2^24 and powers of ten up to 10^10 are exact */
+template<> struct fpconv_exact<float>
+{
+    enum : uint64_t { max_mantissa = uint64_t(1) << 24 };
+    enum : int { max_exp10 = 10 };
+};
+
+/** try to read a plain decimal number of the form -ddd.ddde-dd
+ * which can be converted exactly with a single multiplication or
+ * division (Clinger's fast path).
+ * @return false if the number is not in this form or cannot be
+ * converted exactly, in which case the caller must use the full
+ * conversion. */
+template<class T>
+bool scan_float_fast(csubstr s, T *C4_RESTRICT val) noexcept
+{
+    static_assert(std::is_floating_point<T>::value, "must be floating point");
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD != 0)
+    // intermediate results with excess precision would be rounded twice
+    (void)s; (void)val;
+    return false;
+#else
+    static const T pow10[] = {
+        T(1e0), T(1e1), T(1e2), T(1e3), T(1e4), T(1e5), T(1e6), T(1e7),
+        T(1e8), T(1e9), T(1e10), T(1e11), T(1e12), T(1e13), T(1e14), T(1e15),
+        T(1e16), T(1e17), T(1e18), T(1e19), T(1e20), T(1e21), T(1e22),
+    };
+    const char *C4_RESTRICT pos = s.str;
+    const char *const end = s.str + s.len;
+    bool negative = false;
+    if(pos != end && *pos == '-')
+    {
+        negative = true;
+        ++pos;
+    }
+    uint64_t mantissa = 0;
+    int num_digits = 0;
+    int exp10 = 0;
+    const char *const int_start = pos;
+    for( ; pos != end && (*pos >= '0' && *pos <= '9'); ++pos, ++num_digits)
+        mantissa = 10u * mantissa + static_cast<uint64_t>(*pos - '0');
+    if(pos == int_start)
+        return false; // no integral digits, eg .5 or .inf
+    if(pos != end && *pos == '.')
+    {
+        const char *const frac_start = ++pos;
+        for( ; pos != end && (*pos >= '0' && *pos <= '9'); ++pos, ++num_digits)
+            mantissa = 10u * mantissa + static_cast<uint64_t>(*pos - '0');
+        if(pos == frac_start)
+            return false; // eg 1. - let the full conversion decide
+        exp10 = -static_cast<int>(pos - frac_start);
+    }
+    if(num_digits > 19) // the mantissa may have overflowed
+        return false;
+    if(pos != end && (*pos == 'e' || *pos == 'E'))
+    {
+        ++pos;
+        bool exp_negative = false;
+        if(pos != end && (*pos == '-' || *pos == '+'))
+            exp_negative = (*pos++ == '-');
+        const char *const exp_start = pos;
+        int e = 0;
+        for( ; pos != end && (*pos >= '0' && *pos <= '9') && pos - exp_start < 4; ++pos)
+            e = 10 * e + (*pos - '0');
+        if(pos == exp_start)
+            return false;
+        exp10 += exp_negative ? -e : e;
+    }
+    if(pos != end)
+        return false; // trailing characters, eg hexadecimal or invalid
+    if(mantissa > fpconv_exact<T>::max_mantissa)
+        return false;
+    if(exp10 < -fpconv_exact<T>::max_exp10 || exp10 > fpconv_exact<T>::max_exp10)
+        return false;
+    // both operands are exact, so the result is correctly rounded
+    T result = static_cast<T>(mantissa);
+    if(exp10 < 0)
+        result /= pow10[-exp10];
+    else
+        result *= pow10[exp10];
+    *val = negative ? -result : result;
+    return true;
+#endif
+}
+
+} // namespace detail
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_DETAIL_FPCONV_HPP_ */
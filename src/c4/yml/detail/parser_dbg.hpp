@@ -5,6 +5,15 @@
 #include "../common.hpp"
 #endif
 #include <cstdio>
+#ifdef RYML_PROFILE_CYCLES
+#   if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#       include <intrin.h>
+#   elif defined(__x86_64__) || defined(__i386__)
+#       include <x86intrin.h>
+#   else
+#       include <chrono>
+#   endif
+#endif
 
 //-----------------------------------------------------------------------------
 // some debugging scaffolds
@@ -39,6 +48,39 @@
 #   define _c4dbgq(msg)
 #endif
 
+// profiling scaffolds: _c4prof(phase) counts a call to the phase, and
+// with RYML_PROFILE_CYCLES also the ticks until the end of the scope.
+// Without RYML_PROFILE it expands to nothing.
+#if defined(RYML_PROFILE_CYCLES)
+namespace c4 {
+namespace yml {
+namespace detail {
+inline uint64_t prof_ticks() noexcept
+{
+#   if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+    return (uint64_t)__rdtsc();
+#   else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count(); // nanoseconds, where there is no cycle counter
+#   endif
+}
+template<class Phase>
+struct ProfScope
+{
+    Phase *m_phase;
+    uint64_t m_start;
+    ProfScope(Phase *phase) noexcept : m_phase(phase), m_start(prof_ticks()) { ++phase->calls; }
+    ~ProfScope() noexcept { m_phase->ticks += prof_ticks() - m_start; }
+};
+} // namespace detail
+} // namespace yml
+} // namespace c4
+#   define _c4prof(phase) c4::yml::detail::ProfScope<ParserProfile::Phase> _c4prof_scope(&this->m_profile.phases[phase])
+#elif defined(RYML_PROFILE)
+#   define _c4prof(phase) ++this->m_profile.phases[phase].calls
+#else
+#   define _c4prof(phase)
+#endif
+
 #define _c4prsp(sp) ((int)(sp).len), (sp).str
 #define _c4prc(c) (__c4prc(c) ? 2 : 1), (__c4prc(c) ? __c4prc(c) : &c)
 inline const char *__c4prc(const char &c)
@@ -0,0 +1,183 @@
+#ifndef _C4_YML_DETAIL_SCALAR_SCAN_HPP_
+#define _C4_YML_DETAIL_SCALAR_SCAN_HPP_
+
+/** @file scalar_scan.hpp single-pass scans over scalars, used by the
+ * emitter. When SSE2 is available (and RYML_NO_SIMD is not defined),
+ * 16 bytes are processed at a time. */
+
+#ifndef _C4_YML_COMMON_HPP_
+#include "../common.hpp"
+#endif
+
+#if !defined(RYML_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   define RYML_SIMD_SSE2
+#   include <emmintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
+#endif
+
+namespace c4 {
+namespace yml {
+namespace detail {
+
+/** flags for the characters which affect how a scalar is quoted */
+typedef enum : uint8_t {
+    SCALAR_SPECIAL = 1, ///< any of #:-?,\n{}[]'"
+    SCALAR_SQUOTE  = 2, ///< '
+    SCALAR_DQUOTE  = 4, ///< "
+    SCALAR_NEWLINE = 8, ///< \n
+} ScalarChars_e;
+
+/** the ScalarChars_e flags of each character */
+constexpr const uint8_t scalar_chars_table[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 5, 1, 0, 0, 0, 3, 0, 0, 0, 0, 1, 1, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+#ifdef RYML_SIMD_SSE2
+/** index of the lowest set bit; mask must not be zero */
+C4_ALWAYS_INLINE unsigned ctz_(unsigned mask) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long pos;
+    _BitScanForward(&pos, mask);
+    return (unsigned)pos;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+
+/** get the ScalarChars_e flags of all the characters in the
+ * scalar, in a single pass. */
+inline uint8_t scalar_chars(csubstr s) noexcept
+{
+    uint8_t flags = 0;
+    size_t i = 0;
+#ifdef RYML_SIMD_SSE2
+    if(s.len >= 16)
+    {
+        const __m128i sq = _mm_set1_epi8('\'');
+        const __m128i dq = _mm_set1_epi8('"');
+        const __m128i nl = _mm_set1_epi8('\n');
+        __m128i acc_sq = _mm_setzero_si128();
+        __m128i acc_dq = _mm_setzero_si128();
+        __m128i acc_nl = _mm_setzero_si128();
+        __m128i acc_sp = _mm_setzero_si128();
+        for( ; i + 16 <= s.len; i += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.str + i));
+            acc_sq = _mm_or_si128(acc_sq, _mm_cmpeq_epi8(v, sq));
+            acc_dq = _mm_or_si128(acc_dq, _mm_cmpeq_epi8(v, dq));
+            acc_nl = _mm_or_si128(acc_nl, _mm_cmpeq_epi8(v, nl));
+            __m128i sp = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('#')), _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+            sp = _mm_or_si128(sp, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')), _mm_cmpeq_epi8(v, _mm_set1_epi8('?'))));
+            sp = _mm_or_si128(sp, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(',')), _mm_cmpeq_epi8(v, _mm_set1_epi8('{'))));
+            sp = _mm_or_si128(sp, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('}')), _mm_cmpeq_epi8(v, _mm_set1_epi8('['))));
+            sp = _mm_or_si128(sp, _mm_cmpeq_epi8(v, _mm_set1_epi8(']')));
+            acc_sp = _mm_or_si128(acc_sp, sp);
+        }
+        flags |= _mm_movemask_epi8(acc_sq) ? (uint8_t)(SCALAR_SQUOTE|SCALAR_SPECIAL) : (uint8_t)0;
+        flags |= _mm_movemask_epi8(acc_dq) ? (uint8_t)(SCALAR_DQUOTE|SCALAR_SPECIAL) : (uint8_t)0;
+        flags |= _mm_movemask_epi8(acc_nl) ? (uint8_t)(SCALAR_NEWLINE|SCALAR_SPECIAL) : (uint8_t)0;
+        flags |= _mm_movemask_epi8(acc_sp) ? (uint8_t)SCALAR_SPECIAL : (uint8_t)0;
+    }
+#endif
+    for( ; i < s.len; ++i)
+        flags |= scalar_chars_table[(uint8_t)s.str[i]];
+    return flags;
+}
+
+
+/** find the first single quote or newline at or after pos.
+ * @return the position, or npos if there is none */
+inline size_t find_squote_or_newline(csubstr s, size_t pos) noexcept
+{
+#ifdef RYML_SIMD_SSE2
+    const __m128i sq = _mm_set1_epi8('\'');
+    const __m128i nl = _mm_set1_epi8('\n');
+    for( ; pos + 16 <= s.len; pos += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.str + pos));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sq), _mm_cmpeq_epi8(v, nl)));
+        if(mask)
+            return pos + ctz_((unsigned)mask);
+    }
+#endif
+    for( ; pos < s.len; ++pos)
+        if(s.str[pos] == '\'' || s.str[pos] == '\n')
+            return pos;
+    return npos;
+}
+
+/** find the first character which must be escaped in a JSON string:
+ * a double quote, a backslash, or a control character (below 0x20).
+ * @return the position, or npos if there is none */
+inline size_t find_json_escape(csubstr s, size_t pos) noexcept
+{
+#ifdef RYML_SIMD_SSE2
+    const __m128i dq = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i ctl = _mm_set1_epi8(0x1f);
+    for( ; pos + 16 <= s.len; pos += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.str + pos));
+        // unsigned v <= 0x1f is the same as min(v, 0x1f) == v
+        const __m128i is_ctl = _mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v);
+        const int mask = _mm_movemask_epi8(_mm_or_si128(is_ctl, _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs))));
+        if(mask)
+            return pos + ctz_((unsigned)mask);
+    }
+#endif
+    for( ; pos < s.len; ++pos)
+    {
+        const char c = s.str[pos];
+        if((uint8_t)c < 0x20 || c == '"' || c == '\\')
+            return pos;
+    }
+    return npos;
+}
+
+/** the JSON escape sequences of the control characters. These are
+ * static, so writers may keep pointers to them. */
+constexpr const char *const json_escapes_ctl[32] = {
+    "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+    "\\b", "\\t", "\\n", "\\u000b", "\\f", "\\r", "\\u000e", "\\u000f",
+    "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+    "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+};
+
+/** get the JSON escape sequence for a character returned by
+ * find_json_escape(). The result points at static storage. */
+inline csubstr json_escape(char c) noexcept
+{
+    if(c == '"')
+        return csubstr("\\\"", 2);
+    else if(c == '\\')
+        return csubstr("\\\\", 2);
+    RYML_ASSERT((uint8_t)c < 0x20);
+    const char *e = json_escapes_ctl[(uint8_t)c];
+    return csubstr(e, e[1] == 'u' ? 6u : 2u);
+}
+
+} // namespace detail
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_DETAIL_SCALAR_SCAN_HPP_ */
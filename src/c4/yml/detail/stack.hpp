@@ -160,11 +160,11 @@ void stack<T, N>::reserve(size_t sz)
         m_capacity = N;
         return;
     }
-    T *buf = (T*) m_callbacks.m_allocate(sz * sizeof(T), m_stack, m_callbacks.m_user_data);
+    T *buf = (T*) alloc_at(m_callbacks, sz * sizeof(T), m_stack, ALLOC_SITE_STACK);
     memcpy(buf, m_stack, m_size * sizeof(T));
     if(m_stack != m_buf)
     {
-        m_callbacks.m_free(m_stack, m_capacity * sizeof(T), m_callbacks.m_user_data);
+        free_at(m_callbacks, m_stack, m_capacity * sizeof(T), ALLOC_SITE_STACK);
     }
     m_stack = buf;
     m_capacity = sz;
@@ -179,7 +179,7 @@ void stack<T, N>::_free()
     RYML_ASSERT(m_stack != nullptr); // this structure cannot be memset() to zero
     if(m_stack != m_buf)
     {
-        m_callbacks.m_free(m_stack, m_capacity * sizeof(T), m_callbacks.m_user_data);
+        free_at(m_callbacks, m_stack, m_capacity * sizeof(T), ALLOC_SITE_STACK);
         m_stack = m_buf;
         m_size = N;
         m_capacity = N;
@@ -19,6 +19,10 @@ substr Emitter<Writer>::emit(EmitType_e type, Tree const& t, size_t id, bool err
     {
         _do_visit_json(t, id);
     }
+    else if(type == YAML_FLOW_SL || type == YAML_FLOW_ML)
+    {
+        _do_visit_flow_top(t, id, type == YAML_FLOW_ML);
+    }
     else
     {
         c4::yml::error("unknown emit type");
@@ -27,14 +31,46 @@ substr Emitter<Writer>::emit(EmitType_e type, Tree const& t, size_t id, bool err
     return result;
 }
 
-/** @todo this function is too complex. break it down into manageable
- * pieces */
+template<class Writer>
+substr Emitter<Writer>::emit_open(Tree const& t, size_t id, size_t ilevel, size_t *do_indent, bool error_on_excess)
+{
+    RYML_ASSERT(do_indent != nullptr);
+    *do_indent = _do_visit_open(t, id, ilevel, *do_indent);
+    return this->Writer::_get(error_on_excess);
+}
+
+template<class Writer>
+substr Emitter<Writer>::emit_children(Tree const& t, size_t id, size_t first, size_t end, size_t ilevel, size_t do_indent, bool error_on_excess)
+{
+    RYML_ASSERT(first == NONE || t.parent(first) == id);
+    _do_visit_children(t, id, first, end, ilevel, do_indent);
+    return this->Writer::_get(error_on_excess);
+}
+
 template<class Writer>
 void Emitter<Writer>::_do_visit(Tree const& t, size_t id, size_t ilevel, size_t do_indent)
+{
+    do_indent = _do_visit_open(t, id, ilevel, do_indent);
+    if(do_indent != NONE)
+        _do_visit_children(t, id, t.first_child(id), NONE, ilevel, do_indent);
+}
+
+/** write the node, but not its children. Return the indentation flag
+ * for the first child, or NONE if the children are not to be visited.
+ * @todo this function is too complex. break it down into manageable
+ * pieces */
+template<class Writer>
+size_t Emitter<Writer>::_do_visit_open(Tree const& t, size_t id, size_t ilevel, size_t do_indent)
 {
     RepC ind = indent_to(do_indent * ilevel);
     RYML_ASSERT(t.is_root(id) || (t.parent_is_map(id) || t.parent_is_seq(id)));
 
+    // an unmodified node is copied from its source; this needs the
+    // node to start a line, ie the node cannot be the first child of
+    // a seq item
+    if(t.has_src_spans() && (do_indent || ilevel == 0) && _write_src_span(t, id, ilevel))
+        return NONE;
+
     if(t.is_doc(id))
     {
         if(!t.is_root(id))
@@ -42,6 +78,17 @@ void Emitter<Writer>::_do_visit(Tree const& t, size_t id, size_t ilevel, size_t
             RYML_ASSERT(t.is_stream(t.parent(id)));
             this->Writer::_do_write("---");
         }
+        if(t.is_flow(id))
+        {
+            if(!t.is_root(id))
+                this->Writer::_do_write(' ');
+            if(t.is_flow_ml(id))
+                _do_visit_flow_ml(t, id, 0);
+            else
+                _do_visit_flow_sl(t, id);
+            this->Writer::_do_write('\n');
+            return NONE;
+        }
         if(!t.has_val(id))
         {
             if(t.has_val_tag(id))
@@ -75,7 +122,7 @@ void Emitter<Writer>::_do_visit(Tree const& t, size_t id, size_t ilevel, size_t
         this->Writer::_do_write(": ");
         _writev(t, id, ilevel);
         this->Writer::_do_write('\n');
-        return;
+        return NONE;
     }
     else if(t.is_val(id))
     {
@@ -84,7 +131,21 @@ void Emitter<Writer>::_do_visit(Tree const& t, size_t id, size_t ilevel, size_t
         this->Writer::_do_write("- ");
         _writev(t, id, ilevel);
         this->Writer::_do_write('\n');
-        return;
+        return NONE;
+    }
+    else if(t.is_flow(id) && !t.is_stream(id))
+    {
+        this->Writer::_do_write(ind);
+        if(!t.has_key(id) && !t.is_root(id))
+            this->Writer::_do_write("- ");
+        // in block context, the continuation lines of the flow
+        // container must be more indented than the container's line
+        if(t.is_flow_ml(id))
+            _do_visit_flow_ml(t, id, t.is_root(id) ? ilevel : ilevel + 1);
+        else
+            _do_visit_flow_sl(t, id);
+        this->Writer::_do_write('\n');
+        return NONE;
     }
     else if(t.is_container(id))
     {
@@ -150,7 +211,7 @@ void Emitter<Writer>::_do_visit(Tree const& t, size_t id, size_t ilevel, size_t
             {
                 this->Writer::_do_write(" {}\n");
             }
-            return;
+            return NONE;
         }
 
         if(spc && !nl)
@@ -166,18 +227,261 @@ void Emitter<Writer>::_do_visit(Tree const& t, size_t id, size_t ilevel, size_t
         }
     } // container
 
-    size_t next_level = ilevel + 1;
-    if(t.is_stream(id) || t.is_doc(id) || t.is_root(id))
+    return do_indent;
+}
+
+/** write the node verbatim from its source span, re-indenting its
+ * lines from the source indentation to the given level. Return false
+ * if the node has no span (or was modified), or if the span has lines
+ * which cannot be re-indented. */
+template<class Writer>
+bool Emitter<Writer>::_write_src_span(Tree const& t, size_t id, size_t ilevel)
+{
+    const csubstr span = t.src_span(id);
+    if(!span.str)
+        return false;
+    RYML_ASSERT(!span.empty());
+    const size_t from = t.src_span_indentation(id);
+    const size_t to = 2u * ilevel;
+    if(from == to)
     {
-        next_level = ilevel; // do not indent at top level
+        this->Writer::_do_write(span);
     }
+    else
+    {
+        // every line which is not blank or a comment must have at
+        // least the indentation of the first line
+        for(size_t pos = 0; pos < span.len; )
+        {
+            csubstr line = span.sub(pos);
+            line = line.first(line.find('\n')); // npos gives the whole line
+            const size_t ind = line.first_not_of(' ');
+            if(ind != npos && ind < from && line.str[ind] != '#' && line.str[ind] != '\r')
+                return false;
+            pos += line.len + 1;
+        }
+        for(size_t pos = 0; pos < span.len; )
+        {
+            csubstr line = span.sub(pos);
+            line = line.first(line.find('\n'));
+            const size_t ind = line.first_not_of(' ');
+            if(ind == npos || line.str[ind] == '\r')
+            {
+                // blank line: drop the indentation
+                this->Writer::_do_write(line.sub(ind == npos ? line.len : ind));
+            }
+            else if(ind >= from)
+            {
+                this->Writer::_do_write(RepC{' ', to});
+                this->Writer::_do_write(line.sub(from));
+            }
+            else
+            {
+                this->Writer::_do_write(line); // a comment
+            }
+            pos += line.len;
+            if(pos < span.len)
+            {
+                this->Writer::_do_write('\n');
+                ++pos;
+            }
+        }
+    }
+    if(span.back() != '\n')
+        this->Writer::_do_write('\n');
+    return true;
+}
+
+/** visit the children of @p id in [first, end), and their descendants.
+ * The tree is walked through the parent links rather than with
+ * recursion, so that the stack usage does not depend on the depth of
+ * the tree. */
+template<class Writer>
+void Emitter<Writer>::_do_visit_children(Tree const& t, size_t id, size_t first, size_t end, size_t ilevel, size_t do_indent)
+{
+    ilevel = child_level(t, id, ilevel); // the level of node
+    size_t node = first;
+    while(node != end)
+    {
+        const size_t child_indent = _do_visit_open(t, node, ilevel, do_indent);
+        do_indent = 1;
+        if(child_indent != NONE && t.has_children(node))
+        {
+            ilevel = child_level(t, node, ilevel);
+            do_indent = child_indent;
+            node = t.first_child(node);
+            continue;
+        }
+        // go to the next sibling, climbing up as needed
+        while(true)
+        {
+            const size_t parent = t.parent(node);
+            if(parent == id)
+            {
+                node = t.next_sibling(node);
+                break;
+            }
+            const size_t next = t.next_sibling(node);
+            if(next != NONE)
+            {
+                node = next;
+                break;
+            }
+            if(child_level(t, parent, 0) != 0)
+                --ilevel;
+            node = parent;
+        }
+    }
+}
+
+template<class Writer>
+void Emitter<Writer>::_do_visit_flow_top(Tree const& t, size_t id, bool multiline)
+{
+    if(t.is_stream(id))
+    {
+        for(size_t ich = t.first_child(id); ich != NONE; ich = t.next_sibling(ich))
+        {
+            this->Writer::_do_write("---");
+            if(t.has_val(ich) || t.is_container(ich))
+                this->Writer::_do_write(' ');
+            _do_visit_flow_top(t, ich, multiline);
+        }
+        return;
+    }
+    if(t.is_container(id))
+    {
+        if(multiline)
+            _do_visit_flow_ml(t, id, 0);
+        else
+            _do_visit_flow_sl(t, id);
+    }
+    else if(t.has_val(id))
+    {
+        _do_visit_flow_sl(t, id);
+    }
+    this->Writer::_do_write('\n');
+}
 
-    for(size_t ich = t.first_child(id); ich != NONE; ich = t.next_sibling(ich))
+template<class Writer>
+void Emitter<Writer>::_write_flow_container_open(Tree const& t, size_t id)
+{
+    if(t.has_key(id))
     {
-        _do_visit(t, ich, next_level, do_indent);
-        do_indent = true;
+        _writek_flow(t, id);
+        this->Writer::_do_write(": ");
+    }
+    if(t.has_val_tag(id))
+    {
+        _write_tag(t.val_tag(id));
+        this->Writer::_do_write(' ');
+    }
+    if(t.has_val_anchor(id))
+    {
+        this->Writer::_do_write('&');
+        this->Writer::_do_write(t.val_anchor(id));
+        this->Writer::_do_write(' ');
     }
+    this->Writer::_do_write(t.is_seq(id) ? '[' : '{');
 }
+
+template<class Writer>
+void Emitter<Writer>::_do_visit_flow_sl(Tree const& t, size_t id)
+{
+    RYML_ASSERT( ! t.is_stream(id));
+    // walk the tree through the parent links rather than with
+    // recursion, so that the stack usage does not depend on the depth
+    // of the tree
+    size_t node = id;
+    while(true)
+    {
+        if(t.is_keyval(node))
+        {
+            _writek_flow(t, node);
+            this->Writer::_do_write(": ");
+            _writev_flow(t, node);
+        }
+        else if(t.has_val(node))
+        {
+            _writev_flow(t, node);
+        }
+        else
+        {
+            RYML_ASSERT(t.is_container(node));
+            _write_flow_container_open(t, node);
+            if(t.has_children(node))
+            {
+                node = t.first_child(node);
+                continue;
+            }
+            this->Writer::_do_write(t.is_seq(node) ? ']' : '}');
+        }
+        // close the parents which have no more children, until the
+        // next sibling is found
+        while(true)
+        {
+            if(node == id)
+                return;
+            const size_t next = t.next_sibling(node);
+            if(next != NONE)
+            {
+                this->Writer::_do_write(", ");
+                node = next;
+                break;
+            }
+            node = t.parent(node);
+            this->Writer::_do_write(t.is_seq(node) ? ']' : '}');
+        }
+    }
+}
+
+template<class Writer>
+void Emitter<Writer>::_do_visit_flow_ml(Tree const& t, size_t id, size_t ilevel)
+{
+    RYML_ASSERT( ! t.is_stream(id));
+    // walk the tree through the parent links rather than with
+    // recursion; ilevel is the indentation level of the current node
+    size_t node = id;
+    while(true)
+    {
+        if( ! t.is_container(node) || t.is_flow_sl(node))
+        {
+            _do_visit_flow_sl(t, node);
+        }
+        else
+        {
+            _write_flow_container_open(t, node);
+            if(t.has_children(node))
+            {
+                this->Writer::_do_write('\n');
+                node = t.first_child(node);
+                _indent(++ilevel);
+                continue;
+            }
+            this->Writer::_do_write(t.is_seq(node) ? ']' : '}');
+        }
+        // close the parents which have no more children, until the
+        // next sibling is found
+        while(true)
+        {
+            if(node == id)
+                return;
+            const size_t next = t.next_sibling(node);
+            if(next != NONE)
+            {
+                this->Writer::_do_write(',');
+                this->Writer::_do_write('\n');
+                _indent(ilevel);
+                node = next;
+                break;
+            }
+            this->Writer::_do_write('\n');
+            _indent(--ilevel);
+            node = t.parent(node);
+            this->Writer::_do_write(t.is_seq(node) ? ']' : '}');
+        }
+    }
+}
+
 template<class Writer>
 void Emitter<Writer>::_do_visit_json(Tree const& t, size_t id)
 {
@@ -185,7 +489,41 @@ void Emitter<Writer>::_do_visit_json(Tree const& t, size_t id)
     {
         c4::yml::error("JSON does not have streams");
     }
-    else if(t.is_keyval(id))
+    // walk the tree through the parent links rather than with
+    // recursion, so that the stack usage does not depend on the depth
+    // of the tree
+    size_t node = id;
+    while(true)
+    {
+        _write_json_open(t, node);
+        if(t.has_children(node))
+        {
+            node = t.first_child(node);
+            continue;
+        }
+        // close the node, and then the parents which have no more
+        // children, until the next sibling is found
+        while(true)
+        {
+            _write_json_close(t, node);
+            if(node == id)
+                return;
+            const size_t next = t.next_sibling(node);
+            if(next != NONE)
+            {
+                this->Writer::_do_write(',');
+                node = next;
+                break;
+            }
+            node = t.parent(node);
+        }
+    }
+}
+
+template<class Writer>
+void Emitter<Writer>::_write_json_open(Tree const& t, size_t id)
+{
+    if(t.is_keyval(id))
     {
         _writek_json(t, id);
         this->Writer::_do_write(": ");
@@ -202,7 +540,6 @@ void Emitter<Writer>::_do_visit_json(Tree const& t, size_t id)
             _writek_json(t, id);
             this->Writer::_do_write(": ");
         }
-
         if(t.is_seq(id))
         {
             this->Writer::_do_write('[');
@@ -211,13 +548,12 @@ void Emitter<Writer>::_do_visit_json(Tree const& t, size_t id)
         {
             this->Writer::_do_write('{');
         }
-    } // container
-    for(size_t ich = t.first_child(id); ich != NONE; ich = t.next_sibling(ich))
-    {
-        if(ich != t.first_child(id))
-            this->Writer::_do_write(',');
-        _do_visit_json(t, ich);
     }
+}
+
+template<class Writer>
+void Emitter<Writer>::_write_json_close(Tree const& t, size_t id)
+{
     if(t.is_container(id))
     {
         if(t.is_seq(id))
@@ -231,8 +567,10 @@ void Emitter<Writer>::_do_visit_json(Tree const& t, size_t id)
     }
 }
 
+/** write the tag and anchor of a scalar, or the reference.
+ * @return false if nothing else remains to be written */
 template<class Writer>
-void Emitter<Writer>::_write(NodeScalar const& sc, NodeType flags, size_t ilevel)
+bool Emitter<Writer>::_write_props(NodeScalar const& sc, NodeType flags)
 {
     if( ! sc.tag.empty())
     {
@@ -252,8 +590,23 @@ void Emitter<Writer>::_write(NodeScalar const& sc, NodeType flags, size_t ilevel
         if(sc.anchor != "<<")
             this->Writer::_do_write('*');
         this->Writer::_do_write(sc.anchor);
-        return;
+        return false;
     }
+    return true;
+}
+
+template<class Writer>
+void Emitter<Writer>::_write_flow(NodeScalar const& sc, NodeType flags)
+{
+    if(_write_props(sc, flags))
+        _write_scalar_flow(sc.scalar, flags.is_quoted());
+}
+
+template<class Writer>
+void Emitter<Writer>::_write(NodeScalar const& sc, NodeType flags, size_t ilevel)
+{
+    if( ! _write_props(sc, flags))
+        return;
 
     if(sc.scalar.begins_with_any(" \t") || (sc.scalar.first_of('\n') == npos))
     {
@@ -348,15 +701,15 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
         return;
     }
 
+    // get all the special characters in a single pass
+    const uint8_t chars = detail::scalar_chars(s);
     const bool needs_quotes = (
         was_quoted
         ||
         (
-            ( ! s.is_number())
-            &&
             (
                 // has leading whitespace
-                s.begins_with(" \n\r\t")
+                s.begins_with_any(" \n\r\t")
                 ||
                 // looks like reference or anchor
                 s.begins_with_any("*&")
@@ -364,11 +717,13 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
                 s.begins_with("<<")
                 ||
                 // has trailing whitespace
-                s.ends_with(" \n\r\t")
+                s.ends_with_any(" \n\r\t")
                 ||
                 // has special chars
-                (s.first_of("#:-?,\n{}[]'\"") != npos)
+                (chars & detail::SCALAR_SPECIAL)
             )
+            &&
+            ( ! s.is_number())
         )
     );
 
@@ -378,15 +733,16 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
     }
     else
     {
-        const bool has_dquotes = s.first_of( '"') != npos;
-        const bool has_squotes = s.first_of('\'') != npos;
-        if(!has_squotes && has_dquotes)
+        const bool has_dquotes = (chars & detail::SCALAR_DQUOTE) != 0;
+        const bool has_squotes = (chars & detail::SCALAR_SQUOTE) != 0;
+        const bool has_newlines = (chars & detail::SCALAR_NEWLINE) != 0;
+        if(!has_squotes && has_dquotes && !has_newlines)
         {
             this->Writer::_do_write('\'');
             this->Writer::_do_write(s);
             this->Writer::_do_write('\'');
         }
-        else if(has_squotes && !has_dquotes)
+        else if(has_squotes && !has_dquotes && !has_newlines)
         {
             this->Writer::_do_write('"');
             this->Writer::_do_write(s);
@@ -396,15 +752,12 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
         {
             size_t pos = 0; // tracks the last character that was already written
             this->Writer::_do_write('\'');
-            for(size_t i = 0; i < s.len; ++i)
+            for(size_t i = detail::find_squote_or_newline(s, 0); i != npos; i = detail::find_squote_or_newline(s, i + 1))
             {
-                if(s[i] == '\'' || s[i] == '\n')
-                {
-                    csubstr sub = s.range(pos, i);
-                    pos = i;
-                    this->Writer::_do_write(sub); // write everything up to this point
-                    this->Writer::_do_write(s[i]); // write the character twice
-                }
+                csubstr sub = s.range(pos, i);
+                pos = i;
+                this->Writer::_do_write(sub); // write everything up to this point
+                this->Writer::_do_write(s[i]); // write the character twice
             }
             if(pos < s.len)
             {
@@ -415,44 +768,55 @@ void Emitter<Writer>::_write_scalar(csubstr s, bool was_quoted)
         }
     }
 }
+/** block scalars cannot be used in flow style, so scalars with
+ * newlines are written double-quoted, with the newlines escaped. */
 template<class Writer>
-void Emitter<Writer>::_write_scalar_json(csubstr s, bool as_key, bool was_quoted)
+void Emitter<Writer>::_write_scalar_flow(csubstr s, bool was_quoted)
 {
-    if(was_quoted)
+    if(s.first_of('\n') == npos)
     {
-        this->Writer::_do_write('"');
-        this->Writer::_do_write(s);
-        this->Writer::_do_write('"');
+        _write_scalar(s, was_quoted);
+        return;
+    }
+    size_t pos = 0; // tracks the last character that was already written
+    this->Writer::_do_write('"');
+    for(size_t i = 0; i < s.len; ++i)
+    {
+        const char c = s.str[i];
+        if(c == '\n' || c == '"' || c == '\\')
+        {
+            this->Writer::_do_write(s.range(pos, i));
+            pos = i + 1;
+            this->Writer::_do_write(c == '\n' ? csubstr("\\n") : (c == '"' ? csubstr("\\\"") : csubstr("\\\\")));
+        }
     }
+    if(pos < s.len)
+        this->Writer::_do_write(s.sub(pos));
+    this->Writer::_do_write('"');
+}
+
+template<class Writer>
+void Emitter<Writer>::_write_scalar_json(csubstr s, bool as_key, bool was_quoted)
+{
     // json only allows strings as keys
-    else if(!as_key && (s.is_number() || s == "true" || s == "null" || s == "false"))
+    if(!was_quoted && !as_key && (s.is_number() || s == "true" || s == "null" || s == "false"))
     {
         this->Writer::_do_write(s);
+        return;
     }
-    else
+    // copy the runs of characters which need no escaping in bulk
+    size_t pos = 0; // tracks the last character that was already written
+    this->Writer::_do_write('"');
+    for(size_t i = detail::find_json_escape(s, 0); i != npos; i = detail::find_json_escape(s, i + 1))
     {
-        size_t pos = 0;
-        this->Writer::_do_write('"');
-        for(size_t i = 0; i < s.len; ++i)
-        {
-            if(s[i] == '"')
-            {
-                if(i > 0)
-                {
-                    csubstr sub = s.range(pos, i);
-                    this->Writer::_do_write(sub);
-                }
-                pos = i + 1;
-                this->Writer::_do_write("\\\"");
-            }
-        }
-        if(pos < s.len)
-        {
-            csubstr sub = s.sub(pos);
-            this->Writer::_do_write(sub);
-        }
-        this->Writer::_do_write('"');
+        if(i > pos)
+            this->Writer::_do_write(s.range(pos, i));
+        this->Writer::_do_write(detail::json_escape(s.str[i]));
+        pos = i + 1;
     }
+    if(pos < s.len)
+        this->Writer::_do_write(s.sub(pos));
+    this->Writer::_do_write('"');
 }
 
 } // namespace yml
@@ -13,6 +13,10 @@
 #include "./node.hpp"
 #endif
 
+#ifndef _C4_YML_DETAIL_SCALAR_SCAN_HPP_
+#include "./detail/scalar_scan.hpp"
+#endif
+
 namespace c4 {
 namespace yml {
 
@@ -21,11 +25,19 @@ template<class Writer> class Emitter;
 template<class OStream>
 using EmitterOStream = Emitter<WriterOStream<OStream>>;
 using EmitterFile = Emitter<WriterFile>;
+#ifdef RYML_HAS_WRITER_FD
+using EmitterFd   = Emitter<WriterFd>;
+#endif
 using EmitterBuf  = Emitter<WriterBuf>;
+using EmitterIovec = Emitter<WriterIovec>;
+template<class CharOwningContainer>
+using EmitterResizable = Emitter<WriterResizable<CharOwningContainer>>;
 
 typedef enum {
-    YAML = 0,
-    JSON = 1
+    YAML = 0,         ///< block style, except for containers marked FLOW_SL or FLOW_ML
+    JSON = 1,
+    YAML_FLOW_SL = 2, ///< flow style, each document in a single line: {a: 1, b: [c, d]}
+    YAML_FLOW_ML = 3, ///< flow style, with one container child per line
 } EmitType_e;
 
 
@@ -66,19 +78,66 @@ public:
     /** @overload */
     substr emit(EmitType_e type, NodeRef const& n, bool error_on_excess=true) { return emit(type, *n.tree(), n.id(), error_on_excess); }
 
+public:
+
+    /** @name partial emission
+     *
+     * Emit only a part of the YAML block output of a node. Emitting
+     * the node with emit_open() and then all its children with one or
+     * more calls to emit_children() produces the same output as
+     * emit(YAML, ...). This is used to split the emission of large
+     * trees, eg among threads (see emit_parallel.hpp).
+     *
+     * @{ */
+
+    /** emit the node @p id at the level @p ilevel, but not its
+     * children. On entry, @p do_indent is the indentation flag for
+     * the node, which is 1 when it starts a line. On exit, it is the
+     * flag to give to emit_children() for the first child, or NONE if
+     * the children are not to be emitted. */
+    substr emit_open(Tree const& t, size_t id, size_t ilevel, size_t *do_indent, bool error_on_excess=true);
+    /** emit the children of @p id in the range [first, end); @p end
+     * is NONE or a later sibling of @p first. @p ilevel is the level
+     * of @p id, and @p do_indent is the indentation flag returned by
+     * emit_open() if @p first is the first child, or 1 otherwise. */
+    substr emit_children(Tree const& t, size_t id, size_t first, size_t end, size_t ilevel, size_t do_indent, bool error_on_excess=true);
+
+    /** the indentation level of the children of a node at level @p ilevel */
+    static size_t child_level(Tree const& t, size_t id, size_t ilevel)
+    {
+        // do not indent at top level
+        return (t.is_stream(id) || t.is_doc(id) || t.is_root(id)) ? ilevel : ilevel + 1;
+    }
+
+    /** @} */
+
 private:
 
     void _do_visit(Tree const& t, size_t id, size_t ilevel=0, size_t do_indent=1);
+    size_t _do_visit_open(Tree const& t, size_t id, size_t ilevel, size_t do_indent);
+    void _do_visit_children(Tree const& t, size_t id, size_t first, size_t end, size_t ilevel, size_t do_indent);
+    bool _write_src_span(Tree const& t, size_t id, size_t ilevel);
     void _do_visit_json(Tree const& t, size_t id);
+    void _write_json_open(Tree const& t, size_t id);
+    void _write_json_close(Tree const& t, size_t id);
+    void _do_visit_flow_top(Tree const& t, size_t id, bool multiline);
+    void _do_visit_flow_sl(Tree const& t, size_t id);
+    void _do_visit_flow_ml(Tree const& t, size_t id, size_t ilevel);
 
-private:
+protected:
+
+    // scalar writers, also used by EventEmitter (see emit_events.hpp)
 
     void _write(NodeScalar const& sc, NodeType flags, size_t level);
     void _write_json(NodeScalar const& sc, NodeType flags);
+    void _write_flow(NodeScalar const& sc, NodeType flags);
+    bool _write_props(NodeScalar const& sc, NodeType flags);
 
     void _write_scalar(csubstr s, bool was_quoted);
     void _write_scalar_json(csubstr s, bool as_key, bool was_quoted);
     void _write_scalar_block(csubstr s, size_t level, bool as_key);
+    void _write_scalar_flow(csubstr s, bool was_quoted);
+    void _write_flow_container_open(Tree const& t, size_t id);
 
     void _write_tag(csubstr tag)
     {
@@ -102,6 +161,9 @@ private:
     C4_ALWAYS_INLINE void _writek(Tree const& t, size_t id, size_t level) { _write(t.keysc(id), t._p(id)->m_type.type & ~_valsc, level); }
     C4_ALWAYS_INLINE void _writev(Tree const& t, size_t id, size_t level) { _write(t.valsc(id), t._p(id)->m_type.type & ~_keysc, level); }
 
+    C4_ALWAYS_INLINE void _writek_flow(Tree const& t, size_t id) { _write_flow(t.keysc(id), t._p(id)->m_type.type & ~_valsc); }
+    C4_ALWAYS_INLINE void _writev_flow(Tree const& t, size_t id) { _write_flow(t.valsc(id), t._p(id)->m_type.type & ~_keysc); }
+
     C4_ALWAYS_INLINE void _writek_json(Tree const& t, size_t id) { _write_json(t.keysc(id), t._p(id)->m_type.type & ~(VAL)); }
     C4_ALWAYS_INLINE void _writev_json(Tree const& t, size_t id) { _write_json(t.valsc(id), t._p(id)->m_type.type & ~(KEY)); }
 
@@ -248,34 +310,22 @@ inline substr emit_json(NodeRef const& r, substr buf, bool error_on_excess=true)
 //-----------------------------------------------------------------------------
 
 /** emit+resize: YAML to the given std::string/std::vector-like container,
- * resizing it as needed to fit the emitted YAML. */
+ * resizing it as needed to fit the emitted YAML. The container is grown
+ * while emitting, so the tree is traversed only once. */
 template<class CharOwningContainer>
 substr emitrs(Tree const& t, size_t id, CharOwningContainer * cont)
 {
-    substr buf = to_substr(*cont);
-    substr ret = emit(t, id, buf, /*error_on_excess*/false);
-    if(ret.str == nullptr && ret.len > 0)
-    {
-        cont->resize(ret.len);
-        buf = to_substr(*cont);
-        ret = emit(t, id, buf, /*error_on_excess*/true);
-    }
-    return ret;
+    EmitterResizable<CharOwningContainer> em(cont);
+    return em.emit(YAML, t, id, /*error_on_excess*/true);
 }
 /** emit+resize: JSON to the given std::string/std::vector-like container,
- * resizing it as needed to fit the emitted JSON. */
+ * resizing it as needed to fit the emitted JSON. The container is grown
+ * while emitting, so the tree is traversed only once. */
 template<class CharOwningContainer>
 substr emitrs_json(Tree const& t, size_t id, CharOwningContainer * cont)
 {
-    substr buf = to_substr(*cont);
-    substr ret = emit_json(t, id, buf, /*error_on_excess*/false);
-    if(ret.str == nullptr && ret.len > 0)
-    {
-        cont->resize(ret.len);
-        buf = to_substr(*cont);
-        ret = emit_json(t, id, buf, /*error_on_excess*/true);
-    }
-    return ret;
+    EmitterResizable<CharOwningContainer> em(cont);
+    return em.emit(JSON, t, id, /*error_on_excess*/true);
 }
 
 /** emit+resize: YAML to the given std::string/std::vector-like container,
@@ -0,0 +1,340 @@
+#ifndef _C4_YML_EMIT_EVENTS_HPP_
+#define _C4_YML_EMIT_EVENTS_HPP_
+
+/** @file emit_events.hpp Emit YAML or JSON from a sequence of events
+ * (begin_map(), key(), val(), end_map(), ...), writing directly to the
+ * writer without building a tree.
+ *
+ * The output is the same as that of emitting (with Emitter::emit()) a
+ * tree holding the same nodes. */
+
+#ifndef _C4_YML_EMIT_HPP_
+#include "./emit.hpp"
+#endif
+
+#ifndef _C4_YML_DETAIL_STACK_HPP_
+#include "./detail/stack.hpp"
+#endif
+
+namespace c4 {
+namespace yml {
+
+template<class Writer> class EventEmitter;
+
+template<class OStream>
+using EventEmitterOStream = EventEmitter<WriterOStream<OStream>>;
+using EventEmitterFile = EventEmitter<WriterFile>;
+using EventEmitterBuf  = EventEmitter<WriterBuf>;
+template<class CharOwningContainer>
+using EventEmitterResizable = EventEmitter<WriterResizable<CharOwningContainer>>;
+/** the scalars are copied to the writer (see WriterIovec::m_copy_scalars) */
+using EventEmitterIovec = EventEmitter<WriterIovec>;
+
+namespace detail {
+/** prepare the writer for scalars which do not outlive the call */
+template<class Writer> void event_emitter_init_writer(Writer &) {}
+inline void event_emitter_init_writer(WriterIovec &w) { w.m_copy_scalars = true; }
+} // namespace detail
+
+
+/** Emit YAML (block style) or JSON from a sequence of events, tracking
+ * the indentation and separators as the events arrive. Only the stack
+ * of open containers is kept in memory; the scalars are written
+ * immediately, and need not outlive the call.
+ *
+ * @code
+ * std::string out;
+ * EventEmitterResizable<std::string> em(YAML, &out);
+ * em.begin_map();
+ *   em.key("a"); em.val("1");
+ *   em.key("b"); em.begin_seq();
+ *     em.val("x");
+ *     em.val("y");
+ *   em.end_seq();
+ * em.end_map();
+ * em.finish();
+ * // out == "a: 1\nb:\n  - x\n  - y\n"
+ * @endcode
+ *
+ * An event out of place (eg a val() in a map without a preceding
+ * key(), or end_seq() closing a map) is an error, reported through
+ * the error callback. */
+template<class Writer>
+class EventEmitter : public Emitter<Writer>
+{
+public:
+
+    /** @param type YAML or JSON
+     * @param args the arguments to construct the writer */
+    template<class ...Args>
+    explicit EventEmitter(EmitType_e type, Args&& ...args)
+        : Emitter<Writer>(static_cast<Args&&>(args)...)
+        , m_type(type)
+        , m_stack()
+        , m_has_root(false)
+    {
+        if(C4_UNLIKELY(type != YAML && type != JSON))
+        {
+            c4::yml::error("the event emitter writes only YAML or JSON");
+        }
+        detail::event_emitter_init_writer(static_cast<Writer&>(*this));
+    }
+
+public:
+
+    /** open a map, either at the root, as a seq item, or as the value
+     * of the key given just before */
+    void begin_map() { _begin_container(/*is_map*/true); }
+    /** open a seq, either at the root, as a seq item, or as the value
+     * of the key given just before */
+    void begin_seq() { _begin_container(/*is_map*/false); }
+
+    /** close the innermost container, which must be a map */
+    void end_map() { _end_container(/*is_map*/true); }
+    /** close the innermost container, which must be a seq */
+    void end_seq() { _end_container(/*is_map*/false); }
+
+    /** write the key of the next member of the current map. It must be
+     * followed by val(), begin_map() or begin_seq().
+     * @param quoted whether the key must be quoted */
+    void key(csubstr k, bool quoted=false);
+
+    /** write a scalar: as the value of the key given just before, as
+     * an item of the current seq, or as the root.
+     * @param quoted whether the scalar must be quoted (in JSON, this
+     * writes numbers, booleans and null as strings) */
+    void val(csubstr v, bool quoted=false);
+
+    /** finish the emission. All the containers must have been closed.
+     * Return the result from the writer: a substr of the emitted
+     * output when writing to a buffer, or a null substr with the
+     * number of bytes written when writing to a file. */
+    substr finish(bool error_on_excess=true);
+
+    /** the number of containers currently open */
+    size_t depth() const { return m_stack.size(); }
+
+private:
+
+    struct Frame
+    {
+        size_t level;      ///< the indentation level of the children
+        size_t num;        ///< the number of children begun so far
+        bool   is_map;
+        bool   has_key;    ///< map: a key was given and its value is pending
+        bool   inline_first; ///< YAML: the first child goes on the line of the dash
+        bool   pending;    ///< YAML: the line of the container was not finished yet
+    };
+
+    void _begin_container(bool is_map);
+    void _end_container(bool is_map);
+    void _begin_root();
+    void _begin_child();
+
+    EmitType_e m_type;
+    detail::stack<Frame> m_stack;
+    bool m_has_root;
+};
+
+
+//-----------------------------------------------------------------------------
+
+template<class Writer>
+void EventEmitter<Writer>::_begin_root()
+{
+    if(C4_UNLIKELY(m_has_root))
+    {
+        c4::yml::error("the root was already emitted");
+    }
+    m_has_root = true;
+}
+
+/** start a new child of the innermost container: a seq item, or the
+ * key of a map member */
+template<class Writer>
+void EventEmitter<Writer>::_begin_child()
+{
+    Frame &f = m_stack.top();
+    if(m_type == JSON)
+    {
+        if(f.num)
+            this->Writer::_do_write(',');
+    }
+    else
+    {
+        size_t do_indent = 1;
+        if(f.pending)
+        {
+            // the first child of a container opened by a key goes
+            // to the next line; the first child of a container opened
+            // by a dash goes on the same line
+            f.pending = false;
+            if(f.inline_first)
+            {
+                this->Writer::_do_write(' ');
+                do_indent = 0;
+            }
+            else
+            {
+                this->Writer::_do_write('\n');
+            }
+        }
+        this->Writer::_do_write(indent_to(do_indent * f.level));
+    }
+    ++f.num;
+}
+
+template<class Writer>
+void EventEmitter<Writer>::key(csubstr k, bool quoted)
+{
+    if(C4_UNLIKELY(m_stack.empty() || !m_stack.top().is_map || m_stack.top().has_key))
+    {
+        c4::yml::error("a key must be given in a map, before each value");
+    }
+    _begin_child();
+    m_stack.top().has_key = true;
+    const NodeType flags = NodeType_e(quoted ? (KEY|KEYQUO) : KEY);
+    if(m_type == JSON)
+    {
+        this->_write_json(NodeScalar(k), flags);
+        this->Writer::_do_write(": ");
+    }
+    else
+    {
+        this->_write(NodeScalar(k), flags, m_stack.top().level);
+    }
+}
+
+template<class Writer>
+void EventEmitter<Writer>::val(csubstr v, bool quoted)
+{
+    const NodeType flags = NodeType_e(quoted ? (VAL|VALQUO) : VAL);
+    if(m_stack.empty())
+    {
+        _begin_root();
+        if(m_type == JSON)
+        {
+            this->_write_json(NodeScalar(v), flags);
+        }
+        else
+        {
+            this->_write(NodeScalar(v), flags, 0);
+            this->Writer::_do_write('\n');
+        }
+        return;
+    }
+    Frame &f = m_stack.top();
+    if(f.is_map)
+    {
+        if(C4_UNLIKELY(!f.has_key))
+        {
+            c4::yml::error("a value in a map must be preceded by its key");
+        }
+        f.has_key = false;
+        if(m_type == JSON)
+        {
+            this->_write_json(NodeScalar(v), flags);
+        }
+        else
+        {
+            this->Writer::_do_write(": ");
+            this->_write(NodeScalar(v), flags, f.level);
+            this->Writer::_do_write('\n');
+        }
+    }
+    else
+    {
+        _begin_child();
+        if(m_type == JSON)
+        {
+            this->_write_json(NodeScalar(v), flags);
+        }
+        else
+        {
+            this->Writer::_do_write("- ");
+            this->_write(NodeScalar(v), flags, f.level);
+            this->Writer::_do_write('\n');
+        }
+    }
+}
+
+template<class Writer>
+void EventEmitter<Writer>::_begin_container(bool is_map)
+{
+    Frame child = {};
+    child.is_map = is_map;
+    if(m_stack.empty())
+    {
+        // do not indent at top level
+        _begin_root();
+        child.level = 0;
+    }
+    else
+    {
+        Frame &f = m_stack.top();
+        if(f.is_map)
+        {
+            if(C4_UNLIKELY(!f.has_key))
+            {
+                c4::yml::error("a value in a map must be preceded by its key");
+            }
+            f.has_key = false;
+            if(m_type != JSON)
+                this->Writer::_do_write(':');
+        }
+        else
+        {
+            _begin_child();
+            if(m_type != JSON)
+            {
+                this->Writer::_do_write('-');
+                child.inline_first = true;
+            }
+        }
+        child.level = f.level + 1;
+        child.pending = (m_type != JSON);
+    }
+    if(m_type == JSON)
+        this->Writer::_do_write(is_map ? '{' : '[');
+    m_stack.push(child);
+}
+
+template<class Writer>
+void EventEmitter<Writer>::_end_container(bool is_map)
+{
+    if(C4_UNLIKELY(m_stack.empty() || m_stack.top().is_map != is_map))
+    {
+        c4::yml::error(is_map ? "end_map() does not close a map" : "end_seq() does not close a seq");
+    }
+    Frame const& f = m_stack.top();
+    if(C4_UNLIKELY(f.has_key))
+    {
+        c4::yml::error("the last key of the map has no value");
+    }
+    if(m_type == JSON)
+    {
+        this->Writer::_do_write(is_map ? '}' : ']');
+    }
+    else if(f.num == 0)
+    {
+        if(m_stack.size() > 1)
+            this->Writer::_do_write(' ');
+        this->Writer::_do_write(is_map ? csubstr("{}\n") : csubstr("[]\n"));
+    }
+    m_stack.pop();
+}
+
+template<class Writer>
+substr EventEmitter<Writer>::finish(bool error_on_excess)
+{
+    if(C4_UNLIKELY(!m_stack.empty()))
+    {
+        c4::yml::error("there are containers which were not closed");
+    }
+    return this->Writer::_get(error_on_excess);
+}
+
+} // namespace yml
+} // namespace c4
+
+#endif /* _C4_YML_EMIT_EVENTS_HPP_ */
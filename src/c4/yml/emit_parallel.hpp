@@ -0,0 +1,342 @@
+#ifndef _C4_YML_EMIT_PARALLEL_HPP_
+#define _C4_YML_EMIT_PARALLEL_HPP_
+
+/** @file emit_parallel.hpp Emit YAML from large trees using several
+ * threads. This header is not included by ryml.hpp, as it requires the
+ * standard thread library (and linking with the platform's threads
+ * library).
+ *
+ * The top levels of the tree are partitioned into ranges of sibling
+ * nodes, which are emitted concurrently into separate buffers and then
+ * joined in order. The output is exactly the same as that of the
+ * (single-threaded) YAML emitter.
+ *
+ * An exception thrown in a worker thread (eg by an error callback
+ * which throws) is rethrown in the calling thread, after all the
+ * workers have finished. */
+
+#ifndef _C4_YML_EMIT_HPP_
+#include "./emit.hpp"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define _RYML_EMIT_PARALLEL_EXCEPTIONS
+#endif
+
+namespace c4 {
+namespace yml {
+
+namespace detail {
+
+/** a part of the output: either the opening of a node, emitted when
+ * planning (first==NONE), or a range of siblings to be emitted by a
+ * worker thread */
+template<class CharOwningContainer>
+struct EmitPart
+{
+    size_t parent;
+    size_t first;
+    size_t end;
+    size_t ilevel;
+    size_t do_indent;
+    CharOwningContainer out;
+};
+
+
+/** partition the emission of a tree into parts, and emit the parts
+ * using several threads */
+template<class CharOwningContainer>
+struct EmitParallel
+{
+    using part_type = EmitPart<CharOwningContainer>;
+    using emitter_type = EmitterResizable<CharOwningContainer>;
+
+    Tree const* m_tree;
+    std::vector<part_type> m_parts;
+    std::vector<char> m_done; ///< guarded by m_mutex
+    std::exception_ptr m_error; ///< guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic<size_t> m_next;
+    std::atomic<bool> m_stop;
+
+    EmitParallel(Tree const& t, size_t id, size_t num_threads) : m_tree(&t), m_parts(), m_done(), m_error(), m_mutex(), m_cv(), m_next(0), m_stop(false)
+    {
+        // use more parts than threads to even out the differences
+        // in the size of the parts
+        _plan(id, 0, 1, 4 * num_threads);
+        m_done.resize(m_parts.size());
+        for(size_t i = 0; i < m_parts.size(); ++i)
+            m_done[i] = (m_parts[i].first == NONE);
+    }
+
+    /** joins the workers when leaving run(), also when the function
+     * throws; the workers stop after their current part */
+    struct _joiner
+    {
+        EmitParallel *ep;
+        std::vector<std::thread> workers;
+        ~_joiner()
+        {
+            ep->m_stop.store(true);
+            for(std::thread &w : workers)
+                if(w.joinable())
+                    w.join();
+        }
+    };
+
+    /** start the workers, and call the function in this thread for
+     * each part, in order, as soon as the part is ready. If a worker
+     * threw an exception, it is rethrown here once all the workers
+     * are joined. */
+    template<class Fn>
+    void run(size_t num_threads, Fn &&fn)
+    {
+        {
+            _joiner joiner{this, {}};
+            joiner.workers.reserve(num_threads);
+            for(size_t i = 0; i < num_threads; ++i)
+                joiner.workers.emplace_back([this]{ this->_work(); });
+            for(size_t i = 0; i < m_parts.size(); ++i)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cv.wait(lock, [this, i]{ return m_done[i] || m_error; });
+                    if(m_error)
+                        break;
+                }
+                fn(m_parts[i]);
+            }
+        }
+        if(m_error)
+            std::rethrow_exception(m_error);
+    }
+
+    void _work()
+    {
+        #ifdef _RYML_EMIT_PARALLEL_EXCEPTIONS
+        try
+        {
+        #endif
+            for(size_t i = m_next++; i < m_parts.size() && !m_stop.load(); i = m_next++)
+            {
+                part_type &p = m_parts[i];
+                if(p.first == NONE)
+                    continue;
+                emitter_type em(&p.out);
+                em.emit_children(*m_tree, p.parent, p.first, p.end, p.ilevel, p.do_indent);
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done[i] = true;
+                }
+                m_cv.notify_all();
+            }
+        #ifdef _RYML_EMIT_PARALLEL_EXCEPTIONS
+        }
+        catch(...)
+        {
+            m_stop.store(true);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if( ! m_error)
+                    m_error = std::current_exception();
+            }
+            m_cv.notify_all();
+        }
+        #endif
+    }
+
+    /** nodes deeper than this are not split further; their children
+     * are emitted in a single range */
+    static constexpr size_t max_plan_depth = 8;
+
+    /** a node waiting to be planned */
+    struct _plan_item
+    {
+        size_t id;
+        size_t ilevel;
+        size_t do_indent;
+        size_t num_parts;
+        size_t depth;
+    };
+
+    void _plan(size_t id, size_t ilevel, size_t do_indent, size_t num_parts)
+    {
+        Tree const& t = *m_tree;
+        // visit depth-first with an explicit stack, so that the parts
+        // are added in the order of the output
+        std::vector<_plan_item> pending;
+        pending.push_back(_plan_item{id, ilevel, do_indent, num_parts, 0});
+        while( ! pending.empty())
+        {
+            const _plan_item item = pending.back();
+            pending.pop_back();
+            id = item.id;
+            ilevel = item.ilevel;
+            do_indent = item.do_indent;
+            num_parts = item.num_parts;
+            {
+                m_parts.emplace_back();
+                part_type &open = m_parts.back();
+                open.first = NONE;
+                emitter_type em(&open.out);
+                em.emit_open(t, id, ilevel, &do_indent);
+            }
+            if(do_indent == NONE)
+                continue;
+            const size_t num = t.num_children(id);
+            if(num == 0)
+                continue;
+            if(num_parts <= 1 || num >= num_parts || item.depth >= max_plan_depth)
+            {
+                // split the children into ranges of (nearly) equal
+                // count. Past the maximum depth, eg in a long chain of
+                // single children, emit all the children in one range.
+                const size_t num_ranges = (num_parts > 1 && item.depth < max_plan_depth) ? num_parts : 1;
+                const size_t per_range = num / num_ranges;
+                size_t remainder = num % num_ranges;
+                size_t ich = t.first_child(id);
+                for(size_t r = 0; r < num_ranges; ++r)
+                {
+                    size_t count = per_range + (remainder ? 1 : 0);
+                    if(remainder)
+                        --remainder;
+                    size_t end = ich;
+                    for(size_t i = 0; i < count; ++i)
+                        end = t.next_sibling(end);
+                    _add_range(id, ich, end, ilevel, do_indent);
+                    do_indent = 1;
+                    ich = end;
+                }
+                RYML_ASSERT(ich == NONE);
+            }
+            else
+            {
+                // too few children: go down one level. Push the
+                // children in reverse, so that they are popped in
+                // order.
+                const size_t child_parts = (num_parts + num - 1) / num;
+                const size_t clevel = emitter_type::child_level(t, id, ilevel);
+                const size_t first = t.first_child(id);
+                for(size_t ich = t.last_child(id); ich != NONE; ich = t.prev_sibling(ich))
+                    pending.push_back(_plan_item{ich, clevel, ich == first ? do_indent : 1, child_parts, item.depth + 1});
+            }
+        }
+    }
+
+    void _add_range(size_t parent, size_t first, size_t end, size_t ilevel, size_t do_indent)
+    {
+        m_parts.emplace_back();
+        part_type &p = m_parts.back();
+        p.parent = parent;
+        p.first = first;
+        p.end = end;
+        p.ilevel = ilevel;
+        p.do_indent = do_indent;
+    }
+};
+
+inline size_t emit_parallel_num_threads(size_t num_threads)
+{
+    if(num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    return num_threads ? num_threads : 1;
+}
+
+} // namespace detail
+
+
+//-----------------------------------------------------------------------------
+
+/** emit+resize: YAML to the given std::string/std::vector-like container,
+ * using several threads. The output is the same as that of emitrs().
+ * @param num_threads the number of worker threads. Zero means
+ * std::thread::hardware_concurrency(). */
+template<class CharOwningContainer>
+substr emitrs_parallel(Tree const& t, size_t id, CharOwningContainer * cont, size_t num_threads=0)
+{
+    num_threads = detail::emit_parallel_num_threads(num_threads);
+    if(num_threads == 1)
+        return emitrs(t, id, cont);
+    detail::EmitParallel<CharOwningContainer> ep(t, id, num_threads);
+    const size_t initial_size = cont->size();
+    size_t total = 0;
+    ep.run(num_threads, [&](typename detail::EmitParallel<CharOwningContainer>::part_type &p){
+        csubstr s = to_csubstr(p.out);
+        if(total + s.len > cont->size())
+            cont->resize(total + s.len > 2 * cont->size() ? total + s.len : 2 * cont->size());
+        if(s.len)
+            memcpy(to_substr(*cont).str + total, s.str, s.len);
+        total += s.len;
+        CharOwningContainer().swap(p.out); // release the memory early
+    });
+    // like emitrs(): resize only if the container had to grow
+    if(cont->size() != initial_size)
+        cont->resize(total > initial_size ? total : initial_size);
+    return to_substr(*cont).first(total);
+}
+
+/** emit+resize: YAML to the given std::string/std::vector-like container,
+ * using several threads. The output is the same as that of emitrs().
+ * @overload */
+template<class CharOwningContainer>
+substr emitrs_parallel(Tree const& t, CharOwningContainer * cont, size_t num_threads=0)
+{
+    return emitrs_parallel(t, t.root_id(), cont, num_threads);
+}
+
+/** emit+resize: YAML to a newly created std::string/std::vector-like
+ * container, using several threads.
+ * @overload */
+template<class CharOwningContainer>
+CharOwningContainer emitrs_parallel(Tree const& t, size_t num_threads=0)
+{
+    CharOwningContainer c;
+    emitrs_parallel(t, t.root_id(), &c, num_threads);
+    return c;
+}
+
+/** emit YAML to the given file using several threads. The parts of the
+ * output are written in order as soon as they are ready, and then
+ * released, so the whole output is never held in memory at once.
+ * A null file defaults to stdout. Return the number of bytes written.
+ * @param num_threads the number of worker threads. Zero means
+ * std::thread::hardware_concurrency(). */
+inline size_t emit_parallel(Tree const& t, size_t id, FILE *f, size_t num_threads=0)
+{
+    num_threads = detail::emit_parallel_num_threads(num_threads);
+    if(num_threads == 1)
+        return emit(t, id, f);
+    if(f == nullptr)
+        f = stdout;
+    detail::EmitParallel<std::vector<char>> ep(t, id, num_threads);
+    size_t total = 0;
+    ep.run(num_threads, [&](detail::EmitPart<std::vector<char>> &p){
+        if(!p.out.empty())
+            fwrite(p.out.data(), 1, p.out.size(), f);
+        total += p.out.size();
+        std::vector<char>().swap(p.out); // release the memory early
+    });
+    return total;
+}
+
+/** emit YAML to the given file using several threads.
+ * @overload */
+inline size_t emit_parallel(Tree const& t, FILE *f=nullptr, size_t num_threads=0)
+{
+    return emit_parallel(t, t.root_id(), f, num_threads);
+}
+
+} // namespace yml
+} // namespace c4
+
+#undef _RYML_EMIT_PARALLEL_EXCEPTIONS
+
+#endif /* _C4_YML_EMIT_PARALLEL_HPP_ */
@@ -179,6 +179,9 @@ public:
     C4_ALWAYS_INLINE bool is_key_quoted()    const { _C4RV(); return m_tree->is_key_quoted(m_id); }
     C4_ALWAYS_INLINE bool is_val_quoted()    const { _C4RV(); return m_tree->is_val_quoted(m_id); }
     C4_ALWAYS_INLINE bool is_quoted()        const { _C4RV(); return m_tree->is_quoted(m_id); }
+    C4_ALWAYS_INLINE bool is_flow_sl()       const { _C4RV(); return m_tree->is_flow_sl(m_id); }
+    C4_ALWAYS_INLINE bool is_flow_ml()       const { _C4RV(); return m_tree->is_flow_ml(m_id); }
+    C4_ALWAYS_INLINE bool is_flow()          const { _C4RV(); return m_tree->is_flow(m_id); }
 
     C4_ALWAYS_INLINE bool parent_is_seq()    const { _C4RV(); return m_tree->parent_is_seq(m_id); }
     C4_ALWAYS_INLINE bool parent_is_map()    const { _C4RV(); return m_tree->parent_is_map(m_id); }
@@ -223,7 +226,7 @@ public:
     NodeRef       next_sibling()       { _C4RV(); return {m_tree, m_tree->next_sibling(m_id)}; }
     NodeRef const next_sibling() const { _C4RV(); return {m_tree, m_tree->next_sibling(m_id)}; }
 
-    /** O(#num_children) */
+    /** O(1) */
     size_t  num_children() const { _C4RV(); return m_tree->num_children(m_id); }
     size_t  child_pos(NodeRef const& n) const { _C4RV(); return m_tree->child_pos(m_id, n.m_id); }
     NodeRef       first_child()       { _C4RV(); return {m_tree, m_tree->first_child(m_id)}; }
@@ -235,7 +238,7 @@ public:
     NodeRef       find_child(csubstr name)       { _C4RV(); return {m_tree, m_tree->find_child(m_id, name)}; }
     NodeRef const find_child(csubstr name) const { _C4RV(); return {m_tree, m_tree->find_child(m_id, name)}; }
 
-    /** O(#num_siblings) */
+    /** O(1) */
     size_t  num_siblings() const { _C4RV(); return m_tree->num_siblings(m_id); }
     size_t  num_other_siblings() const { _C4RV(); return m_tree->num_other_siblings(m_id); }
     size_t  sibling_pos(NodeRef const& n) const { _C4RV(); return m_tree->child_pos(m_tree->parent(m_id), n.m_id); }
@@ -300,6 +303,7 @@ public:
         if(is_seed())
             return;
         m_tree->remove_children(m_id);
+        m_tree->_src_dirty(m_id);
         m_tree->_clear(m_id);
     }
 
@@ -637,6 +641,26 @@ public:
         return r;
     }
 
+    /** append num children with values serialized from the given
+     * array, in a single pass.
+     * @see Tree::append_children_serialized() */
+    template<class T>
+    inline void append_children_serialized(T const* C4_RESTRICT vals, size_t num)
+    {
+        _C4RV();
+        m_tree->append_children_serialized(m_id, vals, num);
+    }
+
+    /** deserialize the first num children into the given array, in
+     * a single pass.
+     * @see Tree::deserialize_children() */
+    template<class T>
+    inline bool deserialize_children(T *C4_RESTRICT vals, size_t num) const
+    {
+        _C4RV();
+        return m_tree->deserialize_children(m_id, vals, num);
+    }
+
 public:
 
     inline NodeRef insert_sibling(NodeRef const after)
@@ -886,6 +910,36 @@ inline read(NodeRef const& n, T *v)
     return from_chars_float(n.val(), v);
 }
 
+namespace detail {
+/** whether a map key of type K can be constructed straight from the
+ * characters of the key in the tree, as std::string, std::string_view
+ * or csubstr can. Keys which view the characters (string_view, csubstr)
+ * are only valid while the tree is alive and unchanged. */
+template<class K>
+using is_key_constructible_from_chars = std::is_constructible<K, const char*, size_t>;
+
+/** the key of a map child as a K, constructed from the characters of
+ * the key where K allows it, and deserialized otherwise. The std map
+ * adapters use this, to avoid a default construction and assignment
+ * per key. */
+template<class K>
+typename std::enable_if<is_key_constructible_from_chars<K>::value, K>::type
+read_key(NodeRef const& ch)
+{
+    const csubstr k = ch.key();
+    return K(k.str, k.len);
+}
+
+template<class K>
+typename std::enable_if< ! is_key_constructible_from_chars<K>::value, K>::type
+read_key(NodeRef const& ch)
+{
+    K k{};
+    ch >> key(k);
+    return k;
+}
+} // namespace detail
+
 
 //-----------------------------------------------------------------------------
 template<class Visitor>
@@ -98,6 +98,59 @@ size_t count_following_newlines(csubstr r, size_t *C4_RESTRICT i, size_t indenta
 } // anon namespace
 
 
+//-----------------------------------------------------------------------------
+
+const char* ParserProfile::phase_name(ParserPhase_e p)
+{
+    switch(p)
+    {
+    case PARSER_PHASE_PARSE: return "parse";
+    case PARSER_PHASE_HANDLE_LINE: return "handle_line";
+    case PARSER_PHASE_HANDLE_INDENTATION: return "handle_indentation";
+    case PARSER_PHASE_HANDLE_UNK: return "handle_unk";
+    case PARSER_PHASE_HANDLE_TOP: return "handle_top";
+    case PARSER_PHASE_HANDLE_MAP_EXPL: return "handle_map_expl";
+    case PARSER_PHASE_HANDLE_MAP_IMPL: return "handle_map_impl";
+    case PARSER_PHASE_HANDLE_SEQ_EXPL: return "handle_seq_expl";
+    case PARSER_PHASE_HANDLE_SEQ_IMPL: return "handle_seq_impl";
+    case PARSER_PHASE_HANDLE_TYPES: return "handle_types";
+    case PARSER_PHASE_HANDLE_ANCHORS_AND_REFS: return "handle_anchors_and_refs";
+    case PARSER_PHASE_SCAN_SCALAR: return "scan_scalar";
+    case PARSER_PHASE_SCAN_PLAIN_SCALAR: return "scan_plain_scalar";
+    case PARSER_PHASE_SCAN_SQUOT_SCALAR: return "scan_squot_scalar";
+    case PARSER_PHASE_SCAN_DQUOT_SCALAR: return "scan_dquot_scalar";
+    case PARSER_PHASE_SCAN_BLOCK: return "scan_block";
+    case PARSER_PHASE_SCAN_COMMENT: return "scan_comment";
+    case PARSER_PHASE_FILTER_PLAIN_SCALAR: return "filter_plain_scalar";
+    case PARSER_PHASE_FILTER_SQUOT_SCALAR: return "filter_squot_scalar";
+    case PARSER_PHASE_FILTER_DQUOT_SCALAR: return "filter_dquot_scalar";
+    case PARSER_PHASE_FILTER_BLOCK_SCALAR: return "filter_block_scalar";
+    default: return "unknown";
+    }
+}
+
+size_t ParserProfile::report(substr buf) const
+{
+    const uint64_t total = phases[PARSER_PHASE_PARSE].ticks;
+    size_t pos = 0;
+    char line[128];
+    for(size_t i = 0; i < (size_t)PARSER_NUM_PHASES; ++i)
+    {
+        Phase const& ph = phases[i];
+        if(!ph.calls)
+            continue;
+        const double pct = total ? 100. * (double)ph.ticks / (double)total : 0.;
+        int len = snprintf(line, sizeof(line), "%-24s %12zu %16llu %6.2f%%\n",
+                           phase_name((ParserPhase_e)i), ph.calls, (unsigned long long)ph.ticks, pct);
+        RYML_ASSERT(len > 0 && (size_t)len < sizeof(line));
+        if(pos < buf.len)
+            memcpy(buf.str + pos, line, (size_t)len <= buf.len - pos ? (size_t)len : buf.len - pos);
+        pos += (size_t)len;
+    }
+    return pos;
+}
+
+
 //-----------------------------------------------------------------------------
 
 Parser::~Parser()
@@ -289,7 +342,7 @@ void Parser::_free()
 {
     if(m_newline_offsets)
     {
-        _RYML_CB_FREE(m_stack.m_callbacks, m_newline_offsets, size_t, m_newline_offsets_capacity);
+        _RYML_CB_FREE_SITE(m_stack.m_callbacks, m_newline_offsets, size_t, m_newline_offsets_capacity, ALLOC_SITE_LOCATIONS);
         m_newline_offsets = nullptr;
         m_newline_offsets_size = 0u;
         m_newline_offsets_capacity = 0u;
@@ -297,7 +350,7 @@ void Parser::_free()
     }
     if(m_filter_arena.len)
     {
-        _RYML_CB_FREE(m_stack.m_callbacks, m_filter_arena.str, char, m_filter_arena.len);
+        _RYML_CB_FREE_SITE(m_stack.m_callbacks, m_filter_arena.str, char, m_filter_arena.len, ALLOC_SITE_FILTER_ARENA);
         m_filter_arena = {};
     }
     m_stack._free();
@@ -349,6 +402,7 @@ bool Parser::_finished_line() const
 //-----------------------------------------------------------------------------
 void Parser::parse_in_place(csubstr file, substr buf, Tree *t, size_t node_id)
 {
+    _c4prof(PARSER_PHASE_PARSE);
     m_file = file;
     m_buf = buf;
     m_root_id = node_id;
@@ -375,6 +429,7 @@ void Parser::_handle_finished_file()
 //-----------------------------------------------------------------------------
 void Parser::_handle_line()
 {
+    _c4prof(PARSER_PHASE_HANDLE_LINE);
     _c4dbgq("\n-----------");
     _c4dbgt("handling line=%zu, offset=%zuB", m_state->pos.line, m_state->pos.offset);
     _RYML_CB_ASSERT(m_stack.m_callbacks,  ! m_state->line_contents.rem.empty());
@@ -418,6 +473,7 @@ void Parser::_handle_line()
 //-----------------------------------------------------------------------------
 bool Parser::_handle_unk()
 {
+    _c4prof(PARSER_PHASE_HANDLE_UNK);
     _c4dbgp("handle_unk");
 
     csubstr rem = m_state->line_contents.rem;
@@ -738,6 +794,7 @@ bool Parser::_handle_unk()
 //-----------------------------------------------------------------------------
 bool Parser::_handle_seq_expl()
 {
+    _c4prof(PARSER_PHASE_HANDLE_SEQ_EXPL);
     _c4dbgpf("handle_seq_expl: node_id=%zd level=%zd", m_state->node_id, m_state->level);
     csubstr rem = m_state->line_contents.rem;
 
@@ -902,6 +959,7 @@ bool Parser::_handle_seq_expl()
 //-----------------------------------------------------------------------------
 bool Parser::_handle_seq_impl()
 {
+    _c4prof(PARSER_PHASE_HANDLE_SEQ_IMPL);
     _c4dbgpf("handle_seq_impl: node_id=%zd level=%zd", m_state->node_id, m_state->level);
     csubstr rem = m_state->line_contents.rem;
 
@@ -1153,6 +1211,7 @@ bool Parser::_rval_dash_start_or_continue_seq()
 //-----------------------------------------------------------------------------
 bool Parser::_handle_map_expl()
 {
+    _c4prof(PARSER_PHASE_HANDLE_MAP_EXPL);
     // explicit flow, ie, inside {}, separated by commas
     _c4dbgpf("handle_map_expl: node_id=%zd  level=%zd", m_state->node_id, m_state->level);
     csubstr rem = m_state->line_contents.rem;
@@ -1435,6 +1494,7 @@ bool Parser::_handle_map_expl()
 //-----------------------------------------------------------------------------
 bool Parser::_handle_map_impl()
 {
+    _c4prof(PARSER_PHASE_HANDLE_MAP_IMPL);
     _c4dbgpf("handle_map_impl: node_id=%zd  level=%zd", m_state->node_id, m_state->level);
     csubstr rem = m_state->line_contents.rem;
 
@@ -1711,6 +1771,7 @@ bool Parser::_handle_map_impl()
 //-----------------------------------------------------------------------------
 bool Parser::_handle_top()
 {
+    _c4prof(PARSER_PHASE_HANDLE_TOP);
     _c4dbgp("handle_top");
     csubstr rem = m_state->line_contents.rem;
 
@@ -1763,6 +1824,7 @@ bool Parser::_handle_top()
 
 bool Parser::_handle_key_anchors_and_refs()
 {
+    _c4prof(PARSER_PHASE_HANDLE_ANCHORS_AND_REFS);
     _RYML_CB_ASSERT(m_stack.m_callbacks, !has_any(RVAL));
     const csubstr rem = m_state->line_contents.rem;
     if(rem.begins_with('&'))
@@ -1796,6 +1858,7 @@ bool Parser::_handle_key_anchors_and_refs()
 
 bool Parser::_handle_val_anchors_and_refs()
 {
+    _c4prof(PARSER_PHASE_HANDLE_ANCHORS_AND_REFS);
     _RYML_CB_ASSERT(m_stack.m_callbacks, !has_any(RKEY));
     const csubstr rem = m_state->line_contents.rem;
     if(rem.begins_with('&'))
@@ -1921,6 +1984,7 @@ void Parser::_move_key_tag2_to_key_tag()
 
 bool Parser::_handle_types()
 {
+    _c4prof(PARSER_PHASE_HANDLE_TYPES);
     csubstr rem = m_state->line_contents.rem.triml(' ');
     csubstr t;
 
@@ -2165,6 +2229,7 @@ csubstr Parser::_slurp_doc_scalar()
 //-----------------------------------------------------------------------------
 bool Parser::_scan_scalar(csubstr *C4_RESTRICT scalar, bool *C4_RESTRICT quoted)
 {
+    _c4prof(PARSER_PHASE_SCAN_SCALAR);
     csubstr s = m_state->line_contents.rem;
     if(s.len == 0)
         return false;
@@ -2409,6 +2474,7 @@ csubstr Parser::_extend_scanned_scalar(csubstr s)
 
 substr Parser::_scan_plain_scalar_expl(csubstr currscalar, csubstr peeked_line)
 {
+    _c4prof(PARSER_PHASE_SCAN_PLAIN_SCALAR);
     static constexpr const csubstr chars = "[]{}?#,";
     size_t pos = peeked_line.first_of(chars);
     bool first = true;
@@ -2467,6 +2533,7 @@ substr Parser::_scan_plain_scalar_expl(csubstr currscalar, csubstr peeked_line)
 
 substr Parser::_scan_plain_scalar_impl(csubstr currscalar, csubstr peeked_line, size_t indentation)
 {
+    _c4prof(PARSER_PHASE_SCAN_PLAIN_SCALAR);
     _RYML_CB_ASSERT(m_stack.m_callbacks, m_buf.is_super(currscalar));
     // NOTE. there's a problem with _scan_to_next_nonempty_line(), as it counts newlines twice
     // size_t offs = m_state->pos.offset;   // so we workaround by directly counting from the end of the given scalar
@@ -3408,6 +3475,7 @@ void Parser::_move_scalar_from_top()
 //-----------------------------------------------------------------------------
 bool Parser::_handle_indentation()
 {
+    _c4prof(PARSER_PHASE_HANDLE_INDENTATION);
     _RYML_CB_ASSERT(m_stack.m_callbacks, has_none(EXPL));
     if( ! _at_line_begin())
         return false;
@@ -3579,6 +3647,7 @@ bool Parser::_handle_indentation()
 //-----------------------------------------------------------------------------
 csubstr Parser::_scan_comment()
 {
+    _c4prof(PARSER_PHASE_SCAN_COMMENT);
     csubstr s = m_state->line_contents.rem;
     _RYML_CB_ASSERT(m_stack.m_callbacks, s.begins_with('#'));
     _line_progressed(s.len);
@@ -3593,6 +3662,7 @@ csubstr Parser::_scan_comment()
 //-----------------------------------------------------------------------------
 csubstr Parser::_scan_squot_scalar()
 {
+    _c4prof(PARSER_PHASE_SCAN_SQUOT_SCALAR);
     // quoted scalars can spread over multiple lines!
     // nice explanation here: http://yaml-multiline.info/
 
@@ -3699,6 +3769,7 @@ csubstr Parser::_scan_squot_scalar()
 //-----------------------------------------------------------------------------
 csubstr Parser::_scan_dquot_scalar()
 {
+    _c4prof(PARSER_PHASE_SCAN_DQUOT_SCALAR);
     // quoted scalars can spread over multiple lines!
     // nice explanation here: http://yaml-multiline.info/
 
@@ -3806,6 +3877,7 @@ csubstr Parser::_scan_dquot_scalar()
 //-----------------------------------------------------------------------------
 csubstr Parser::_scan_block()
 {
+    _c4prof(PARSER_PHASE_SCAN_BLOCK);
     // nice explanation here: http://yaml-multiline.info/
     csubstr s = m_state->line_contents.rem;
     csubstr trimmed = s.triml(" ");
@@ -4104,6 +4176,7 @@ void Parser::_filter_ws(substr r, size_t *C4_RESTRICT i, size_t *C4_RESTRICT pos
 //-----------------------------------------------------------------------------
 csubstr Parser::_filter_plain_scalar(substr s, size_t indentation)
 {
+    _c4prof(PARSER_PHASE_FILTER_PLAIN_SCALAR);
     // a debugging scaffold:
     #if 0
     #define _c4dbgfps(...) _c4dbgpf("filt_plain_scalar" __VA_ARGS__)
@@ -4157,6 +4230,7 @@ csubstr Parser::_filter_plain_scalar(substr s, size_t indentation)
 //-----------------------------------------------------------------------------
 csubstr Parser::_filter_squot_scalar(substr s)
 {
+    _c4prof(PARSER_PHASE_FILTER_SQUOT_SCALAR);
     // a debugging scaffold:
     #if 0
     #define _c4dbgfsq(...) _c4dbgpf("filt_squo_scalar")
@@ -4224,6 +4298,7 @@ csubstr Parser::_filter_squot_scalar(substr s)
 //-----------------------------------------------------------------------------
 csubstr Parser::_filter_dquot_scalar(substr s)
 {
+    _c4prof(PARSER_PHASE_FILTER_DQUOT_SCALAR);
     // a debugging scaffold:
     #if 0
     #define _c4dbgfdq(...) _c4dbgpf("filt_dquo_scalar")
@@ -4360,6 +4435,7 @@ csubstr Parser::_filter_dquot_scalar(substr s)
 //-----------------------------------------------------------------------------
 csubstr Parser::_filter_block_scalar(substr s, BlockStyle_e style, BlockChomp_e chomp, size_t indentation)
 {
+    _c4prof(PARSER_PHASE_FILTER_BLOCK_SCALAR);
     // a debugging scaffold:
     #if 0
     #define _c4dbgfbl _c4dbgpf
@@ -4827,9 +4903,9 @@ void Parser::_resize_filter_arena(size_t num_characters)
         if(m_filter_arena.str)
         {
             _RYML_CB_ASSERT(m_stack.m_callbacks, m_filter_arena.len > 0);
-            _RYML_CB_FREE(m_stack.m_callbacks, m_filter_arena.str, char, m_filter_arena.len);
+            _RYML_CB_FREE_SITE(m_stack.m_callbacks, m_filter_arena.str, char, m_filter_arena.len, ALLOC_SITE_FILTER_ARENA);
         }
-        m_filter_arena.str = _RYML_CB_ALLOC_HINT(m_stack.m_callbacks, char, num_characters, prev);
+        m_filter_arena.str = _RYML_CB_ALLOC_SITE(m_stack.m_callbacks, char, num_characters, prev, ALLOC_SITE_FILTER_ARENA);
         m_filter_arena.len = num_characters;
     }
 }
@@ -4995,8 +5071,8 @@ void Parser::_resize_locations(size_t numnewlines) const
     if(numnewlines > m_newline_offsets_capacity)
     {
         if(m_newline_offsets)
-            _RYML_CB_FREE(m_stack.m_callbacks, m_newline_offsets, size_t, m_newline_offsets_capacity);
-        m_newline_offsets = _RYML_CB_ALLOC_HINT(m_stack.m_callbacks, size_t, numnewlines, m_newline_offsets);
+            _RYML_CB_FREE_SITE(m_stack.m_callbacks, m_newline_offsets, size_t, m_newline_offsets_capacity, ALLOC_SITE_LOCATIONS);
+        m_newline_offsets = _RYML_CB_ALLOC_SITE(m_stack.m_callbacks, size_t, numnewlines, m_newline_offsets, ALLOC_SITE_LOCATIONS);
         m_newline_offsets_capacity = numnewlines;
     }
 }
@@ -5012,6 +5088,310 @@ bool Parser::_locations_dirty() const
     return !m_newline_offsets_size;
 }
 
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace {
+
+/** find the spans of the container nodes in the original source of a
+ * tree. The tree was parsed from a copy of the source, so the offset
+ * of a scalar in the copy is also its offset in the source.
+ *
+ * A span is given only to the block containers whose first token
+ * starts a line (or follows a single "- " marker). The span ends at
+ * the first following line with the same or less indentation which
+ * is not blank or a comment, and it is kept only if that line is
+ * exactly where the next node starts, or if there are no more nodes
+ * in the document. Any doubt results in no span, and the node is then
+ * re-serialized by the emitter. */
+struct SrcSpanFinder
+{
+    struct Candidate
+    {
+        size_t node;
+        size_t begin;
+        size_t end;
+        size_t indentation;
+        bool   seq_with_key; // its items may be at the indentation of the key
+    };
+    struct Frame
+    {
+        size_t node;
+        bool   block;
+    };
+
+    Tree *C4_RESTRICT m_tree;
+    csubstr m_copy; // the copy where the tree was parsed
+    csubstr m_src;  // the original source
+    detail::stack<Candidate> m_candidates;
+
+    SrcSpanFinder(Tree *t, csubstr copy, csubstr src)
+        : m_tree(t)
+        , m_copy(copy)
+        , m_src(src)
+        , m_candidates(t->callbacks())
+    {
+        RYML_ASSERT(copy.len == src.len);
+    }
+
+    void run()
+    {
+        _find_candidates();
+        _find_ends();
+        for(Candidate const& c : m_candidates)
+        {
+            if(c.end != NONE && _is_end_ok(c))
+                m_tree->set_src_span(c.node, c.begin, c.end, c.indentation);
+        }
+    }
+
+    /** offset of the first token of a node in the source, or NONE */
+    size_t _first_token(size_t node) const
+    {
+        while(!m_tree->has_key(node) && !m_tree->has_val(node))
+        {
+            node = m_tree->first_child(node);
+            if(node == NONE)
+                return NONE;
+        }
+        csubstr s;
+        bool quoted;
+        if(m_tree->has_key(node))
+        {
+            if(m_tree->is_key_ref(node))
+                return NONE;
+            s = m_tree->key(node);
+            quoted = m_tree->is_key_quoted(node);
+        }
+        else
+        {
+            if(m_tree->is_val_ref(node))
+                return NONE;
+            s = m_tree->val(node);
+            quoted = m_tree->is_val_quoted(node);
+        }
+        if(s.str == nullptr || !m_copy.is_super(s) || s.str == m_copy.end())
+            return NONE;
+        size_t pos = static_cast<size_t>(s.str - m_copy.str);
+        if(quoted)
+        {
+            if(pos == 0 || (m_src.str[pos-1] != '"' && m_src.str[pos-1] != '\''))
+                return NONE;
+            --pos;
+        }
+        return pos;
+    }
+
+    size_t _line_begin(size_t pos) const
+    {
+        while(pos > 0 && m_src.str[pos-1] != '\n')
+            --pos;
+        return pos;
+    }
+
+    /** in flow style, a child follows an opening bracket or a comma */
+    bool _is_block(size_t node) const
+    {
+        bool first = true;
+        for(size_t ch = m_tree->first_child(node); ch != NONE; ch = m_tree->next_sibling(ch), first = false)
+        {
+            if(!m_tree->has_key(ch) && !m_tree->has_val(ch))
+                continue;
+            size_t pos = _first_token(ch);
+            if(pos == NONE)
+                continue;
+            while(pos > 0 && (m_src.str[pos-1] == ' ' || m_src.str[pos-1] == '\t' || m_src.str[pos-1] == '\n' || m_src.str[pos-1] == '\r'))
+                --pos;
+            if(pos == 0)
+                continue;
+            const char c = m_src.str[pos-1];
+            if(c == ',' || (first && (c == '{' || c == '[')))
+                return false;
+        }
+        return true;
+    }
+
+    bool _start(size_t node, Candidate *c) const
+    {
+        const size_t pos = _first_token(node);
+        if(pos == NONE)
+            return false;
+        const size_t begin = _line_begin(pos);
+        size_t i = begin;
+        while(i < pos && m_src.str[i] == ' ')
+            ++i;
+        c->indentation = i - begin;
+        if(!m_tree->has_key(node))
+        {
+            // a seq item: accept only a single "- " marker
+            if(i == pos || m_src.str[i] != '-')
+                return false;
+            if(++i == pos || m_src.str[i] != ' ')
+                return false;
+            while(i < pos && m_src.str[i] == ' ')
+                ++i;
+        }
+        if(i != pos)
+            return false;
+        c->node = node;
+        c->begin = begin;
+        c->end = NONE;
+        c->seq_with_key = m_tree->has_key(node) && m_tree->is_seq(node);
+        return true;
+    }
+
+    /** visit the tree in document order, keeping the ancestors in a
+     * stack, and collect the candidates (which are thus sorted by
+     * their offset in the source) */
+    void _find_candidates()
+    {
+        const size_t root = m_tree->root_id();
+        detail::stack<Frame> frames(m_tree->callbacks());
+        frames.push(Frame{root, _is_block(root)});
+        size_t node = m_tree->first_child(root);
+        while(node != NONE)
+        {
+            if(m_tree->is_container(node))
+            {
+                Candidate c;
+                if(frames.top().block && !m_tree->is_doc(node) && _start(node, &c))
+                {
+                    if(m_candidates.empty() || c.begin > m_candidates.top().begin)
+                        m_candidates.push(c);
+                }
+                if(m_tree->has_children(node))
+                {
+                    frames.push(Frame{node, frames.top().block && _is_block(node)});
+                    node = m_tree->first_child(node);
+                    continue;
+                }
+            }
+            // go to the next node, climbing up as needed
+            while(true)
+            {
+                const size_t next = m_tree->next_sibling(node);
+                if(next != NONE)
+                {
+                    node = next;
+                    break;
+                }
+                node = frames.top().node;
+                frames.pop();
+                if(frames.empty())
+                {
+                    node = NONE;
+                    break;
+                }
+            }
+        }
+    }
+
+    /** the line [pos, eol), without the newline (or carriage return) */
+    csubstr _line(size_t pos, size_t *eol) const
+    {
+        const char *nl = (const char*) memchr(m_src.str + pos, '\n', m_src.len - pos);
+        *eol = nl ? static_cast<size_t>(nl - m_src.str) : m_src.len;
+        return m_src.range(pos, *eol).trimr('\r');
+    }
+
+    /** in a single pass over the lines, find the end of each candidate */
+    void _find_ends()
+    {
+        detail::stack<size_t> open(m_tree->callbacks());
+        size_t icand = 0;
+        size_t pos = 0;
+        while(pos < m_src.len)
+        {
+            if(open.empty())
+            {
+                // skip to the next candidate
+                if(icand == m_candidates.size())
+                    break;
+                if(m_candidates[icand].begin > pos)
+                    pos = m_candidates[icand].begin;
+            }
+            size_t eol;
+            csubstr line = _line(pos, &eol);
+            const size_t ind = line.first_not_of(' ');
+            if(ind != npos && line.str[ind] != '#')
+            {
+                const bool doc_sep = ind == 0 && _is_doc_sep(line);
+                while(!open.empty())
+                {
+                    Candidate &c = m_candidates[open.top()];
+                    if( ! doc_sep)
+                    {
+                        if(ind > c.indentation)
+                            break;
+                        if(ind == c.indentation && c.seq_with_key && line.str[ind] == '-' && (ind + 1 == line.len || line.str[ind + 1] == ' '))
+                            break;
+                    }
+                    c.end = pos;
+                    open.pop();
+                }
+                while(icand < m_candidates.size() && m_candidates[icand].begin < pos)
+                    ++icand; // should not happen; leave it without end
+                if(icand < m_candidates.size() && m_candidates[icand].begin == pos)
+                    open.push(icand++);
+            }
+            pos = eol + 1;
+        }
+        while(!open.empty())
+            m_candidates[open.pop()].end = m_src.len;
+    }
+
+    /** the next node after the subtree of @p node, in the same document */
+    size_t _next_node(size_t node) const
+    {
+        while(node != NONE && !m_tree->is_doc(node) && !m_tree->is_root(node))
+        {
+            const size_t next = m_tree->next_sibling(node);
+            if(next != NONE)
+                return next;
+            node = m_tree->parent(node);
+        }
+        return NONE;
+    }
+
+    bool _is_end_ok(Candidate const& c) const
+    {
+        const size_t next = _next_node(c.node);
+        if(next != NONE)
+        {
+            const size_t pos = _first_token(next);
+            return pos != NONE && _line_begin(pos) == c.end;
+        }
+        // no more nodes: there can be only blank lines or comments
+        // until the end of the document
+        for(size_t pos = c.end, eol; pos < m_src.len; pos = eol + 1)
+        {
+            csubstr line = _line(pos, &eol);
+            const size_t ind = line.first_not_of(' ');
+            if(ind == npos || line.str[ind] == '#')
+                continue;
+            return ind == 0 && _is_doc_sep(line);
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+void Parser::parse_in_arena_with_spans(csubstr filename, csubstr csrc, Tree *t)
+{
+    t->disable_src_spans();
+    substr src = t->copy_to_arena(csrc);
+    const size_t offset = static_cast<size_t>(src.str - t->arena().str);
+    this->parse_in_place(filename, src, t, t->root_id());
+    // the arena may have been relocated while parsing
+    src = t->arena().sub(offset, csrc.len);
+    t->enable_src_spans(csrc);
+    SrcSpanFinder finder(t, src, csrc);
+    finder.run();
+}
+
 } // namespace yml
 } // namespace c4
 
@@ -20,9 +20,72 @@
 #   pragma warning(disable: 4251/*needs to have dll-interface to be used by clients of struct*/)
 #endif
 
+#if defined(RYML_PROFILE_CYCLES) && !defined(RYML_PROFILE)
+#   define RYML_PROFILE
+#endif
+
 namespace c4 {
 namespace yml {
 
+/** the phases of the parser which are profiled when ryml is compiled
+ * with RYML_PROFILE; each corresponds to a Parser handler. @see
+ * Parser::profile() */
+typedef enum {
+    PARSER_PHASE_PARSE,                  ///< the whole parse
+    PARSER_PHASE_HANDLE_LINE,            ///< dispatch of each line (or part of the line)
+    PARSER_PHASE_HANDLE_INDENTATION,     ///< indentation changes in block containers
+    PARSER_PHASE_HANDLE_UNK,             ///< start of a document or of a container of unknown type
+    PARSER_PHASE_HANDLE_TOP,             ///< directives and document markers
+    PARSER_PHASE_HANDLE_MAP_EXPL,        ///< flow maps: {a: b}
+    PARSER_PHASE_HANDLE_MAP_IMPL,        ///< block maps
+    PARSER_PHASE_HANDLE_SEQ_EXPL,        ///< flow seqs: [a, b]
+    PARSER_PHASE_HANDLE_SEQ_IMPL,        ///< block seqs
+    PARSER_PHASE_HANDLE_TYPES,           ///< tags
+    PARSER_PHASE_HANDLE_ANCHORS_AND_REFS,///< anchors and references
+    PARSER_PHASE_SCAN_SCALAR,            ///< finding the scalars, of all styles
+    PARSER_PHASE_SCAN_PLAIN_SCALAR,      ///< plain scalars spanning several lines
+    PARSER_PHASE_SCAN_SQUOT_SCALAR,      ///< single-quoted scalars
+    PARSER_PHASE_SCAN_DQUOT_SCALAR,      ///< double-quoted scalars
+    PARSER_PHASE_SCAN_BLOCK,             ///< block scalars: | or >
+    PARSER_PHASE_SCAN_COMMENT,           ///< comments
+    PARSER_PHASE_FILTER_PLAIN_SCALAR,    ///< folding the lines of plain scalars
+    PARSER_PHASE_FILTER_SQUOT_SCALAR,    ///< folding and unescaping single-quoted scalars
+    PARSER_PHASE_FILTER_DQUOT_SCALAR,    ///< folding and unescaping double-quoted scalars
+    PARSER_PHASE_FILTER_BLOCK_SCALAR,    ///< folding and chomping block scalars
+    PARSER_NUM_PHASES
+} ParserPhase_e;
+
+/** the counts of the profiled phases of a parser. The ticks are
+ * inclusive: the ticks of a phase include those of the phases called
+ * from it, eg the ticks of HANDLE_MAP_IMPL include the ticks spent in
+ * SCAN_SCALAR for the map's scalars. */
+struct RYML_EXPORT ParserProfile
+{
+    struct Phase
+    {
+        size_t   calls; ///< the number of times the phase was entered
+        uint64_t ticks; ///< the time spent in the phase: CPU cycles if RYML_PROFILE_CYCLES is defined, 0 otherwise
+    };
+
+    Phase phases[PARSER_NUM_PHASES];
+
+    ParserProfile() : phases() {}
+
+    Phase const& operator[] (ParserPhase_e p) const { RYML_ASSERT((size_t)p < (size_t)PARSER_NUM_PHASES); return phases[p]; }
+
+    void reset() { for(Phase &p : phases) p = {}; }
+
+    /** a short name for the phase, usable as an identifier */
+    static const char* phase_name(ParserPhase_e p);
+
+    /** write a table of the phases which were entered, one per line
+     * with the phase name, the calls, the ticks and the percentage of
+     * the ticks of the whole parse.
+     * @return the length needed for the table; if larger than the
+     * buffer, only the part which fits was written. */
+    size_t report(substr buf) const;
+};
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -107,6 +170,24 @@ public:
 
     /** @} */
 
+#ifdef RYML_PROFILE
+public:
+
+    /** @name profile: the calls to (and, with RYML_PROFILE_CYCLES,
+     * the cycles spent in) each phase of the parser, accumulated over
+     * all the parses done by this object since the last
+     * reset_profile(). These are available only when ryml is compiled
+     * with RYML_PROFILE; otherwise the phases are not counted, and
+     * parsing has no overhead. The profile is not copied or moved
+     * with the parser. */
+    /** @{ */
+
+    ParserProfile const& profile() const { return m_profile; }
+    void reset_profile() { m_profile.reset(); }
+
+    /** @} */
+#endif
+
 public:
 
     /** @name parse_in_place */
@@ -228,6 +309,35 @@ public:
 
     /** @} */
 
+public:
+
+    /** @name parse_in_arena_with_spans: parse in the tree's arena,
+     * and remember the spans of the container nodes in the YAML
+     * source, so that the nodes which are not modified afterwards
+     * are emitted verbatim, keeping their comments and formatting.
+     *
+     * @warning the YAML source is not copied for the spans: it must
+     * outlive the tree and be kept unmodified.
+     * @see Tree::src_span() */
+    /** @{ */
+
+    /** Create a new tree and parse into its root, remembering the
+     * source spans. */
+    Tree parse_in_arena_with_spans(csubstr filename, csubstr csrc)
+    {
+        Tree t(callbacks());
+        t.reserve(_estimate_capacity(csrc));
+        this->parse_in_arena_with_spans(filename, csrc, &t);
+        return t;
+    }
+
+    /** Parse into an existing tree, starting at its root node, and
+     * remember the source spans. Spans previously kept by the tree
+     * are discarded. */
+    void parse_in_arena_with_spans(csubstr filename, csubstr csrc, Tree *t);
+
+    /** @} */
+
 public:
 
     /** @name locations */
@@ -552,6 +662,10 @@ private:
     mutable size_t  m_newline_offsets_size;
     mutable size_t  m_newline_offsets_capacity;
     mutable csubstr m_newline_offsets_buf;
+
+#ifdef RYML_PROFILE
+    ParserProfile m_profile;
+#endif
 };
 
 
@@ -647,6 +761,22 @@ RYML_DEPRECATED("use parse_in_arena() instead") inline void parse(csubstr filena
 
 /** @} */
 
+
+/** @name parse_in_arena_with_spans
+ * parse a read-only YAML source buffer in the tree's arena, and
+ * remember the source spans of the container nodes, so that the nodes
+ * which are not modified are emitted verbatim. The source buffer must
+ * outlive the tree and be kept unmodified.
+ * @see Parser::parse_in_arena_with_spans() */
+/** @{ */
+
+inline Tree parse_in_arena_with_spans(                  csubstr yaml         ) { Parser np; return np.parse_in_arena_with_spans({}      , yaml); } //!< parse a read-only YAML source buffer, and remember the source spans.
+inline Tree parse_in_arena_with_spans(csubstr filename, csubstr yaml         ) { Parser np; return np.parse_in_arena_with_spans(filename, yaml); } //!< parse a read-only YAML source buffer, and remember the source spans, providing a filename for error messages.
+inline void parse_in_arena_with_spans(                  csubstr yaml, Tree *t) { Parser np; np.parse_in_arena_with_spans({}      , yaml, t); } //!< reusing the YAML tree, parse a read-only YAML source buffer, and remember the source spans.
+inline void parse_in_arena_with_spans(csubstr filename, csubstr yaml, Tree *t) { Parser np; np.parse_in_arena_with_spans(filename, yaml, t); } //!< reusing the YAML tree, parse a read-only YAML source buffer, and remember the source spans, providing a filename for error messages.
+
+/** @} */
+
 } // namespace yml
 } // namespace c4
 
@@ -0,0 +1,154 @@
+#ifndef _C4_YML_REFLECT_HPP_
+#define _C4_YML_REFLECT_HPP_
+
+/** @file reflect.hpp Declare the fields of a struct once, and get
+ * write()/read() functions mapping the struct to/from a YAML map.
+ *
+ * @code
+ * namespace foo {
+ * struct Point { int x, y; std::string name; };
+ * RYML_REFLECT(Point, x, y, name)
+ * } // namespace foo
+ *
+ * foo::Point p;
+ * tree["point"] >> p; // read
+ * tree["point"] << p; // write
+ * @endcode
+ *
+ * RYML_REFLECT() must be used at namespace scope, in the namespace
+ * of the struct, so that the functions are found by argument
+ * dependent lookup. Fields of any type which can be written/read
+ * to a node can be used, including other reflected structs.
+ *
+ * Reading visits the children of the map only once. The key of each
+ * child is dispatched with a switch over a compile-time hash of the
+ * field names, so the cost per key is O(1) instead of a find_child()
+ * per field. Keys which are not fields are ignored, and fields which
+ * are not present in the map are left untouched. Two field names
+ * with the same hash would be a duplicate case label, and so are
+ * detected at compile time.
+ *
+ * Writing appends one child per field, in declaration order. The
+ * keys are not copied to the arena, as they point at the static
+ * field name strings. */
+
+#ifndef _C4_YML_NODE_HPP_
+#include "c4/yml/node.hpp"
+#endif
+
+
+namespace c4 {
+namespace yml {
+namespace detail {
+
+/** FNV-1a, usable in constant expressions (C++11) */
+constexpr uint64_t reflect_hash_lit_(const char *s, size_t len, uint64_t h)
+{
+    return len == 0 ? h : reflect_hash_lit_(s + 1, len - 1, (h ^ (uint64_t)(uint8_t)*s) * UINT64_C(1099511628211));
+}
+
+/** hash of a field name; must match reflect_hash() */
+template<size_t N>
+constexpr uint64_t reflect_hash_lit(const char (&s)[N])
+{
+    return reflect_hash_lit_(s, N - 1, UINT64_C(14695981039346656037));
+}
+
+/** hash of a key */
+inline uint64_t reflect_hash(csubstr s)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+    for(size_t i = 0; i < s.len; ++i)
+        h = (h ^ (uint64_t)(uint8_t)s.str[i]) * UINT64_C(1099511628211);
+    return h;
+}
+
+} // namespace detail
+} // namespace yml
+} // namespace c4
+
+
+/** generate write() and read() for the given struct and fields.
+ * Up to 32 fields are supported. */
+#define RYML_REFLECT(Type, ...)                                             \
+inline void write(::c4::yml::NodeRef *n, Type const& v)                     \
+{                                                                           \
+    *n |= ::c4::yml::MAP;                                                   \
+    _RYML_REFLECT_FOR_EACH(_RYML_REFLECT_WRITE_FIELD, __VA_ARGS__)          \
+}                                                                           \
+inline bool read(::c4::yml::NodeRef const& n, Type *v)                      \
+{                                                                           \
+    if( ! n.is_map())                                                       \
+        return false;                                                       \
+    for(::c4::yml::NodeRef const ch : n)                                    \
+    {                                                                       \
+        const ::c4::csubstr k = ch.key();                                   \
+        switch(::c4::yml::detail::reflect_hash(k))                          \
+        {                                                                   \
+        _RYML_REFLECT_FOR_EACH(_RYML_REFLECT_READ_FIELD, __VA_ARGS__)       \
+        default:                                                            \
+            break;                                                          \
+        }                                                                   \
+    }                                                                       \
+    return true;                                                            \
+}
+
+
+/** @cond dev */
+
+#define _RYML_REFLECT_WRITE_FIELD(field)                                    \
+    {                                                                       \
+        ::c4::yml::NodeRef ch = n->append_child();                          \
+        ch.set_key(::c4::csubstr(#field, sizeof(#field) - 1));              \
+        ch << v.field;                                                      \
+    }
+
+#define _RYML_REFLECT_READ_FIELD(field)                                     \
+        case ::c4::yml::detail::reflect_hash_lit(#field):                   \
+            if(k == ::c4::csubstr(#field, sizeof(#field) - 1))              \
+                ch >> v->field;                                             \
+            break;
+
+// the extra expansion is needed for MSVC's handling of __VA_ARGS__
+#define _RYML_REFLECT_EXPAND(x) x
+#define _RYML_REFLECT_CAT(a, b) _RYML_REFLECT_CAT_(a, b)
+#define _RYML_REFLECT_CAT_(a, b) a##b
+#define _RYML_REFLECT_NARGS(...) _RYML_REFLECT_EXPAND(_RYML_REFLECT_NARGS_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0))
+#define _RYML_REFLECT_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define _RYML_REFLECT_FOR_EACH(m, ...) _RYML_REFLECT_EXPAND(_RYML_REFLECT_CAT(_RYML_REFLECT_FE_, _RYML_REFLECT_NARGS(__VA_ARGS__))(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_1(m, a) m(a)
+#define _RYML_REFLECT_FE_2(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_1(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_3(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_2(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_4(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_3(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_5(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_4(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_6(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_5(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_7(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_6(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_8(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_7(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_9(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_8(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_10(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_9(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_11(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_10(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_12(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_11(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_13(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_12(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_14(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_13(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_15(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_14(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_16(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_15(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_17(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_16(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_18(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_17(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_19(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_18(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_20(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_19(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_21(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_20(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_22(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_21(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_23(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_22(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_24(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_23(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_25(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_24(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_26(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_25(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_27(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_26(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_28(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_27(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_29(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_28(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_30(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_29(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_31(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_30(m, __VA_ARGS__))
+#define _RYML_REFLECT_FE_32(m, a, ...) m(a) _RYML_REFLECT_EXPAND(_RYML_REFLECT_FE_31(m, __VA_ARGS__))
+
+/** @endcond */
+
+#endif /* _C4_YML_REFLECT_HPP_ */
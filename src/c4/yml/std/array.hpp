@@ -0,0 +1,64 @@
+#ifndef _C4_YML_STD_ARRAY_HPP_
+#define _C4_YML_STD_ARRAY_HPP_
+
+/** @file array.hpp write/read std::array to/from a YAML tree. */
+
+#include "c4/yml/std/vector.hpp"
+#include <array>
+
+namespace c4 {
+namespace yml {
+
+// array is a sequence-like type, and it requires child nodes
+// in the data tree hierarchy (a SEQ node in ryml parlance).
+// So it should be serialized via write()/read(). Arrays of
+// numbers are serialized in bulk, like vectors.
+
+template<class V, size_t N>
+typename std::enable_if< ! detail::is_bulk_vector_value<V>::value, void>::type
+write(c4::yml::NodeRef *n, std::array<V, N> const& arr)
+{
+    *n |= c4::yml::SEQ;
+    for(auto const& v : arr)
+    {
+        n->append_child() << v;
+    }
+}
+
+template<class V, size_t N>
+typename std::enable_if<detail::is_bulk_vector_value<V>::value, void>::type
+write(c4::yml::NodeRef *n, std::array<V, N> const& arr)
+{
+    *n |= c4::yml::SEQ;
+    n->append_children_serialized(arr.data(), N);
+}
+
+/** fails if the node has a different number of children than the array */
+template<class V, size_t N>
+typename std::enable_if< ! detail::is_bulk_vector_value<V>::value, bool>::type
+read(c4::yml::NodeRef const& n, std::array<V, N> *arr)
+{
+    if(n.num_children() != N)
+        return false;
+    size_t pos = 0;
+    for(auto const ch : n)
+    {
+        ch >> (*arr)[pos++];
+    }
+    return true;
+}
+
+/** fails if the node has a different number of children than the array */
+template<class V, size_t N>
+typename std::enable_if<detail::is_bulk_vector_value<V>::value, bool>::type
+read(c4::yml::NodeRef const& n, std::array<V, N> *arr)
+{
+    if(n.num_children() != N)
+        return false;
+    return n.deserialize_children(arr->data(), N);
+}
+
+} // namespace yml
+} // namespace c4
+
+#endif // _C4_YML_STD_ARRAY_HPP_
@@ -28,13 +28,14 @@ void write(c4::yml::NodeRef *n, std::map<K, V, Less, Alloc> const& m)
 template<class K, class V, class Less, class Alloc>
 bool read(c4::yml::NodeRef const& n, std::map<K, V, Less, Alloc> * m)
 {
-    K k{};
-    V v;
+    V v{};
     for(auto const ch : n)
     {
-        ch >> c4::yml::key(k);
+        K k = detail::read_key<K>(ch);
         ch >> v;
-        m->emplace(std::make_pair(std::move(k), std::move(v)));
+        // the children are usually emitted in key order, so hint at
+        // the end to make the insertion amortized O(1)
+        m->emplace_hint(m->end(), std::move(k), std::move(v));
     }
     return true;
 }
@@ -0,0 +1,54 @@
+#ifndef _C4_YML_STD_OPTIONAL_HPP_
+#define _C4_YML_STD_OPTIONAL_HPP_
+
+/** @file optional.hpp write/read std::optional to/from a YAML tree.
+ * Requires C++17; this header is empty otherwise. */
+
+#include "c4/yml/node.hpp"
+
+#if C4_CPP >= 17
+#include <optional>
+
+namespace c4 {
+namespace yml {
+
+// an empty optional is written as a null value ("~"). A null
+// value (unquoted empty, "~", or "null") is read as an empty
+// optional; anything else is read into the contained type, and the
+// optional is left empty if that fails.
+
+template<class T>
+void write(c4::yml::NodeRef *n, std::optional<T> const& opt)
+{
+    if(opt.has_value())
+        *n << *opt;
+    else
+        *n << csubstr("~");
+}
+
+template<class T>
+bool read(c4::yml::NodeRef const& n, std::optional<T> *opt)
+{
+    if(n.has_val() && !n.is_val_quoted())
+    {
+        csubstr v = n.val();
+        if(v.empty() || v == '~' || v == "null" || v == "Null" || v == "NULL")
+        {
+            opt->reset();
+            return true;
+        }
+    }
+    if( ! read(n, &opt->emplace()))
+    {
+        opt->reset();
+        return false;
+    }
+    return true;
+}
+
+} // namespace yml
+} // namespace c4
+
+#endif // C4_CPP >= 17
+
+#endif // _C4_YML_STD_OPTIONAL_HPP_
@@ -4,5 +4,8 @@
 #include "c4/yml/std/string.hpp"
 #include "c4/yml/std/vector.hpp"
 #include "c4/yml/std/map.hpp"
+#include "c4/yml/std/unordered_map.hpp"
+#include "c4/yml/std/array.hpp"
+#include "c4/yml/std/optional.hpp"
 
 #endif // _C4_YML_STD_STD_HPP_
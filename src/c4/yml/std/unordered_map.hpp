@@ -0,0 +1,47 @@
+#ifndef _C4_YML_STD_UNORDERED_MAP_HPP_
+#define _C4_YML_STD_UNORDERED_MAP_HPP_
+
+/** @file unordered_map.hpp write/read std::unordered_map to/from a YAML tree. */
+
+#include "c4/yml/node.hpp"
+#include <unordered_map>
+
+namespace c4 {
+namespace yml {
+
+// std::unordered_map requires child nodes in the data
+// tree hierarchy (a MAP node in ryml parlance).
+// So it should be serialized via write()/read().
+
+template<class K, class V, class Hash, class Eq, class Alloc>
+void write(c4::yml::NodeRef *n, std::unordered_map<K, V, Hash, Eq, Alloc> const& m)
+{
+    *n |= c4::yml::MAP;
+    for(auto const& p : m)
+    {
+        auto ch = n->append_child();
+        ch << c4::yml::key(p.first);
+        ch << p.second;
+    }
+}
+
+template<class K, class V, class Hash, class Eq, class Alloc>
+bool read(c4::yml::NodeRef const& n, std::unordered_map<K, V, Hash, Eq, Alloc> * m)
+{
+    // the number of children is known upfront, so the buckets
+    // are allocated only once
+    m->reserve(m->size() + n.num_children());
+    V v{};
+    for(auto const ch : n)
+    {
+        K k = detail::read_key<K>(ch);
+        ch >> v;
+        m->emplace(std::move(k), std::move(v));
+    }
+    return true;
+}
+
+} // namespace yml
+} // namespace c4
+
+#endif // _C4_YML_STD_UNORDERED_MAP_HPP_
@@ -12,8 +12,19 @@ namespace yml {
 // in the data tree hierarchy (a SEQ node in ryml parlance).
 // So it should be serialized via write()/read().
 
+namespace detail {
+/** vectors of numbers are serialized in bulk. std::vector<bool> is
+ * not contiguous, so it is excluded. */
+template<class V>
+struct is_bulk_vector_value
+{
+    enum : bool { value = std::is_arithmetic<V>::value && !std::is_same<V, bool>::value };
+};
+} // namespace detail
+
 template<class V, class Alloc>
-void write(c4::yml::NodeRef *n, std::vector<V, Alloc> const& vec)
+typename std::enable_if< ! detail::is_bulk_vector_value<V>::value, void>::type
+write(c4::yml::NodeRef *n, std::vector<V, Alloc> const& vec)
 {
     *n |= c4::yml::SEQ;
     for(auto const& v : vec)
@@ -23,7 +34,16 @@ void write(c4::yml::NodeRef *n, std::vector<V, Alloc> const& vec)
 }
 
 template<class V, class Alloc>
-bool read(c4::yml::NodeRef const& n, std::vector<V, Alloc> *vec)
+typename std::enable_if<detail::is_bulk_vector_value<V>::value, void>::type
+write(c4::yml::NodeRef *n, std::vector<V, Alloc> const& vec)
+{
+    *n |= c4::yml::SEQ;
+    n->append_children_serialized(vec.data(), vec.size());
+}
+
+template<class V, class Alloc>
+typename std::enable_if< ! detail::is_bulk_vector_value<V>::value, bool>::type
+read(c4::yml::NodeRef const& n, std::vector<V, Alloc> *vec)
 {
     vec->resize(n.num_children());
     size_t pos = 0;
@@ -34,6 +54,14 @@ bool read(c4::yml::NodeRef const& n, std::vector<V, Alloc> *vec)
     return true;
 }
 
+template<class V, class Alloc>
+typename std::enable_if<detail::is_bulk_vector_value<V>::value, bool>::type
+read(c4::yml::NodeRef const& n, std::vector<V, Alloc> *vec)
+{
+    vec->resize(n.num_children());
+    return n.deserialize_children(vec->data(), vec->size());
+}
+
 } // namespace yml
 } // namespace c4
 
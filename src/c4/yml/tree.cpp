@@ -247,6 +247,8 @@ Tree::Tree(Callbacks const& cb)
     , m_arena()
     , m_arena_pos(0)
     , m_callbacks(cb)
+    , m_src_spans(nullptr)
+    , m_src()
 {
 }
 
@@ -294,12 +296,16 @@ void Tree::_free()
     if(m_buf)
     {
         _RYML_CB_ASSERT(m_callbacks, m_cap > 0);
-        _RYML_CB_FREE(m_callbacks, m_buf, NodeData, m_cap);
+        _RYML_CB_FREE_SITE(m_callbacks, m_buf, NodeData, m_cap, ALLOC_SITE_TREE_NODES);
     }
     if(m_arena.str)
     {
         _RYML_CB_ASSERT(m_callbacks, m_arena.len > 0);
-        _RYML_CB_FREE(m_callbacks, m_arena.str, char, m_arena.len);
+        _RYML_CB_FREE_SITE(m_callbacks, m_arena.str, char, m_arena.len, ALLOC_SITE_TREE_ARENA);
+    }
+    if(m_src_spans)
+    {
+        _RYML_CB_FREE_SITE(m_callbacks, m_src_spans, SrcSpan, m_cap, ALLOC_SITE_TREE_SPANS);
     }
     _clear();
 }
@@ -319,6 +325,8 @@ void Tree::_clear()
     m_free_tail = 0;
     m_arena = {};
     m_arena_pos = 0;
+    m_src_spans = nullptr;
+    m_src = {};
 }
 
 void Tree::_copy(Tree const& that)
@@ -326,7 +334,7 @@ void Tree::_copy(Tree const& that)
     _RYML_CB_ASSERT(m_callbacks, m_buf == nullptr);
     _RYML_CB_ASSERT(m_callbacks, m_arena.str == nullptr);
     _RYML_CB_ASSERT(m_callbacks, m_arena.len == 0);
-    m_buf = _RYML_CB_ALLOC_HINT(m_callbacks, NodeData, that.m_cap, that.m_buf);
+    m_buf = _RYML_CB_ALLOC_SITE(m_callbacks, NodeData, that.m_cap, that.m_buf, ALLOC_SITE_TREE_NODES);
     memcpy(m_buf, that.m_buf, that.m_cap * sizeof(NodeData));
     m_cap = that.m_cap;
     m_size = that.m_size;
@@ -338,11 +346,17 @@ void Tree::_copy(Tree const& that)
     {
         _RYML_CB_ASSERT(m_callbacks, that.m_arena.len > 0);
         substr arena;
-        arena.str = _RYML_CB_ALLOC_HINT(m_callbacks, char, that.m_arena.len, that.m_arena.str);
+        arena.str = _RYML_CB_ALLOC_SITE(m_callbacks, char, that.m_arena.len, that.m_arena.str, ALLOC_SITE_TREE_ARENA);
         arena.len = that.m_arena.len;
         _relocate(arena); // does a memcpy of the arena and updates nodes using the old arena
         m_arena = arena;
     }
+    if(that.m_src_spans)
+    {
+        m_src_spans = _RYML_CB_ALLOC_SITE(m_callbacks, SrcSpan, that.m_cap, that.m_src_spans, ALLOC_SITE_TREE_SPANS);
+        memcpy(m_src_spans, that.m_src_spans, that.m_cap * sizeof(SrcSpan));
+        m_src = that.m_src;
+    }
 }
 
 void Tree::_move(Tree & that)
@@ -357,6 +371,8 @@ void Tree::_move(Tree & that)
     m_free_tail = that.m_free_tail;
     m_arena = that.m_arena;
     m_arena_pos = that.m_arena_pos;
+    m_src_spans = that.m_src_spans;
+    m_src = that.m_src;
     that._clear();
 }
 
@@ -388,11 +404,18 @@ void Tree::reserve(size_t cap)
 {
     if(cap > m_cap)
     {
-        NodeData *buf = _RYML_CB_ALLOC_HINT(m_callbacks, NodeData, cap, m_buf);
+        NodeData *buf = _RYML_CB_ALLOC_SITE(m_callbacks, NodeData, cap, m_buf, ALLOC_SITE_TREE_NODES);
         if(m_buf)
         {
             memcpy(buf, m_buf, m_cap * sizeof(NodeData));
-            _RYML_CB_FREE(m_callbacks, m_buf, NodeData, m_cap);
+            _RYML_CB_FREE_SITE(m_callbacks, m_buf, NodeData, m_cap, ALLOC_SITE_TREE_NODES);
+        }
+        if(m_src_spans)
+        {
+            SrcSpan *spans = _RYML_CB_ALLOC_SITE(m_callbacks, SrcSpan, cap, m_src_spans, ALLOC_SITE_TREE_SPANS);
+            memcpy(spans, m_src_spans, m_cap * sizeof(SrcSpan));
+            _RYML_CB_FREE_SITE(m_callbacks, m_src_spans, SrcSpan, m_cap, ALLOC_SITE_TREE_SPANS);
+            m_src_spans = spans;
         }
         size_t first = m_cap, del = cap - m_cap;
         m_cap = cap;
@@ -424,6 +447,7 @@ void Tree::reserve(size_t cap)
 //-----------------------------------------------------------------------------
 void Tree::clear()
 {
+    disable_src_spans();
     _clear_range(0, m_cap);
     m_size = 0;
     if(m_buf)
@@ -448,6 +472,50 @@ void Tree::_claim_root()
 }
 
 
+//-----------------------------------------------------------------------------
+void Tree::enable_src_spans(csubstr src)
+{
+    if(!m_src_spans && m_cap)
+        m_src_spans = _RYML_CB_ALLOC_SITE(m_callbacks, SrcSpan, m_cap, nullptr, ALLOC_SITE_TREE_SPANS);
+    for(size_t i = 0; i < m_cap; ++i)
+        m_src_spans[i] = SrcSpan{NONE, NONE, 0, false};
+    m_src = src;
+}
+
+void Tree::disable_src_spans()
+{
+    if(m_src_spans)
+    {
+        _RYML_CB_ASSERT(m_callbacks, m_cap > 0);
+        _RYML_CB_FREE_SITE(m_callbacks, m_src_spans, SrcSpan, m_cap, ALLOC_SITE_TREE_SPANS);
+    }
+    m_src_spans = nullptr;
+    m_src = {};
+}
+
+void Tree::set_src_span(size_t node, size_t begin, size_t end, size_t indentation)
+{
+    _RYML_CB_ASSERT(m_callbacks, m_src_spans != nullptr);
+    _RYML_CB_ASSERT(m_callbacks, node < m_cap);
+    _RYML_CB_ASSERT(m_callbacks, begin <= end && end <= m_src.len);
+    SrcSpan &s = m_src_spans[node];
+    s.begin = begin;
+    s.end = end;
+    s.indentation = indentation;
+}
+
+void Tree::_do_src_dirty(size_t node)
+{
+    // the ancestors of a dirty node are always dirty, so stop
+    // at the first node which is already dirty
+    while(node != NONE && !m_src_spans[node].dirty)
+    {
+        m_src_spans[node].dirty = true;
+        node = m_buf[node].m_parent;
+    }
+}
+
+
 //-----------------------------------------------------------------------------
 void Tree::_clear_range(size_t first, size_t num)
 {
@@ -534,6 +602,50 @@ size_t Tree::_claim()
     return ichild;
 }
 
+//-----------------------------------------------------------------------------
+size_t Tree::append_children(size_t iparent, size_t num)
+{
+    _RYML_CB_ASSERT(m_callbacks, iparent != NONE);
+    _RYML_CB_ASSERT(m_callbacks, is_container(iparent) || is_root(iparent));
+    if(num == 0)
+        return NONE;
+    if(m_size + num > m_cap)
+    {
+        size_t sz = 2 * m_cap;
+        reserve(sz > m_size + num ? sz : m_size + num);
+    }
+    _RYML_CB_ASSERT(m_callbacks, m_size + num <= m_cap);
+    NodeData *C4_RESTRICT parent = m_buf + iparent;
+    size_t ifirst = m_free_head;
+    size_t iprev = parent->m_last_child;
+    for(size_t i = 0; i < num; ++i)
+    {
+        _RYML_CB_ASSERT(m_callbacks, m_free_head != NONE);
+        const size_t ichild = m_free_head;
+        NodeData *C4_RESTRICT child = m_buf + ichild;
+        m_free_head = child->m_next_sibling;
+        _clear(ichild);
+        child->m_parent = iparent;
+        child->m_prev_sibling = iprev;
+        child->m_next_sibling = NONE;
+        if(iprev != NONE)
+            m_buf[iprev].m_next_sibling = ichild;
+        else
+            parent->m_first_child = ichild;
+        iprev = ichild;
+    }
+    parent->m_last_child = iprev;
+    parent->m_num_children += num;
+    m_size += num;
+    _src_dirty(iparent);
+    if(m_free_head == NONE)
+    {
+        m_free_tail = NONE;
+        _RYML_CB_ASSERT(m_callbacks, m_size == m_cap);
+    }
+    return ifirst;
+}
+
 //-----------------------------------------------------------------------------
 
 C4_SUPPRESS_WARNING_GCC_PUSH
@@ -563,6 +675,7 @@ void Tree::_set_hierarchy(size_t ichild, size_t iparent, size_t iprev_sibling)
     if(iparent == NONE)
         return;
 
+    _src_dirty(iparent);
     size_t inext_sibling = iprev_sibling != NONE ? next_sibling(iprev_sibling) : first_child(iparent);
     NodeData *C4_RESTRICT parent = get(iparent);
     NodeData *C4_RESTRICT psib   = get(iprev_sibling);
@@ -584,6 +697,7 @@ void Tree::_set_hierarchy(size_t ichild, size_t iparent, size_t iprev_sibling)
         _RYML_CB_ASSERT(m_callbacks, nsib->m_prev_sibling != nsib->m_next_sibling || nsib->m_prev_sibling == NONE);
     }
 
+    ++parent->m_num_children;
     if(parent->m_first_child == NONE)
     {
         _RYML_CB_ASSERT(m_callbacks, parent->m_last_child == NONE);
@@ -614,7 +728,10 @@ void Tree::_rem_hierarchy(size_t i)
     // remove from the parent
     if(w.m_parent != NONE)
     {
+        _src_dirty(w.m_parent);
         NodeData &C4_RESTRICT p = m_buf[w.m_parent];
+        _RYML_CB_ASSERT(m_callbacks, p.m_num_children > 0);
+        --p.m_num_children;
         if(p.m_first_child == i)
         {
             p.m_first_child = w.m_next_sibling;
@@ -673,6 +790,9 @@ void Tree::_swap(size_t n_, size_t m_)
     _RYML_CB_ASSERT(m_callbacks, (parent(m_) != NONE) || type(m_) == NOTYPE);
     NodeType tn = type(n_);
     NodeType tm = type(m_);
+    // the spans follow the nodes
+    if(m_src_spans)
+        std::swap(m_src_spans[n_], m_src_spans[m_]);
     if(tn != NOTYPE && tm != NOTYPE)
     {
         _swap_props(n_, m_);
@@ -768,6 +888,7 @@ void Tree::_swap_hierarchy(size_t ia, size_t ib)
     }
     std::swap(a.m_first_child , b.m_first_child);
     std::swap(a.m_last_child  , b.m_last_child);
+    std::swap(a.m_num_children, b.m_num_children);
 
     if(a.m_prev_sibling != ib && b.m_prev_sibling != ia &&
        a.m_next_sibling != ib && b.m_next_sibling != ia)
@@ -885,6 +1006,7 @@ void Tree::_copy_hierarchy(size_t dst_, size_t src_)
     dst.m_parent       = src.m_parent;
     dst.m_first_child  = src.m_first_child;
     dst.m_last_child   = src.m_last_child;
+    dst.m_num_children = src.m_num_children;
     dst.m_prev_sibling = src.m_prev_sibling;
     dst.m_next_sibling = src.m_next_sibling;
 }
@@ -949,6 +1071,7 @@ void Tree::set_root_as_stream()
             _p(next_doc)->m_type.rem(SEQ);
         }
         _p(root)->m_type = STREAM;
+        _src_dirty(root);
         return;
     }
     _RYML_CB_ASSERT(m_callbacks, !has_key(root));
@@ -965,6 +1088,7 @@ void Tree::set_root_as_stream()
         next = next_sibling(next);
     }
     _p(root)->m_type = STREAM;
+    _src_dirty(root);
 }
 
 
@@ -972,16 +1096,20 @@ void Tree::set_root_as_stream()
 void Tree::remove_children(size_t node)
 {
     _RYML_CB_ASSERT(m_callbacks, get(node) != nullptr);
+    // release the descendants in post-order, walking through the
+    // parent links, so that the depth of the tree does not matter
     size_t ich = get(node)->m_first_child;
     while(ich != NONE)
     {
-        remove_children(ich);
-        _RYML_CB_ASSERT(m_callbacks, get(ich) != nullptr);
-        size_t next = get(ich)->m_next_sibling;
+        while(first_child(ich) != NONE)
+            ich = first_child(ich);
+        // ich has no children: release it, and continue with its
+        // next sibling. If there is none, its parent has now no
+        // children either, and is next.
+        const size_t next = next_sibling(ich);
+        const size_t prnt = parent(ich);
         _release(ich);
-        if(ich == get(node)->m_last_child)
-            break;
-        ich = next;
+        ich = next != NONE ? next : (prnt != node ? prnt : NONE);
     }
 }
 
@@ -998,6 +1126,7 @@ bool Tree::change_type(size_t node, NodeType type)
     else if(type.is_val() && is_val(node))
         return false;
     d->m_type = (d->m_type & (~(MAP|SEQ|VAL))) | type;
+    _src_dirty(node);
     remove_children(node);
     return true;
 }
@@ -1020,7 +1149,36 @@ size_t Tree::duplicate(Tree const* src, size_t node, size_t parent, size_t after
 
     _copy_props(copy, src, node);
     _set_hierarchy(copy, parent, after);
-    duplicate_children(src, node, copy, NONE);
+
+    // copy the descendants walking both trees in lockstep through
+    // the parent links, so that the depth of the tree does not matter
+    size_t dparent = copy;
+    size_t dprev = NONE;
+    size_t s = src->first_child(node);
+    while(s != NONE)
+    {
+        const size_t d = _claim();
+        _copy_props(d, src, s);
+        _set_hierarchy(d, dparent, dprev);
+        if(src->has_children(s))
+        {
+            dparent = d;
+            dprev = NONE;
+            s = src->first_child(s);
+            continue;
+        }
+        dprev = d;
+        // go to the next sibling, climbing up as needed
+        while(src->next_sibling(s) == NONE)
+        {
+            s = src->parent(s);
+            if(s == node)
+                break;
+            dprev = dparent;
+            dparent = this->parent(dparent);
+        }
+        s = s != node ? src->next_sibling(s) : NONE;
+    }
 
     return copy;
 }
@@ -1059,9 +1217,107 @@ void Tree::duplicate_contents(Tree const *src, size_t node, size_t where)
     _RYML_CB_ASSERT(m_callbacks, node != NONE);
     _RYML_CB_ASSERT(m_callbacks, where != NONE);
     _copy_props_wo_key(where, src, node);
+    _src_dirty(where);
     duplicate_children(src, node, where, last_child(where));
 }
 
+//-----------------------------------------------------------------------------
+
+namespace detail {
+/** a hash table from names (keys or anchors) to nodes, with open
+ * addressing and linear probing. It is used where looking up the
+ * names by walking the siblings (or the anchors) would be quadratic
+ * in the size of the input. The names are not copied, so they must
+ * outlive the table; entries are never removed. */
+struct NameIndex
+{
+    struct Entry
+    {
+        csubstr name;
+        size_t node; ///< NONE if the entry is unused
+        size_t data; ///< for use by the caller
+    };
+
+    stack<Entry> m_entries;
+    size_t m_num;
+
+    NameIndex(Callbacks const& cb) : m_entries(cb), m_num(0)
+    {
+        _rehash(m_entries.capacity());
+    }
+
+    /** make room for @p num names without rehashing */
+    void reserve(size_t num)
+    {
+        size_t cap = m_entries.size();
+        while(cap < 2 * num)
+            cap *= 2;
+        if(cap > m_entries.size())
+            _rehash(cap);
+    }
+
+    /** @return the entry of the name, or nullptr if there is none */
+    Entry *find(csubstr name)
+    {
+        Entry *e = _probe(name);
+        return e->node != NONE ? e : nullptr;
+    }
+
+    /** @return the entry of the name, which is unused (ie its node
+     * is NONE) if the name was not there. The pointer is invalidated
+     * by the next insertion. */
+    Entry *insert(csubstr name)
+    {
+        if(2 * (m_num + 1) > m_entries.size())
+            _rehash(2 * m_entries.size());
+        Entry *e = _probe(name);
+        if(e->node == NONE)
+        {
+            e->name = name;
+            ++m_num;
+        }
+        return e;
+    }
+
+    static size_t _hash(csubstr name)
+    {
+        uint64_t h = 14695981039346656037ull; // FNV-1a
+        for(char c : name)
+        {
+            h ^= (uint8_t)c;
+            h *= 1099511628211ull;
+        }
+        return (size_t)(h ^ (h >> 32));
+    }
+
+    Entry *_probe(csubstr name)
+    {
+        const size_t mask = m_entries.size() - 1; // the size is a power of two
+        for(size_t i = _hash(name) & mask; ; i = (i + 1) & mask)
+        {
+            Entry *e = &m_entries[i];
+            if(e->node == NONE || e->name == name)
+                return e;
+        }
+    }
+
+    void _rehash(size_t cap)
+    {
+        RYML_ASSERT(cap > 0 && (cap & (cap - 1)) == 0);
+        stack<Entry> prev(m_entries);
+        m_entries.resize(cap);
+        for(Entry &e : m_entries)
+            e = {csubstr{}, NONE, NONE};
+        for(Entry const& e : prev)
+        {
+            if(e.node != NONE)
+                *_probe(e.name) = e;
+        }
+    }
+};
+} // namespace detail
+
+
 //-----------------------------------------------------------------------------
 size_t Tree::duplicate_children_no_rep(size_t node, size_t parent, size_t after)
 {
@@ -1076,68 +1332,111 @@ size_t Tree::duplicate_children_no_rep(Tree const *src, size_t node, size_t pare
 
     // don't loop using pointers as there may be a relocation
 
-    // find the position where "after" is
+    size_t prev = after;
+    if(is_seq(parent))
+    {
+        for(size_t i = src->first_child(node); i != NONE; i = src->next_sibling(i))
+            prev = duplicate(src, i, parent, prev);
+        return prev;
+    }
+    _RYML_CB_ASSERT(m_callbacks, is_map(parent));
+
+    /* Index the keys of the parent, to find the repetitions without
+     * walking the siblings. Each entry has the first child with the
+     * key, and where it is relative to "after". While duplicating,
+     * the children before "after" can only be removed, and the
+     * duplicates are inserted (or the reps moved) right after it; so
+     * the untouched children before "after" stay before its original
+     * position, and those after it stay at or after that position.
+     * Only "after" itself and the keys already duplicated here
+     * (which happens when the source has repeated keys) need to
+     * compute their actual position. */
+    enum : size_t { REP_BEFORE, REP_IS_AFTER, REP_AFTER, REP_TOUCHED };
+    detail::NameIndex keys(m_callbacks);
+    keys.reserve(num_children(parent) + src->num_children(node));
     size_t after_pos = NONE;
-    if(after != NONE)
     {
-        for(size_t i = first_child(parent), icount = 0; i != NONE; ++icount, i = next_sibling(i))
+        size_t where = (after == NONE) ? (size_t)REP_AFTER : (size_t)REP_BEFORE;
+        for(size_t j = first_child(parent), jcount = 0; j != NONE; ++jcount, j = next_sibling(j))
         {
-            if(i == after)
+            if(j == after)
             {
-                after_pos = icount;
-                break;
+                after_pos = jcount;
+                where = REP_IS_AFTER;
             }
+            detail::NameIndex::Entry *e = keys.insert(key(j));
+            if(e->node == NONE)
+            {
+                e->node = j;
+                e->data = where;
+            }
+            if(j == after)
+                where = REP_AFTER;
         }
-        _RYML_CB_ASSERT(m_callbacks, after_pos != NONE);
+        _RYML_CB_ASSERT(m_callbacks, after == NONE || after_pos != NONE);
     }
 
     // for each child to be duplicated...
-    size_t prev = after;
-    for(size_t i = src->first_child(node), icount = 0; i != NONE; ++icount, i = src->next_sibling(i))
+    for(size_t i = src->first_child(node); i != NONE; i = src->next_sibling(i))
     {
-        if(is_seq(parent))
+        // does the parent already have a node with key equal to that of the current duplicate?
+        size_t rep = NONE, rep_pos = NONE;
+        detail::NameIndex::Entry *e = keys.find(src->key(i));
+        if(e != nullptr)
         {
-            prev = duplicate(i, parent, prev);
-        }
-        else
-        {
-            _RYML_CB_ASSERT(m_callbacks, is_map(parent));
-            // does the parent already have a node with key equal to that of the current duplicate?
-            size_t rep = NONE, rep_pos = NONE;
-            for(size_t j = first_child(parent), jcount = 0; j != NONE; ++jcount, j = next_sibling(j))
+            rep = e->node;
+            switch(e->data)
             {
-                if(key(j) == key(i))
+            case REP_BEFORE:
+                rep_pos = 0;
+                break;
+            case REP_IS_AFTER:
+                rep_pos = child_pos(parent, rep);
+                break;
+            case REP_AFTER:
+                rep_pos = after_pos;
+                break;
+            default:
+                rep = NONE;
+                for(size_t j = first_child(parent), jcount = 0; j != NONE; ++jcount, j = next_sibling(j))
                 {
-                    rep = j;
-                    rep_pos = jcount;
-                    break;
+                    if(key(j) == src->key(i))
+                    {
+                        rep = j;
+                        rep_pos = jcount;
+                        break;
+                    }
                 }
+                break;
             }
-            if(rep == NONE) // there is no repetition; just duplicate
+        }
+        if(rep == NONE) // there is no repetition; just duplicate
+        {
+            prev = duplicate(src, i, parent, prev);
+        }
+        else  // yes, there is a repetition
+        {
+            if(after_pos != NONE && rep_pos < after_pos)
             {
+                // rep is located before the node which will be inserted,
+                // and will be overridden by the duplicate. So replace it.
+                remove(rep);
                 prev = duplicate(src, i, parent, prev);
             }
-            else  // yes, there is a repetition
+            else
             {
-                if(after_pos != NONE && rep_pos < after_pos)
+                // rep is located after the node which will be inserted
+                // and overrides it. So move the rep into this node's place.
+                if(rep != prev)
                 {
-                    // rep is located before the node which will be inserted,
-                    // and will be overridden by the duplicate. So replace it.
-                    remove(rep);
-                    prev = duplicate(src, i, parent, prev);
+                    move(rep, prev);
+                    prev = rep;
                 }
-                else if(after_pos == NONE || rep_pos >= after_pos)
-                {
-                    // rep is located after the node which will be inserted
-                    // and overrides it. So move the rep into this node's place.
-                    if(rep != prev)
-                    {
-                        move(rep, prev);
-                        prev = rep;
-                    }
-                }
-            } // there's a repetition
-        }
+            }
+        } // there's a repetition
+        e = keys.insert(src->key(i));
+        e->node = prev;
+        e->data = REP_TOUCHED;
     }
 
     return prev;
@@ -1168,6 +1467,7 @@ void Tree::merge_with(Tree const *src, size_t src_node, size_t dst_node)
             _copy_props_wo_key(dst_node, src, src_node);
         else
             C4_NEVER_REACH();
+        _src_dirty(dst_node);
     }
     else if(src->is_seq(src_node))
     {
@@ -1200,13 +1500,25 @@ void Tree::merge_with(Tree const *src, size_t src_node, size_t dst_node)
             else
                 to_map(dst_node);
         }
+        // index the children of the destination once, instead of
+        // calling find_child() for each child of the source
+        detail::NameIndex dst_keys(m_callbacks);
+        dst_keys.reserve(num_children(dst_node));
+        for(size_t dch = first_child(dst_node); dch != NONE; dch = next_sibling(dch))
+        {
+            detail::NameIndex::Entry *e = dst_keys.insert(key(dch));
+            if(e->node == NONE)
+                e->node = dch;
+        }
         for(size_t sch = src->first_child(src_node); sch != NONE; sch = src->next_sibling(sch))
         {
-            size_t dch = find_child(dst_node, src->key(sch));
+            detail::NameIndex::Entry *e = dst_keys.insert(src->key(sch));
+            size_t dch = e->node;
             if(dch == NONE)
             {
                 dch = append_child(dst_node);
                 _copy_props(dch, src, sch);
+                e->node = dch;
             }
             merge_with(src, sch, dch);
         }
@@ -1230,7 +1542,6 @@ struct ReferenceResolver
     {
         NodeType type;
         size_t node;
-        size_t prev_anchor;
         size_t target;
         size_t parent_ref;
         size_t parent_ref_sibling;
@@ -1239,7 +1550,7 @@ struct ReferenceResolver
     Tree *t;
     /** from the specs: "an alias node refers to the most recent
      * node in the serialization having the specified anchor". So
-     * we need to start looking upward from ref nodes.
+     * the anchors and refs are stored in serialization order.
      *
      * @see http://yaml.org/spec/1.2/spec.html#id2765878 */
     stack<refdata> refs;
@@ -1259,32 +1570,49 @@ struct ReferenceResolver
 
         // now descend through the hierarchy
         _store_anchors_and_refs(t->root_id());
+    }
 
-        // finally connect the reference list
-        size_t prev_anchor = npos;
-        size_t count = 0;
-        for(auto &rd : refs)
+    /** the next node after @p n in a depth-first walk of the subtree
+     * of @p root. Walking through the parent links needs no stack, so
+     * the depth of the tree does not matter. */
+    size_t _next(size_t n, size_t root, bool visit_children) const
+    {
+        if(visit_children)
         {
-            rd.prev_anchor = prev_anchor;
-            if(rd.type.is_anchor())
-                prev_anchor = count;
-            ++count;
+            const size_t ch = t->first_child(n);
+            if(ch != NONE)
+                return ch;
         }
+        for( ; n != root; n = t->parent(n))
+        {
+            const size_t next = t->next_sibling(n);
+            if(next != NONE)
+                return next;
+        }
+        return NONE;
     }
 
-    size_t count_anchors_and_refs(size_t n)
+    size_t count_anchors_and_refs(size_t root)
     {
         size_t c = 0;
-        c += t->has_key_anchor(n);
-        c += t->has_val_anchor(n);
-        c += t->is_key_ref(n);
-        c += t->is_val_ref(n);
-        for(size_t ch = t->first_child(n); ch != NONE; ch = t->next_sibling(ch))
-            c += count_anchors_and_refs(ch);
+        for(size_t n = root; n != NONE; n = _next(n, root, true))
+        {
+            c += t->has_key_anchor(n);
+            c += t->has_val_anchor(n);
+            c += t->is_key_ref(n);
+            c += t->is_val_ref(n);
+        }
         return c;
     }
 
-    void _store_anchors_and_refs(size_t n)
+    void _store_anchors_and_refs(size_t root)
+    {
+        for(size_t n = root; n != NONE; n = _next(n, root, _store_anchors_and_refs_of(n)))
+            ;
+    }
+
+    /** @return whether the children of the node are to be visited */
+    bool _store_anchors_and_refs_of(size_t n)
     {
         if(t->is_key_ref(n) || t->is_val_ref(n) || (t->has_key(n) && t->key(n) == "<<"))
         {
@@ -1295,38 +1623,35 @@ struct ReferenceResolver
                 for(size_t ich = t->first_child(n); ich != NONE; ich = t->next_sibling(ich))
                 {
                     RYML_ASSERT(t->num_children(ich) == 0);
-                    refs.push({VALREF, ich, npos, npos, n, t->next_sibling(n)});
+                    refs.push({VALREF, ich, npos, n, t->next_sibling(n)});
                 }
-                return;
+                return false;
             }
             if(t->is_key_ref(n) && t->key(n) != "<<") // insert key refs BEFORE inserting val refs
             {
                 RYML_CHECK((!t->has_key(n)) || t->key(n).ends_with(t->key_ref(n)));
-                refs.push({KEYREF, n, npos, npos, NONE, NONE});
+                refs.push({KEYREF, n, npos, NONE, NONE});
             }
             if(t->is_val_ref(n))
             {
                 RYML_CHECK((!t->has_val(n)) || t->val(n).ends_with(t->val_ref(n)));
-                refs.push({VALREF, n, npos, npos, NONE, NONE});
+                refs.push({VALREF, n, npos, NONE, NONE});
             }
         }
         if(t->has_key_anchor(n))
         {
             RYML_CHECK(t->has_key(n));
-            refs.push({KEYANCH, n, npos, npos, NONE, NONE});
+            refs.push({KEYANCH, n, npos, NONE, NONE});
         }
         if(t->has_val_anchor(n))
         {
             RYML_CHECK(t->has_val(n) || t->is_container(n));
-            refs.push({VALANCH, n, npos, npos, NONE, NONE});
-        }
-        for(size_t ch = t->first_child(n); ch != NONE; ch = t->next_sibling(ch))
-        {
-            _store_anchors_and_refs(ch);
+            refs.push({VALANCH, n, npos, NONE, NONE});
         }
+        return true;
     }
 
-    size_t lookup_(refdata *C4_RESTRICT ra)
+    size_t lookup_(refdata *C4_RESTRICT ra, NameIndex *anchors)
     {
         RYML_ASSERT(ra->type.is_key_ref() || ra->type.is_val_ref());
         RYML_ASSERT(ra->type.is_key_ref() != ra->type.is_val_ref());
@@ -1340,12 +1665,9 @@ struct ReferenceResolver
             RYML_ASSERT(ra->type.is_key_ref());
             refname = t->key_ref(ra->node);
         }
-        while(ra->prev_anchor != npos)
-        {
-            ra = &refs[ra->prev_anchor];
-            if(t->has_anchor(ra->node, refname))
-                return ra->node;
-        }
+        NameIndex::Entry const* e = anchors->find(refname);
+        if(e != nullptr)
+            return e->node;
 
         #ifndef RYML_ERRMSG_SIZE
           #define RYML_ERRMSG_SIZE 1024
@@ -1365,16 +1687,26 @@ struct ReferenceResolver
             return;
 
         /* from the specs: "an alias node refers to the most recent
-         * node in the serialization having the specified anchor". So
-         * we need to start looking upward from ref nodes.
+         * node in the serialization having the specified anchor". The
+         * refs are stored in serialization order, so walk them
+         * forward, keeping the most recent node of each anchor in an
+         * index: then each reference is resolved in constant time,
+         * regardless of the number of anchors before it.
          *
          * @see http://yaml.org/spec/1.2/spec.html#id2765878 */
-        for(size_t i = 0, e = refs.size(); i < e; ++i)
+        NameIndex anchors(t->callbacks());
+        anchors.reserve(refs.size());
+        for(auto &C4_RESTRICT rd : refs)
         {
-            auto &C4_RESTRICT rd = refs.top(i);
-            if( ! rd.type.is_ref())
-                continue;
-            rd.target = lookup_(&rd);
+            if(rd.type.is_ref())
+            {
+                rd.target = lookup_(&rd, &anchors);
+            }
+            else
+            {
+                csubstr name = (rd.type.type & KEYANCH) ? t->key_anchor(rd.node) : t->val_anchor(rd.node);
+                anchors.insert(name)->node = rd.node;
+            }
         }
     }
 
@@ -1471,26 +1803,27 @@ void Tree::resolve()
 
 //-----------------------------------------------------------------------------
 
-size_t Tree::num_children(size_t node) const
-{
-    size_t count = 0;
-    for(size_t i = first_child(node); i != NONE; i = next_sibling(i))
-    {
-        ++count;
-    }
-    return count;
-}
-
 size_t Tree::child(size_t node, size_t pos) const
 {
     _RYML_CB_ASSERT(m_callbacks, node != NONE);
-    size_t count = 0;
-    for(size_t i = first_child(node); i != NONE; i = next_sibling(i))
+    const size_t num = num_children(node);
+    if(pos >= num)
+        return NONE;
+    // walk from the nearest end
+    size_t i;
+    if(pos <= num / 2)
     {
-        if(count++ == pos)
-            return i;
+        i = first_child(node);
+        for(size_t count = 0; count < pos; ++count)
+            i = next_sibling(i);
     }
-    return NONE;
+    else
+    {
+        i = last_child(node);
+        for(size_t count = num - 1; count > pos; --count)
+            i = prev_sibling(i);
+    }
+    return i;
 }
 
 size_t Tree::child_pos(size_t node, size_t ch) const
@@ -1538,6 +1871,33 @@ size_t Tree::find_child(size_t node, csubstr const& name) const
     return NONE;
 }
 
+void Tree::find_children(size_t node, csubstr const* names, size_t num_names, size_t *children) const
+{
+    _RYML_CB_ASSERT(m_callbacks, node != NONE);
+    _RYML_CB_ASSERT(m_callbacks, is_map(node));
+    _RYML_CB_ASSERT(m_callbacks, num_names == 0 || (names != nullptr && children != nullptr));
+    // for a few names, walking the children is cheaper than indexing them
+    if(num_names <= 4)
+    {
+        for(size_t i = 0; i < num_names; ++i)
+            children[i] = find_child(node, names[i]);
+        return;
+    }
+    detail::NameIndex keys(m_callbacks);
+    keys.reserve(num_children(node));
+    for(size_t ch = first_child(node); ch != NONE; ch = next_sibling(ch))
+    {
+        detail::NameIndex::Entry *e = keys.insert(_p(ch)->m_key.scalar);
+        if(e->node == NONE) // keep the first child with the key, like find_child()
+            e->node = ch;
+    }
+    for(size_t i = 0; i < num_names; ++i)
+    {
+        detail::NameIndex::Entry const* e = keys.find(names[i]);
+        children[i] = e ? e->node : NONE;
+    }
+}
+
 #if defined(__clang__)
 #   pragma clang diagnostic pop
 #elif defined(__GNUC__)
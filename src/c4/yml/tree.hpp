@@ -7,6 +7,9 @@
 #ifndef _C4_YML_COMMON_HPP_
 #include "c4/yml/common.hpp"
 #endif
+#ifndef _C4_YML_DETAIL_FPCONV_HPP_
+#include "c4/yml/detail/fpconv.hpp"
+#endif
 
 #include <c4/charconv.hpp>
 #include <cmath>
@@ -37,7 +40,20 @@ using tag_bits = uint16_t;
 using type_bits = uint64_t;
 
 
-/** encode a floating point value to a string. */
+namespace detail {
+inline size_t to_chars_float_(substr buf, float val) { return format_float_shortest(buf, val); }
+inline size_t to_chars_float_(substr buf, double val) { return format_float_shortest(buf, val); }
+template<class T> size_t to_chars_float_(substr buf, T val) { return to_chars(buf, val); }
+inline bool from_chars_float_fast_(csubstr buf, float *C4_RESTRICT val) { return scan_float_fast(buf, val); }
+inline bool from_chars_float_fast_(csubstr buf, double *C4_RESTRICT val) { return scan_float_fast(buf, val); }
+template<class T> bool from_chars_float_fast_(csubstr, T *C4_RESTRICT) { return false; }
+} // namespace detail
+
+
+/** encode a floating point value to a string. Floats and doubles
+ * are written with the shortest representation which reads back to
+ * the same value.
+ * @see detail::format_float_shortest() */
 template<class T>
 size_t to_chars_float(substr buf, T val)
 {
@@ -49,18 +65,24 @@ size_t to_chars_float(substr buf, T val)
         return to_chars(buf, csubstr(".inf"));
     else if(C4_UNLIKELY(val == -std::numeric_limits<T>::infinity()))
         return to_chars(buf, csubstr("-.inf"));
-    return to_chars(buf, val);
+    return detail::to_chars_float_(buf, val);
     C4_SUPPRESS_WARNING_GCC_CLANG_POP
 }
 
 
 /** decode a floating point from string. Accepts special values: .nan,
- * .inf, -.inf */
+ * .inf, -.inf. Short decimal numbers are read with an exact fast
+ * path; everything else goes through c4core's from_chars().
+ * @see detail::scan_float_fast() */
 template<class T>
 bool from_chars_float(csubstr buf, T *C4_RESTRICT val)
 {
     static_assert(std::is_floating_point<T>::value, "must be floating point");
-    if(C4_LIKELY(from_chars(buf, val)))
+    if(C4_LIKELY(detail::from_chars_float_fast_(buf, val)))
+    {
+        return true;
+    }
+    else if(C4_LIKELY(from_chars(buf, val)))
     {
         return true;
     }
@@ -86,6 +108,41 @@ bool from_chars_float(csubstr buf, T *C4_RESTRICT val)
 }
 
 
+namespace detail {
+
+/** an upper bound on the size of the serialization of T, or 0 if
+ * it is not known. Used to reserve the arena in bulk operations. */
+template<class T, class=void>
+struct serialized_max_len
+{
+    enum : size_t { value = 0 };
+};
+template<class T>
+struct serialized_max_len<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    // sign, digits, and the rounding of digits10. bool may be written as "false"
+    enum : size_t { value = (size_t)std::numeric_limits<T>::digits10 + 3u < 5u ? 5u : (size_t)std::numeric_limits<T>::digits10 + 3u };
+};
+template<> struct serialized_max_len<float> { enum : size_t { value = fpconv_max_chars }; };
+template<> struct serialized_max_len<double> { enum : size_t { value = fpconv_max_chars }; };
+
+template<class T>
+typename std::enable_if< ! std::is_floating_point<T>::value, bool>::type
+inline from_chars_val(csubstr buf, T *C4_RESTRICT v)
+{
+    return from_chars(buf, v);
+}
+
+template<class T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+inline from_chars_val(csubstr buf, T *C4_RESTRICT v)
+{
+    return from_chars_float(buf, v);
+}
+
+} // namespace detail
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -148,6 +205,9 @@ typedef enum : type_bits {
     VALTAG  = c4bit(11),    ///< the val has an explicit tag/type
     VALQUO  = c4bit(12),    ///< the val is quoted by '', "", > or |
     KEYQUO  = c4bit(13),    ///< the key is quoted by '', "", > or |
+    FLOW_SL = c4bit(14),    ///< emit this container in flow style, in a single line: {a: 1, b: [c, d]}
+    FLOW_ML = c4bit(15),    ///< emit this container in flow style, with one child per line
+    _FLOWMASK = FLOW_SL|FLOW_ML,
     KEYVAL  = KEY|VAL,
     KEYSEQ  = KEY|SEQ,
     KEYMAP  = KEY|MAP,
@@ -228,6 +288,9 @@ public:
     bool is_key_quoted() const { return (type & (KEY|KEYQUO)) == (KEY|KEYQUO); }
     bool is_val_quoted() const { return (type & (VAL|VALQUO)) == (VAL|VALQUO); }
     bool is_quoted() const { return (type & (KEY|KEYQUO)) == (KEY|KEYQUO) || (type & (VAL|VALQUO)) == (VAL|VALQUO); }
+    bool is_flow_sl() const { return (type & FLOW_SL) != 0 && (type & (MAP|SEQ)) != 0; }
+    bool is_flow_ml() const { return (type & FLOW_ML) != 0 && (type & (MAP|SEQ)) != 0; }
+    bool is_flow() const { return (type & _FLOWMASK) != 0 && (type & (MAP|SEQ)) != 0; }
 
     #if defined(__clang__)
     #   pragma clang diagnostic pop
@@ -370,10 +433,23 @@ struct NodeData
     size_t     m_last_child;
     size_t     m_next_sibling;
     size_t     m_prev_sibling;
+    size_t     m_num_children;
 };
 C4_MUST_BE_TRIVIAL_COPY(NodeData);
 
 
+/** the span of a node in the original YAML source, kept by the tree
+ * to emit unmodified nodes verbatim. @see Tree::src_span() */
+struct SrcSpan
+{
+    size_t begin;        ///< offset of the start of the node's first line, or NONE if the node has no span
+    size_t end;          ///< offset of the end of the node's last line
+    size_t indentation;  ///< column of the node's first token (or of its "- " marker)
+    bool   dirty;        ///< whether the node or any of its descendants was modified after parsing
+};
+C4_MUST_BE_TRIVIAL_COPY(SrcSpan);
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -564,6 +640,9 @@ public:
     C4_ALWAYS_INLINE bool is_key_quoted(size_t node) const { return _p(node)->m_type.is_key_quoted(); }
     C4_ALWAYS_INLINE bool is_val_quoted(size_t node) const { return _p(node)->m_type.is_val_quoted(); }
     C4_ALWAYS_INLINE bool is_quoted(size_t node) const { return _p(node)->m_type.is_quoted(); }
+    C4_ALWAYS_INLINE bool is_flow_sl(size_t node) const { return _p(node)->m_type.is_flow_sl(); }
+    C4_ALWAYS_INLINE bool is_flow_ml(size_t node) const { return _p(node)->m_type.is_flow_ml(); }
+    C4_ALWAYS_INLINE bool is_flow(size_t node) const { return _p(node)->m_type.is_flow(); }
 
     C4_ALWAYS_INLINE bool parent_is_seq(size_t node) const { RYML_ASSERT(has_parent(node)); return is_seq(_p(node)->m_parent); }
     C4_ALWAYS_INLINE bool parent_is_map(size_t node) const { RYML_ASSERT(has_parent(node)); return is_map(_p(node)->m_parent); }
@@ -607,15 +686,24 @@ public:
     size_t prev_sibling(size_t node) const { return _p(node)->m_prev_sibling; }
     size_t next_sibling(size_t node) const { return _p(node)->m_next_sibling; }
 
-    /** O(#num_children) */
-    size_t num_children(size_t node) const;
+    /** O(1) */
+    size_t num_children(size_t node) const { return _p(node)->m_num_children; }
     size_t child_pos(size_t node, size_t ch) const;
     size_t first_child(size_t node) const { return _p(node)->m_first_child; }
     size_t last_child(size_t node) const { return _p(node)->m_last_child; }
+    /** O(min(pos, num_children-pos)) */
     size_t child(size_t node, size_t pos) const;
+    /** O(num_children): walks the children. To look up many keys in
+     * the same map, use find_children() */
     size_t find_child(size_t node, csubstr const& key) const;
-
-    /** O(#num_siblings) */
+    /** look up several keys in a map: for each of the @p num_names
+     * names, write to @p children the first child with that key, or
+     * NONE (like find_child()). The keys of the children are indexed
+     * first, so this is O(num_children + num_names), instead of
+     * O(num_children * num_names) with find_child(). */
+    void find_children(size_t node, csubstr const* names, size_t num_names, size_t *children) const;
+
+    /** O(1) */
     /** counts with this */
     size_t num_siblings(size_t node) const { return is_root(node) ? 1 : num_children(_p(node)->m_parent); }
     /** does not count with this */
@@ -644,8 +732,8 @@ public:
     void to_doc(size_t node, type_bits more_flags=0);
     void to_stream(size_t node, type_bits more_flags=0);
 
-    void set_key(size_t node, csubstr key) { RYML_ASSERT(has_key(node)); _p(node)->m_key.scalar = key; }
-    void set_val(size_t node, csubstr val) { RYML_ASSERT(has_val(node)); _p(node)->m_val.scalar = val; }
+    void set_key(size_t node, csubstr key) { RYML_ASSERT(has_key(node)); _p(node)->m_key.scalar = key; _src_dirty(node); }
+    void set_val(size_t node, csubstr val) { RYML_ASSERT(has_val(node)); _p(node)->m_val.scalar = val; _src_dirty(node); }
 
     void set_key_tag(size_t node, csubstr tag) { RYML_ASSERT(has_key(node)); _p(node)->m_key.tag = tag; _add_flags(node, KEYTAG); }
     void set_val_tag(size_t node, csubstr tag) { RYML_ASSERT(has_val(node) || is_container(node)); _p(node)->m_val.tag = tag; _add_flags(node, VALTAG); }
@@ -716,6 +804,13 @@ public:
     inline size_t prepend_child(size_t parent) { return insert_child(parent, NONE); }
     inline size_t  append_child(size_t parent) { return insert_child(parent, last_child(parent)); }
 
+    /** create and append num new children of "parent". The node
+     * buffer is grown at most once, and the children are linked in
+     * a single pass.
+     * @return the id of the first new child, or NONE if num is
+     * zero. The remaining new children follow it in sibling order. */
+    size_t append_children(size_t parent, size_t num);
+
 public:
 
     #if defined(__clang__)
@@ -846,6 +941,51 @@ public:
 
     /** @} */
 
+public:
+
+    /** @name source spans
+     *
+     * Optionally, the tree can remember the spans of its container
+     * nodes in the original YAML source (see
+     * Parser::parse_in_arena_with_spans()). Every modification of a
+     * node marks the node and its ancestors as dirty, and the emitter
+     * copies the source of the nodes which are not dirty verbatim,
+     * keeping their comments and formatting.
+     *
+     * The source buffer is not owned by the tree: it must outlive the
+     * tree and be kept unmodified while the spans are enabled. */
+    /** @{ */
+
+    /** start keeping source spans, referring to the given source
+     * buffer. All the nodes start with no span, and clean. */
+    void enable_src_spans(csubstr src);
+    /** stop keeping source spans, and release their memory */
+    void disable_src_spans();
+    bool has_src_spans() const { return m_src_spans != nullptr; }
+
+    /** set the span of a node: the lines [begin, end) of the source,
+     * with the node starting at the given column of the first line */
+    void set_src_span(size_t node, size_t begin, size_t end, size_t indentation);
+
+    /** get the source of the node, if the node has a span and neither
+     * the node nor any of its descendants was modified since the span
+     * was set. Otherwise, return an empty csubstr with a null str. */
+    csubstr src_span(size_t node) const
+    {
+        if(!m_src_spans)
+            return {};
+        SrcSpan const& s = m_src_spans[node];
+        if(s.dirty || s.begin == NONE)
+            return {};
+        return m_src.range(s.begin, s.end);
+    }
+    /** the column of the node's first token in its source span */
+    size_t src_span_indentation(size_t node) const { RYML_ASSERT(m_src_spans); return m_src_spans[node].indentation; }
+    /** whether the node or any of its descendants was modified */
+    bool is_src_dirty(size_t node) const { return m_src_spans == nullptr || m_src_spans[node].dirty; }
+
+    /** @} */
+
 public:
 
     /** @name internal string arena */
@@ -905,6 +1045,54 @@ public:
         return rem;
     }
 
+    /** create and append num new children of "parent", with their
+     * values serialized from the given array. The nodes are created
+     * in a single pass, and when the maximum serialized size of T is
+     * known, the arena is grown at most once. This is much faster
+     * than appending and serializing each child individually.
+     * The parent must be a seq; if it is empty and has no type yet,
+     * it is made a seq. Otherwise, an error is raised.
+     * @return the id of the first new child, or NONE if num is zero
+     * @see append_children() */
+    template<class T>
+    size_t append_children_serialized(size_t parent, T const* C4_RESTRICT vals, size_t num)
+    {
+        if( ! is_container(parent) && ! has_val(parent) && ! has_children(parent))
+            _add_flags(parent, SEQ);
+        _RYML_CB_CHECK(m_callbacks, is_seq(parent)); // the children have no keys
+        const size_t first = append_children(parent, num);
+        const size_t max_len = detail::serialized_max_len<T>::value;
+        if(max_len && num * max_len > arena_slack())
+            _grow_arena(num * max_len);
+        NodeData *C4_RESTRICT buf = m_buf; // children are not relocated from now on
+        for(size_t i = 0, ich = first; i < num; ++i, ich = buf[ich].m_next_sibling)
+        {
+            csubstr s = to_arena(vals[i]);
+            buf[ich].m_type = VAL;
+            buf[ich].m_val.scalar = s;
+        }
+        return first;
+    }
+
+    /** deserialize the values of the first num children of "parent"
+     * into the given array, in a single pass.
+     * @return false if the parent has less than num children, or if
+     * any of the values failed to deserialize. */
+    template<class T>
+    bool deserialize_children(size_t parent, T *C4_RESTRICT vals, size_t num) const
+    {
+        bool ok = true;
+        size_t ich = first_child(parent);
+        for(size_t i = 0; i < num; ++i, ich = m_buf[ich].m_next_sibling)
+        {
+            if(ich == NONE)
+                return false;
+            RYML_ASSERT(has_val(ich));
+            ok &= detail::from_chars_val(m_buf[ich].m_val.scalar, &vals[i]);
+        }
+        return ok;
+    }
+
     /** copy the given substr to the tree's arena, growing it by the required size
      * @note Growing the arena may cause relocation of the entire
      * existing arena, and thus change the contents of individual nodes.
@@ -946,13 +1134,13 @@ public:
         if(arena_cap > m_arena.len)
         {
             substr buf;
-            buf.str = (char*) m_callbacks.m_allocate(arena_cap, m_arena.str, m_callbacks.m_user_data);
+            buf.str = _RYML_CB_ALLOC_SITE(m_callbacks, char, arena_cap, m_arena.str, ALLOC_SITE_TREE_ARENA);
             buf.len = arena_cap;
             if(m_arena.str)
             {
                 RYML_ASSERT(m_arena.len >= 0);
                 _relocate(buf); // does a memcpy and changes nodes using the arena
-                m_callbacks.m_free(m_arena.str, m_arena.len, m_callbacks.m_user_data);
+                detail::free_at(m_callbacks, m_arena.str, m_arena.len, ALLOC_SITE_TREE_ARENA);
             }
             m_arena = buf;
         }
@@ -1101,14 +1289,19 @@ public:
     }
     #endif
 
-    inline void _set_flags(size_t node, NodeType_e f) { _check_next_flags(node, f); _p(node)->m_type = f; }
-    inline void _set_flags(size_t node, type_bits  f) { _check_next_flags(node, f); _p(node)->m_type = f; }
+    inline void _set_flags(size_t node, NodeType_e f) { _check_next_flags(node, f); _p(node)->m_type = f; _src_dirty(node); }
+    inline void _set_flags(size_t node, type_bits  f) { _check_next_flags(node, f); _p(node)->m_type = f; _src_dirty(node); }
+
+    inline void _add_flags(size_t node, NodeType_e f) { NodeData *d = _p(node); type_bits fb = f |  d->m_type; _check_next_flags(node, fb); d->m_type = (NodeType_e) fb; _src_dirty(node); }
+    inline void _add_flags(size_t node, type_bits  f) { NodeData *d = _p(node);                f |= d->m_type; _check_next_flags(node,  f); d->m_type = f; _src_dirty(node); }
 
-    inline void _add_flags(size_t node, NodeType_e f) { NodeData *d = _p(node); type_bits fb = f |  d->m_type; _check_next_flags(node, fb); d->m_type = (NodeType_e) fb; }
-    inline void _add_flags(size_t node, type_bits  f) { NodeData *d = _p(node);                f |= d->m_type; _check_next_flags(node,  f); d->m_type = f; }
+    inline void _rem_flags(size_t node, NodeType_e f) { NodeData *d = _p(node); type_bits fb = d->m_type & ~f; _check_next_flags(node, fb); d->m_type = (NodeType_e) fb; _src_dirty(node); }
+    inline void _rem_flags(size_t node, type_bits  f) { NodeData *d = _p(node);            f = d->m_type & ~f; _check_next_flags(node,  f); d->m_type = f; _src_dirty(node); }
 
-    inline void _rem_flags(size_t node, NodeType_e f) { NodeData *d = _p(node); type_bits fb = d->m_type & ~f; _check_next_flags(node, fb); d->m_type = (NodeType_e) fb; }
-    inline void _rem_flags(size_t node, type_bits  f) { NodeData *d = _p(node);            f = d->m_type & ~f; _check_next_flags(node,  f); d->m_type = f; }
+    /** mark the node and its ancestors as modified, if the tree
+     * keeps source spans */
+    inline void _src_dirty(size_t node) { if(C4_UNLIKELY(m_src_spans != nullptr)) _do_src_dirty(node); }
+    void _do_src_dirty(size_t node);
 
     void _set_key(size_t node, csubstr key, type_bits more_flags=0)
     {
@@ -1190,6 +1383,7 @@ public:
         auto *C4_RESTRICT n = _p(node);
         n->m_type.rem(SEQ);
         n->m_type.add(MAP);
+        _src_dirty(node);
     }
 
     size_t _do_reorder(size_t *node, size_t count);
@@ -1236,6 +1430,7 @@ public:
     inline void _clear_type(size_t node)
     {
         _p(node)->m_type = NOTYPE;
+        _src_dirty(node);
     }
 
     inline void _clear(size_t node)
@@ -1247,6 +1442,9 @@ public:
         n->m_parent = NONE;
         n->m_first_child = NONE;
         n->m_last_child = NONE;
+        n->m_num_children = 0;
+        if(m_src_spans)
+            m_src_spans[node] = SrcSpan{NONE, NONE, 0, true};
     }
 
     inline void _clear_key(size_t node)
@@ -1291,6 +1489,9 @@ public:
 
     Callbacks m_callbacks;
 
+    SrcSpan * m_src_spans;
+    csubstr m_src;
+
 };
 
 } // namespace yml
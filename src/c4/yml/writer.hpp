@@ -5,9 +5,19 @@
 #include "./common.hpp"
 #endif
 
+#ifndef _C4_YML_DETAIL_STACK_HPP_
+#include "./detail/stack.hpp"
+#endif
+
 #include <c4/substr.hpp>
-#include <stdio.h>  // fwrite(), fputc()
-#include <string.h> // memcpy()
+#include <stdio.h>  // fwrite()
+#include <string.h> // memcpy(), memset()
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+#include <errno.h>    // errno
+#include <limits.h>   // IOV_MAX
+#include <sys/uio.h>  // writev()
+#include <unistd.h>   // write()
+#endif
 
 
 namespace c4 {
@@ -26,19 +36,54 @@ inline RepC indent_to(size_t num_levels)
 }
 
 
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-/** A writer that outputs to a file. Defaults to stdout. */
-struct WriterFile
+#ifndef RYML_WRITER_STAGE_SIZE
+/** the size of the staging buffer of the writers to files and
+ * streams, allocated when no buffer is given to their constructor */
+#define RYML_WRITER_STAGE_SIZE 4096
+#endif
+
+
+namespace detail {
+
+/** Base for the writers which output to a file or stream. The output
+ * is staged in a buffer, and handed to the sink in large blocks via
+ * Sink::_flush_out(const char*, size_t). The buffer can be given to
+ * the constructor; otherwise a buffer of RYML_WRITER_STAGE_SIZE is
+ * allocated through the global callbacks on the first write, and
+ * freed in the destructor. The buffer is flushed when the output is
+ * collected with _get(), ie at the end of Emitter::emit().
+ *
+ * @warning The destructor does not flush: if the emit is interrupted
+ * (eg by an error callback which throws), the output which is still
+ * in the buffer is discarded, and the sink receives only the blocks
+ * flushed before the error. */
+template<class Sink>
+struct WriterStaged
 {
-    FILE * m_file;
+    substr m_stage;
+    size_t m_stage_pos;
     size_t m_pos;
+    bool   m_stage_owned;
+    Callbacks m_callbacks;
+
+    WriterStaged(substr stage) : m_stage(), m_stage_pos(0), m_pos(0), m_stage_owned(false), m_callbacks(get_callbacks())
+    {
+        if(stage.len != 0 && stage.str != nullptr)
+            m_stage = stage;
+    }
+
+    ~WriterStaged()
+    {
+        if(m_stage_owned)
+            _RYML_CB_FREE_SITE(m_callbacks, m_stage.str, char, m_stage.len, ALLOC_SITE_WRITER_STAGE);
+    }
 
-    WriterFile(FILE *f = nullptr) : m_file(f ? f : stdout), m_pos(0) {}
+    WriterStaged(WriterStaged const&) = delete;
+    WriterStaged& operator=(WriterStaged const&) = delete;
 
     inline substr _get(bool /*error_on_excess*/)
     {
+        _flush();
         substr sp;
         sp.str = nullptr;
         sp.len = m_pos;
@@ -48,74 +93,113 @@ struct WriterFile
     template<size_t N>
     inline void _do_write(const char (&a)[N])
     {
-        fwrite(a, sizeof(char), N - 1, m_file);
-        m_pos += N - 1;
+        _do_write(csubstr(a, N - 1));
     }
 
     inline void _do_write(csubstr sp)
     {
-        #if defined(__clang__)
-        #   pragma clang diagnostic push
-        #   pragma GCC diagnostic ignored "-Wsign-conversion"
-        #elif defined(__GNUC__)
-        #   pragma GCC diagnostic push
-        #   pragma GCC diagnostic ignored "-Wsign-conversion"
-        #endif
         if(sp.empty()) return;
-        fwrite(sp.str, sizeof(csubstr::char_type), sp.len, m_file);
         m_pos += sp.len;
-        #if defined(__clang__)
-        #   pragma clang diagnostic pop
-        #elif defined(__GNUC__)
-        #   pragma GCC diagnostic pop
-        #endif
+        if(m_stage_pos + sp.len <= m_stage.len)
+        {
+            memcpy(m_stage.str + m_stage_pos, sp.str, sp.len);
+            m_stage_pos += sp.len;
+            return;
+        }
+        _renew_stage();
+        if(sp.len < m_stage.len)
+        {
+            memcpy(m_stage.str, sp.str, sp.len);
+            m_stage_pos = sp.len;
+        }
+        else
+        {
+            static_cast<Sink*>(this)->_flush_out(sp.str, sp.len);
+        }
     }
 
     inline void _do_write(const char c)
     {
-        fputc(c, m_file);
+        if(C4_UNLIKELY(m_stage_pos == m_stage.len))
+            _renew_stage();
+        m_stage.str[m_stage_pos++] = c;
         ++m_pos;
     }
 
     inline void _do_write(RepC const rc)
     {
-        for(size_t i = 0; i < rc.num_times; ++i)
+        m_pos += rc.num_times;
+        size_t rem = rc.num_times;
+        while(rem)
+        {
+            if(m_stage_pos == m_stage.len)
+                _renew_stage();
+            size_t n = m_stage.len - m_stage_pos;
+            n = n < rem ? n : rem;
+            memset(m_stage.str + m_stage_pos, rc.c, n);
+            m_stage_pos += n;
+            rem -= n;
+        }
+    }
+
+    inline void _flush()
+    {
+        if(m_stage_pos)
         {
-            fputc(rc.c, m_file);
+            static_cast<Sink*>(this)->_flush_out(m_stage.str, m_stage_pos);
+            m_stage_pos = 0;
+        }
+    }
+
+    /** flush the buffer, allocating it if there is none yet */
+    C4_NO_INLINE void _renew_stage()
+    {
+        _flush();
+        if(m_stage.str == nullptr)
+        {
+            m_stage.str = _RYML_CB_ALLOC_SITE(m_callbacks, char, RYML_WRITER_STAGE_SIZE, nullptr, ALLOC_SITE_WRITER_STAGE);
+            m_stage.len = RYML_WRITER_STAGE_SIZE;
+            m_stage_owned = true;
         }
-        m_pos += rc.num_times;
     }
 };
 
+} // namespace detail
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
-/** A writer that outputs to an STL-like ostream. */
-template<class OStream>
-struct WriterOStream
+/** A writer that outputs to a file. Defaults to stdout. The output is
+ * staged, and written with large fwrite() calls.
+ * @see detail::WriterStaged */
+struct WriterFile : public detail::WriterStaged<WriterFile>
 {
-    OStream& m_stream;
-    size_t   m_pos;
+    FILE * m_file;
 
-    WriterOStream(OStream &s) : m_stream(s), m_pos(0) {}
+    WriterFile(FILE *f = nullptr, substr stage = {}) : detail::WriterStaged<WriterFile>(stage), m_file(f ? f : stdout) {}
 
-    inline substr _get(bool /*error_on_excess*/)
+    inline void _flush_out(const char *str, size_t len)
     {
-        substr sp;
-        sp.str = nullptr;
-        sp.len = m_pos;
-        return sp;
+        fwrite(str, sizeof(char), len, m_file);
     }
+};
 
-    template<size_t N>
-    inline void _do_write(const char (&a)[N])
-    {
-        m_stream.write(a, N - 1);
-        m_pos += N - 1;
-    }
 
-    inline void _do_write(csubstr sp)
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A writer that outputs to an STL-like ostream. The output is
+ * staged, and written with large write() calls.
+ * @see detail::WriterStaged */
+template<class OStream>
+struct WriterOStream : public detail::WriterStaged<WriterOStream<OStream>>
+{
+    OStream& m_stream;
+
+    WriterOStream(OStream &s, substr stage = {}) : detail::WriterStaged<WriterOStream<OStream>>(stage), m_stream(s) {}
+
+    inline void _flush_out(const char *str, size_t len)
     {
         #if defined(__clang__)
         #   pragma clang diagnostic push
@@ -124,31 +208,50 @@ struct WriterOStream
         #   pragma GCC diagnostic push
         #   pragma GCC diagnostic ignored "-Wsign-conversion"
         #endif
-        if(sp.empty()) return;
-        m_stream.write(sp.str, sp.len);
-        m_pos += sp.len;
+        m_stream.write(str, len);
         #if defined(__clang__)
         #   pragma clang diagnostic pop
         #elif defined(__GNUC__)
         #   pragma GCC diagnostic pop
         #endif
     }
+};
 
-    inline void _do_write(const char c)
-    {
-        m_stream.put(c);
-        ++m_pos;
-    }
 
-    inline void _do_write(RepC const rc)
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+#define RYML_HAS_WRITER_FD
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** A writer that outputs to a POSIX file descriptor, bypassing
+ * stdio. The output is staged, and written with large write(2)
+ * calls. Give a large buffer to the constructor to reduce the number
+ * of syscalls.
+ * @see detail::WriterStaged */
+struct WriterFd : public detail::WriterStaged<WriterFd>
+{
+    int m_fd;
+
+    WriterFd(int fd, substr stage = {}) : detail::WriterStaged<WriterFd>(stage), m_fd(fd) {}
+
+    inline void _flush_out(const char *str, size_t len)
     {
-        for(size_t i = 0; i < rc.num_times; ++i)
+        while(len)
         {
-            m_stream.put(rc.c);
+            ssize_t ret = ::write(m_fd, str, len);
+            if(ret < 0)
+            {
+                if(errno == EINTR)
+                    continue;
+                c4::yml::error("could not write to the file descriptor");
+                return;
+            }
+            str += ret;
+            len -= (size_t)ret;
         }
-        m_pos += rc.num_times;
     }
 };
+#endif
 
 
 //-----------------------------------------------------------------------------
@@ -223,6 +326,316 @@ struct WriterBuf
 };
 
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/** a writer to a resizeable std::string/std::vector-like container.
+ * The container is grown geometrically as the output is produced, so
+ * the emit is done in a single traversal of the tree. Any container
+ * providing resize(size_t) and to_substr() can be used.
+ *
+ * When done, the container is shrunk to the emitted size, but only if
+ * it had to be grown; a container which was large enough to begin with
+ * is left untouched, like with the two-pass emitrs(). */
+template<class CharOwningContainer>
+struct WriterResizable
+{
+    CharOwningContainer *m_cont;
+    substr m_buf;
+    size_t m_pos;
+    size_t m_initial_size;
+
+    WriterResizable(CharOwningContainer *cont) : m_cont(cont), m_buf(to_substr(*cont)), m_pos(0), m_initial_size(m_buf.len)
+    {
+        RYML_ASSERT(cont != nullptr);
+    }
+
+    inline substr _get(bool /*error_on_excess*/)
+    {
+        if(m_buf.len != m_initial_size)
+        {
+            m_cont->resize(m_pos > m_initial_size ? m_pos : m_initial_size);
+            m_buf = to_substr(*m_cont);
+        }
+        return m_buf.first(m_pos);
+    }
+
+    template<size_t N>
+    inline void _do_write(const char (&a)[N])
+    {
+        _reserve(N-1);
+        RYML_ASSERT( ! m_buf.overlaps(a));
+        memcpy(m_buf.str + m_pos, a, N-1);
+        m_pos += N-1;
+    }
+
+    inline void _do_write(csubstr sp)
+    {
+        if(sp.empty()) return;
+        _reserve(sp.len);
+        RYML_ASSERT( ! sp.overlaps(m_buf));
+        memcpy(m_buf.str + m_pos, sp.str, sp.len);
+        m_pos += sp.len;
+    }
+
+    inline void _do_write(const char c)
+    {
+        _reserve(1);
+        m_buf.str[m_pos] = c;
+        ++m_pos;
+    }
+
+    inline void _do_write(RepC const rc)
+    {
+        if(!rc.num_times) return;
+        _reserve(rc.num_times);
+        memset(m_buf.str + m_pos, rc.c, rc.num_times);
+        m_pos += rc.num_times;
+    }
+
+private:
+
+    C4_ALWAYS_INLINE void _reserve(size_t more)
+    {
+        if(C4_UNLIKELY(m_pos + more > m_buf.len))
+            _grow(m_pos + more);
+    }
+
+    C4_NO_INLINE void _grow(size_t needed)
+    {
+        size_t sz = 2 * m_buf.len;
+        if(sz < 256)
+            sz = 256;
+        if(sz < needed)
+            sz = needed;
+        m_cont->resize(sz);
+        m_buf = to_substr(*m_cont);
+        RYML_ASSERT(m_buf.len >= needed);
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+namespace detail {
+/** every char value at its own offset, so that a single char can be
+ * referenced in static storage */
+constexpr const char writer_chars[] =
+    "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+    "\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+    "\x20\x21\x22\x23\x24\x25\x26\x27\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+    "\x30\x31\x32\x33\x34\x35\x36\x37\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+    "\x40\x41\x42\x43\x44\x45\x46\x47\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+    "\x50\x51\x52\x53\x54\x55\x56\x57\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+    "\x60\x61\x62\x63\x64\x65\x66\x67\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+    "\x70\x71\x72\x73\x74\x75\x76\x77\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+    "\x80\x81\x82\x83\x84\x85\x86\x87\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+    "\x90\x91\x92\x93\x94\x95\x96\x97\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+    "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+    "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+    "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+    "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+    "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+    "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff";
+/** a block of spaces for referencing indentation in static storage */
+constexpr const char writer_spaces[] = "                                                                                                                                ";
+} // namespace detail
+
+/** A writer which does not copy the output. Instead, it collects a
+ * list of chunks of the output, which point at the bytes already
+ * existing elsewhere: scalars, tags and anchors are referenced in
+ * place in the tree (ie in its arena or in the source buffer), and
+ * separators, quotes and indentation are referenced in static
+ * storage. Adjacent chunks are merged. The resulting chunks are
+ * suitable for scatter-gather output, eg with writev().
+ *
+ * When the scalars do not outlive the emit (as with EventEmitter,
+ * which enables this), set m_copy_scalars: the scalars are then
+ * copied to blocks owned by the writer, allocated through the
+ * callbacks.
+ *
+ * @warning the chunks point at the memory of the tree, which must
+ * outlive the chunks and must not be modified while they are used. */
+struct WriterIovec
+{
+    detail::stack<csubstr, 64> m_chunks;
+    detail::stack<substr, 4> m_blocks; ///< the copies of the scalars, when m_copy_scalars is set
+    size_t m_block_pos;
+    size_t m_pos;
+    bool m_copy_scalars;
+
+    enum : size_t { copy_block_size = 4096 };
+
+    WriterIovec(Callbacks const& cb = get_callbacks()) : m_chunks(cb), m_blocks(cb), m_block_pos(0), m_pos(0), m_copy_scalars(false) {}
+    ~WriterIovec()
+    {
+        for(substr &block : m_blocks)
+            _RYML_CB_FREE_SITE(m_blocks.m_callbacks, block.str, char, block.len, ALLOC_SITE_WRITER_STAGE);
+    }
+
+    WriterIovec(WriterIovec const&) = delete;
+    WriterIovec& operator=(WriterIovec const&) = delete;
+
+    inline substr _get(bool /*error_on_excess*/)
+    {
+        substr sp;
+        sp.str = nullptr;
+        sp.len = m_pos;
+        return sp;
+    }
+
+    /** the chunks of the output */
+    csubstr const* chunks() const { return m_chunks.begin(); }
+    size_t num_chunks() const { return m_chunks.size(); }
+
+    /** copy the chunks to the given buffer. Return the number of bytes
+     * of the output, which is larger than the buffer if it is too
+     * small; in that case nothing is copied. */
+    size_t gather(substr buf) const
+    {
+        if(m_pos > buf.len)
+            return m_pos;
+        size_t pos = 0;
+        for(csubstr const& chunk : m_chunks)
+        {
+            memcpy(buf.str + pos, chunk.str, chunk.len);
+            pos += chunk.len;
+        }
+        RYML_ASSERT(pos == m_pos);
+        return pos;
+    }
+
+    #ifdef RYML_HAS_WRITER_FD
+    /** write the chunks to a POSIX file descriptor with writev(2). Return the number of bytes written. */
+    size_t writev(int fd) const;
+    #endif
+
+    template<size_t N>
+    inline void _do_write(const char (&a)[N])
+    {
+        _push(csubstr(a, N - 1));
+    }
+
+    inline void _do_write(csubstr sp)
+    {
+        _push(m_copy_scalars ? _copy(sp) : sp);
+    }
+
+    inline void _do_write(const char c)
+    {
+        _push(csubstr(detail::writer_chars + (uint8_t)c, 1));
+    }
+
+    inline void _do_write(RepC const rc)
+    {
+        if(rc.c == ' ')
+        {
+            const size_t block = sizeof(detail::writer_spaces) - 1;
+            for(size_t rem = rc.num_times; rem; )
+            {
+                const size_t n = rem < block ? rem : block;
+                _push(csubstr(detail::writer_spaces, n));
+                rem -= n;
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < rc.num_times; ++i)
+                _do_write(rc.c);
+        }
+    }
+
+    inline void _push(csubstr sp)
+    {
+        if(sp.empty()) return;
+        m_pos += sp.len;
+        if(m_chunks.size())
+        {
+            csubstr &last = m_chunks.top();
+            if(last.str + last.len == sp.str)
+            {
+                last.len += sp.len;
+                return;
+            }
+        }
+        m_chunks.push(sp);
+    }
+
+    /** copy the span to the current block; the blocks are never
+     * moved, so the chunks can point at them */
+    csubstr _copy(csubstr sp)
+    {
+        if(sp.empty()) return sp;
+        if(m_blocks.empty() || m_block_pos + sp.len > m_blocks.top().len)
+        {
+            const size_t sz = sp.len > copy_block_size ? sp.len : copy_block_size;
+            m_blocks.push(substr(_RYML_CB_ALLOC_SITE(m_blocks.m_callbacks, char, sz, nullptr, ALLOC_SITE_WRITER_STAGE), sz));
+            m_block_pos = 0;
+        }
+        substr dst = m_blocks.top().sub(m_block_pos, sp.len);
+        memcpy(dst.str, sp.str, sp.len);
+        m_block_pos += sp.len;
+        return dst;
+    }
+};
+
+#ifdef RYML_HAS_WRITER_FD
+inline size_t WriterIovec::writev(int fd) const
+{
+    #ifdef IOV_MAX
+    enum : size_t { max_iov = IOV_MAX < 1024 ? IOV_MAX : 1024 };
+    #else
+    enum : size_t { max_iov = 16 };
+    #endif
+    struct iovec iov[max_iov];
+    size_t written = 0;
+    size_t ichunk = 0;
+    size_t offset = 0; // into the current chunk, after a partial write
+    while(ichunk < m_chunks.size())
+    {
+        size_t num = 0;
+        for(size_t i = ichunk; i < m_chunks.size() && num < max_iov; ++i, ++num)
+        {
+            csubstr chunk = m_chunks[i];
+            if(i == ichunk)
+                chunk = chunk.sub(offset);
+            iov[num].iov_base = const_cast<char*>(chunk.str);
+            iov[num].iov_len = chunk.len;
+        }
+        ssize_t ret = ::writev(fd, iov, (int)num);
+        if(ret < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            c4::yml::error("could not write to the file descriptor");
+            return written;
+        }
+        written += (size_t)ret;
+        // advance past the written chunks
+        size_t rem = (size_t)ret;
+        while(rem && ichunk < m_chunks.size())
+        {
+            const size_t avail = m_chunks[ichunk].len - offset;
+            if(rem < avail)
+            {
+                offset += rem;
+                rem = 0;
+            }
+            else
+            {
+                rem -= avail;
+                offset = 0;
+                ++ichunk;
+            }
+        }
+    }
+    return written;
+}
+#endif
+
+
 } // namespace yml
 } // namespace c4
 
@@ -4,6 +4,7 @@
 #include "c4/yml/tree.hpp"
 #include "c4/yml/node.hpp"
 #include "c4/yml/emit.hpp"
+#include "c4/yml/emit_events.hpp"
 #include "c4/yml/parse.hpp"
 #include "c4/yml/preprocess.hpp"
 
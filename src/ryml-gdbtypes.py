@@ -370,7 +370,6 @@ def qdump__c4__yml__detail__ReferenceResolver__refdata(d, value):
         with Children(d):
             d.putSubItem("type", value["type"])
             d.putSubItem("node", value["node"])
-            _dump_node_index(d, "prev_anchor", value)
             _dump_node_index(d, "target", value)
             _dump_node_index(d, "parent_ref", value)
             _dump_node_index(d, "parent_ref_sibling", value)
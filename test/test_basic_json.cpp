@@ -221,6 +221,27 @@ broken_value: '0.30.2'
 }
 
 
+TEST(emit_json, escapes)
+{
+    Tree t;
+    NodeRef r = t.rootref();
+    r |= MAP;
+    r["quote"] = "say \"hi\"";
+    r["backslash"] = "C:\\dir\\file";
+    r["ctl"] = "a\bb\fc\nd\re\tf";
+    r["u"] = csubstr("\x01\x1f\0", 3);
+    r["long"] = "a long string with no escapes, then a \"quote\" after more than sixteen chars\n";
+    r["key \"quoted\""] = "1";
+    std::string out;
+    emitrs_json(t, &out);
+    EXPECT_EQ(out, R"({"quote": "say \"hi\"",)"
+                   R"("backslash": "C:\\dir\\file",)"
+                   R"("ctl": "a\bb\fc\nd\re\tf",)"
+                   R"("u": "\u0001\u001f\u0000",)"
+                   R"("long": "a long string with no escapes, then a \"quote\" after more than sixteen chars\n",)"
+                   R"("key \"quoted\"": 1})");
+}
+
 //-------------------------------------------
 // this is needed to use the test case library
 Case const* get_case(csubstr /*name*/)
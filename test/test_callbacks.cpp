@@ -1,6 +1,7 @@
 #include "./test_case.hpp"
 #ifndef RYML_SINGLE_HEADER
 #include "c4/yml/common.hpp"
+#include "c4/yml/alloc_stats.hpp"
 #endif
 #include <stdexcept>
 
@@ -346,6 +347,44 @@ TEST(RYML_ASSERT, basic)
 }
 
 
+#ifndef RYML_SINGLE_HEADER
+TEST(AllocStats, counts_per_site)
+{
+    AllocStats stats;
+    {
+        const Callbacks cb = stats.callbacks();
+        Parser parser(cb);
+        Tree t(cb);
+        parser.parse_in_arena_with_spans("file.yml", "a: 1\nb: [x, y, z]\nc: {d: 2, e: \"f\\tg\"}\n", &t);
+        EXPECT_EQ(t["c"]["e"].val(), "f\tg");
+        EXPECT_GT(stats.total().num_allocs, 0u);
+        EXPECT_GT(stats.total().bytes_live, 0u);
+        EXPECT_GT(stats.site(ALLOC_SITE_TREE_NODES).bytes_total, 0u);
+        EXPECT_GT(stats.site(ALLOC_SITE_TREE_ARENA).bytes_total, 0u);
+        EXPECT_GT(stats.site(ALLOC_SITE_TREE_SPANS).bytes_total, 0u);
+        EXPECT_GE(stats.total().bytes_peak, stats.total().bytes_live);
+    }
+    // everything was given back, to the same site where it was taken
+    size_t num_allocs = 0, bytes_total = 0;
+    for(int i = 0; i < ALLOC_NUM_SITES; ++i)
+    {
+        AllocCounts const& c = stats.site((AllocSite_e)i);
+        EXPECT_EQ(c.bytes_live, 0u) << AllocStats::site_name((AllocSite_e)i);
+        EXPECT_EQ(c.num_allocs, c.num_frees) << AllocStats::site_name((AllocSite_e)i);
+        num_allocs += c.num_allocs;
+        bytes_total += c.bytes_total;
+    }
+    EXPECT_EQ(stats.total().bytes_live, 0u);
+    EXPECT_EQ(stats.total().num_allocs, num_allocs);
+    EXPECT_EQ(stats.total().bytes_total, bytes_total);
+    EXPECT_EQ(detail::get_alloc_site(), ALLOC_SITE_OTHER);
+    stats.reset();
+    EXPECT_EQ(stats.total().num_allocs, 0u);
+    EXPECT_EQ(stats.total().bytes_peak, 0u);
+}
+#endif
+
+
 // FIXME this is here merely to avoid a linker error
 Case const* get_case(csubstr)
 {
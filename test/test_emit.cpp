@@ -0,0 +1,589 @@
+#ifndef RYML_SINGLE_HEADER
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include "c4/yml/emit_events.hpp"
+#include "c4/yml/alloc_stats.hpp"
+#include <c4/yml/detail/checks.hpp>
+#endif
+
+#include <gtest/gtest.h>
+#include <sstream>
+#ifdef RYML_HAS_WRITER_FD
+#include <unistd.h>
+#endif
+
+namespace c4 {
+namespace yml {
+
+std::string emit2str(Tree const& t, EmitType_e type)
+{
+    const size_t len = EmitterBuf(substr{}).emit(type, t, /*error_on_excess*/false).len;
+    std::string s(len, '\0');
+    EmitterBuf em(to_substr(s));
+    csubstr out = em.emit(type, t);
+    EXPECT_EQ(out.len, len);
+    return s;
+}
+
+void test_roundtrip(Tree const& t, EmitType_e type)
+{
+    std::string out = emit2str(t, type);
+    Tree t2 = parse_in_arena(to_csubstr(out));
+    EXPECT_EQ(emitrs<std::string>(t2), emitrs<std::string>(t)) << out;
+}
+
+
+//-----------------------------------------------------------------------------
+
+TEST(emit_flow, single_line)
+{
+    Tree t = parse_in_arena("{a: 1, b: [c, d, {e: f}], g: {}, h: [], i: 'x,y', j: ~}");
+    EXPECT_EQ(emit2str(t, YAML_FLOW_SL), "{a: 1, b: [c, d, {e: f}], g: {}, h: [], i: 'x,y', j: ~}\n");
+    test_roundtrip(t, YAML_FLOW_SL);
+}
+
+TEST(emit_flow, multi_line)
+{
+    Tree t = parse_in_arena("{a: 1, b: [c, d, {e: f}], g: {}}");
+    EXPECT_EQ(emit2str(t, YAML_FLOW_ML), R"({
+  a: 1,
+  b: [
+    c,
+    d,
+    {
+      e: f
+    }
+  ],
+  g: {}
+}
+)");
+    test_roundtrip(t, YAML_FLOW_ML);
+}
+
+TEST(emit_flow, newlines_are_escaped)
+{
+    Tree t;
+    t.rootref() |= SEQ;
+    t.rootref().append_child() = "a\nb";
+    t.rootref().append_child() = "say \"hi\"\n";
+    EXPECT_EQ(emit2str(t, YAML_FLOW_SL), "[\"a\\nb\", \"say \\\"hi\\\"\\n\"]\n");
+    test_roundtrip(t, YAML_FLOW_SL);
+}
+
+TEST(emit_flow, anchors_and_refs)
+{
+    Tree t = parse_in_arena("{a: &anc 1, b: *anc}");
+    EXPECT_EQ(emit2str(t, YAML_FLOW_SL), "{a: &anc 1, b: *anc}\n");
+}
+
+TEST(emit_flow, stream)
+{
+    Tree t = parse_in_arena("--- {a: 0}\n--- [b]\n--- c\n");
+    EXPECT_EQ(emit2str(t, YAML_FLOW_SL), "--- {a: 0}\n--- [b]\n--- c\n");
+    EXPECT_EQ(emit2str(t, YAML_FLOW_ML), "--- {\n  a: 0\n}\n--- [\n  b\n]\n--- c\n");
+}
+
+TEST(emit_flow, per_node)
+{
+    Tree t = parse_in_arena("{a: [0, 1], b: {c: d}, e: [[2, 3]]}");
+    t["a"] |= FLOW_SL;
+    t["b"] |= FLOW_ML;
+    t["e"][0] |= FLOW_SL;
+    EXPECT_TRUE(t["a"].is_flow_sl());
+    EXPECT_TRUE(t["b"].is_flow_ml());
+    EXPECT_TRUE(t["b"].is_flow());
+    EXPECT_FALSE(t["e"].is_flow());
+    EXPECT_EQ(emitrs<std::string>(t), R"(a: [0, 1]
+b: {
+    c: d
+  }
+e:
+  - [2, 3]
+)");
+    test_roundtrip(t, YAML);
+    // the flow style is ignored in JSON
+    EXPECT_EQ(emitrs_json<std::string>(t), R"({"a": [0,1],"b": {"c": "d"},"e": [[2,3]]})");
+    // a flow style root
+    t.rootref() |= FLOW_SL;
+    EXPECT_EQ(emitrs<std::string>(t), "{a: [0, 1], b: {c: d}, e: [[2, 3]]}\n");
+}
+
+
+//-----------------------------------------------------------------------------
+
+TEST(emit_scalar, scalar_chars)
+{
+    using namespace detail;
+    EXPECT_EQ(scalar_chars(""), 0u);
+    EXPECT_EQ(scalar_chars("abc"), 0u);
+    EXPECT_EQ(scalar_chars("a:b"), SCALAR_SPECIAL);
+    EXPECT_EQ(scalar_chars("a'b"), SCALAR_SPECIAL|SCALAR_SQUOTE);
+    EXPECT_EQ(scalar_chars("a\"b"), SCALAR_SPECIAL|SCALAR_DQUOTE);
+    EXPECT_EQ(scalar_chars("a\nb"), SCALAR_SPECIAL|SCALAR_NEWLINE);
+    // longer than a SIMD register, with the special chars at either side of it
+    EXPECT_EQ(scalar_chars("0123456789abcdef0123456789"), 0u);
+    EXPECT_EQ(scalar_chars("0123456789abcde[0123456789"), SCALAR_SPECIAL);
+    EXPECT_EQ(scalar_chars("0123456789abcdef0123456789]"), SCALAR_SPECIAL);
+    EXPECT_EQ(scalar_chars("'123456789abcdef0123456789\""), SCALAR_SPECIAL|SCALAR_SQUOTE|SCALAR_DQUOTE);
+    EXPECT_EQ(find_squote_or_newline("0123456789abcdef0123'56789", 0), 20u);
+    EXPECT_EQ(find_squote_or_newline("0123456789abcdef0123'56789", 21), npos);
+    EXPECT_EQ(find_squote_or_newline("01\n3456789abcdef0123'56789", 0), 2u);
+    EXPECT_EQ(find_squote_or_newline("01\n3456789abcdef0123'56789", 3), 21u);
+}
+
+TEST(emit_scalar, quoting)
+{
+    auto emit_val = [](csubstr val){
+        Tree t;
+        t.rootref() |= SEQ;
+        t.rootref().append_child() = val;
+        return emitrs<std::string>(t);
+    };
+    EXPECT_EQ(emit_val("plain"), "- plain\n");
+    EXPECT_EQ(emit_val("-1.5"), "- -1.5\n");
+    EXPECT_EQ(emit_val("a: b"), "- 'a: b'\n");
+    EXPECT_EQ(emit_val("a long scalar with: a colon in the middle"), "- 'a long scalar with: a colon in the middle'\n");
+    EXPECT_EQ(emit_val("*notaref"), "- '*notaref'\n");
+    EXPECT_EQ(emit_val(" leading"), "- ' leading'\n");
+    EXPECT_EQ(emit_val("trailing "), "- 'trailing '\n");
+    EXPECT_EQ(emit_val("say \"hi\""), "- 'say \"hi\"'\n");
+    EXPECT_EQ(emit_val("it's"), "- \"it's\"\n");
+    EXPECT_EQ(emit_val("it's a \"quote\" in a long scalar"), "- 'it''s a \"quote\" in a long scalar'\n");
+    // with a newline, the scalar is single-quoted with the newline
+    // doubled, whatever the quotes in it: a single newline inside
+    // quotes would be folded into a space when parsing
+    EXPECT_EQ(emit_val("a\"\nb"), "- 'a\"\n\nb'\n");
+    EXPECT_EQ(emit_val("it's\nx"), "- 'it''s\n\nx'\n");
+    for(csubstr val : {csubstr("a\"\nb"), csubstr("it's\nx"), csubstr("say \"hi\""), csubstr("it's"), csubstr("a\nb\"'c")})
+    {
+        SCOPED_TRACE(val);
+        const std::string yaml = emit_val(val);
+        Tree t = parse_in_arena(to_csubstr(yaml));
+        EXPECT_EQ(t[0].val(), val);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+
+TEST(emit_resizable, grows_in_a_single_pass)
+{
+    Tree t;
+    t.rootref() |= SEQ;
+    for(size_t i = 0; i < 1000; ++i)
+        t.rootref().append_child() << i;
+    const std::string expected = emit2str(t, YAML);
+    ASSERT_GT(expected.size(), 256u); // force several growth steps
+    {
+        std::string s;
+        substr out = emitrs(t, &s);
+        EXPECT_EQ(s, expected);
+        EXPECT_EQ(out.str, s.data());
+        EXPECT_EQ(out.len, s.size());
+    }
+    {
+        std::vector<char> v;
+        substr out = emitrs(t, &v);
+        EXPECT_EQ(out, to_csubstr(expected));
+        EXPECT_EQ(v.size(), expected.size());
+    }
+    {
+        std::string s;
+        EmitterResizable<std::string> em(&s);
+        substr out = em.emit(JSON, t);
+        EXPECT_EQ(out, to_csubstr(emit2str(t, JSON)));
+        EXPECT_EQ(s.size(), out.len);
+    }
+}
+
+TEST(emit_resizable, large_enough_container_is_not_resized)
+{
+    Tree t = parse_in_arena("{a: b, c: d}");
+    std::string s(100, '?');
+    substr out = emitrs(t, &s);
+    EXPECT_EQ(out, "a: b\nc: d\n");
+    EXPECT_EQ(out.str, s.data());
+    EXPECT_EQ(s.size(), 100u);
+    EXPECT_EQ(s.back(), '?');
+    // a smaller container is grown only to the emitted size
+    s.assign(2, '?');
+    out = emitrs(t, &s);
+    EXPECT_EQ(out, "a: b\nc: d\n");
+    EXPECT_EQ(s, "a: b\nc: d\n");
+}
+
+
+//-----------------------------------------------------------------------------
+
+Tree make_staging_tree()
+{
+    std::string yaml;
+    for(size_t i = 0; i < 100; ++i)
+    {
+        yaml += std::to_string(i);
+        yaml += ":\n  - a scalar which is larger than the staging buffer\n  - deep: val\n";
+    }
+    return parse_in_arena(to_csubstr(yaml));
+}
+
+TEST(emit_staged, file)
+{
+    const Tree t = make_staging_tree();
+    const std::string expected = emit2str(t, YAML);
+    for(size_t stage_size : {size_t(0), size_t(1), size_t(16), size_t(1) << 16})
+    {
+        std::vector<char> stage(stage_size);
+        FILE *f = tmpfile();
+        ASSERT_NE(f, nullptr);
+        EmitterFile em(f, to_substr(stage));
+        EXPECT_EQ(em.emit(YAML, t).len, expected.size());
+        rewind(f);
+        std::string out(expected.size() + 1, '\0');
+        out.resize(fread(&out[0], 1, out.size(), f));
+        fclose(f);
+        EXPECT_EQ(out, expected) << "stage_size=" << stage_size;
+    }
+}
+
+TEST(emit_staged, ostream)
+{
+    const Tree t = make_staging_tree();
+    {
+        std::ostringstream ss;
+        ss << t;
+        EXPECT_EQ(ss.str(), emit2str(t, YAML));
+    }
+    {
+        char stage[7];
+        std::ostringstream ss;
+        EmitterOStream<std::ostringstream> em(ss, stage);
+        em.emit(JSON, t);
+        EXPECT_EQ(ss.str(), emit2str(t, JSON));
+    }
+}
+
+#ifndef RYML_SINGLE_HEADER
+TEST(emit_staged, stage_is_allocated_when_none_is_given)
+{
+    const Tree t = make_staging_tree();
+    const std::string expected = emit2str(t, YAML);
+    AllocStats stats;
+    set_callbacks(stats.callbacks());
+    {
+        std::ostringstream ss;
+        EmitterOStream<std::ostringstream> em(ss);
+        EXPECT_EQ(stats.site(ALLOC_SITE_WRITER_STAGE).num_allocs, 0u); // only on the first write
+        em.emit(YAML, t);
+        EXPECT_EQ(ss.str(), expected);
+        EXPECT_EQ(stats.site(ALLOC_SITE_WRITER_STAGE).num_allocs, 1u);
+        EXPECT_EQ(stats.site(ALLOC_SITE_WRITER_STAGE).bytes_live, size_t(RYML_WRITER_STAGE_SIZE));
+    }
+    EXPECT_EQ(stats.site(ALLOC_SITE_WRITER_STAGE).num_frees, 1u);
+    EXPECT_EQ(stats.site(ALLOC_SITE_WRITER_STAGE).bytes_live, 0u);
+    {
+        char stage[64];
+        std::ostringstream ss;
+        EmitterOStream<std::ostringstream> em(ss, stage);
+        em.emit(YAML, t);
+        EXPECT_EQ(ss.str(), expected);
+    }
+    EXPECT_EQ(stats.site(ALLOC_SITE_WRITER_STAGE).num_allocs, 1u);
+    set_callbacks(stats.wrapped());
+}
+#endif
+
+#ifdef RYML_HAS_WRITER_FD
+TEST(emit_staged, fd)
+{
+    const Tree t = make_staging_tree();
+    const std::string expected = emit2str(t, YAML);
+    FILE *f = tmpfile();
+    ASSERT_NE(f, nullptr);
+    char stage[100];
+    EmitterFd em(fileno(f), stage);
+    EXPECT_EQ(em.emit(YAML, t).len, expected.size());
+    ASSERT_EQ(lseek(fileno(f), 0, SEEK_SET), 0);
+    std::string out(expected.size() + 1, '\0');
+    out.resize((size_t)read(fileno(f), &out[0], out.size()));
+    fclose(f);
+    EXPECT_EQ(out, expected);
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+
+TEST(emit_iovec, same_output)
+{
+    const Tree t = make_staging_tree();
+    for(EmitType_e type : {YAML, JSON, YAML_FLOW_SL, YAML_FLOW_ML})
+    {
+        const std::string expected = emit2str(t, type);
+        EmitterIovec em;
+        EXPECT_EQ(em.emit(type, t).len, expected.size());
+        std::string out(expected.size(), '\0');
+        EXPECT_EQ(em.gather(to_substr(out)), expected.size());
+        EXPECT_EQ(out, expected);
+        // too small
+        EXPECT_EQ(em.gather(to_substr(out).first(1)), expected.size());
+    }
+}
+
+TEST(emit_iovec, scalars_are_referenced_in_place)
+{
+    std::string src = "a: a scalar which is long enough\nb: [c, d]\n";
+    Tree t = parse_in_place(to_substr(src));
+    EmitterIovec em;
+    em.emit(YAML, t);
+    csubstr whole = to_csubstr(src);
+    size_t num_in_src = 0;
+    for(size_t i = 0; i < em.num_chunks(); ++i)
+        num_in_src += whole.is_super(em.chunks()[i]);
+    EXPECT_GE(num_in_src, 5u); // a, the long scalar, b, c, d
+    std::string out(em.m_pos, '\0');
+    em.gather(to_substr(out));
+    EXPECT_EQ(out, "a: a scalar which is long enough\nb:\n  - c\n  - d\n");
+}
+
+#ifdef RYML_HAS_WRITER_FD
+TEST(emit_iovec, writev)
+{
+    const Tree t = make_staging_tree();
+    const std::string expected = emit2str(t, YAML);
+    EmitterIovec em;
+    em.emit(YAML, t);
+    FILE *f = tmpfile();
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(em.writev(fileno(f)), expected.size());
+    ASSERT_EQ(lseek(fileno(f), 0, SEEK_SET), 0);
+    std::string out(expected.size() + 1, '\0');
+    out.resize((size_t)read(fileno(f), &out[0], out.size()));
+    fclose(f);
+    EXPECT_EQ(out, expected);
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+
+TEST(emit_deep, block)
+{
+    // climbing up many levels at once must restore the indentation
+    const size_t depth = 500;
+    std::string src;
+    for(size_t i = 0; i < depth; ++i)
+        src += std::string(2 * i, ' ') + "k" + std::to_string(i) + ":\n";
+    src += std::string(2 * depth, ' ') + "leaf: 1\n";
+    for(size_t i = depth; i-- > 0; )
+        src += std::string(2 * i, ' ') + "after" + std::to_string(i) + ": 2\n";
+    const Tree t = parse_in_arena(to_csubstr(src));
+    EXPECT_EQ(emitrs<std::string>(t), src);
+}
+
+//-----------------------------------------------------------------------------
+
+TEST(emit_src_spans, unmodified_nodes_are_verbatim)
+{
+    const std::string src = R"(a: 1
+b:
+  # comment on c
+  c: 2   # trailing
+  d: [3,   4]
+e:
+- x
+- y: 1
+  z: 2
+)";
+    Tree t = parse_in_arena_with_spans(to_csubstr(src));
+    ASSERT_TRUE(t.has_src_spans());
+    EXPECT_EQ(emitrs<std::string>(t), src);
+    const size_t b = t.find_child(t.root_id(), "b");
+    const size_t e = t.find_child(t.root_id(), "e");
+    EXPECT_FALSE(t.is_src_dirty(b));
+    // the node and its ancestors are now re-serialized
+    t.set_val(t.find_child(b, "c"), "5");
+    EXPECT_TRUE(t.is_src_dirty(b));
+    EXPECT_TRUE(t.is_src_dirty(t.root_id()));
+    EXPECT_FALSE(t.is_src_dirty(e));
+    EXPECT_FALSE(t.is_src_dirty(t.find_child(b, "d")));
+    EXPECT_EQ(emitrs<std::string>(t), R"(a: 1
+b:
+  c: 5
+  d: [3,   4]
+e:
+- x
+- y: 1
+  z: 2
+)");
+}
+
+TEST(emit_src_spans, verbatim_nodes_are_reindented)
+{
+    const std::string src = R"(a:
+    x: 0
+    b:
+        c: 1  # c
+)";
+    Tree t = parse_in_arena_with_spans(to_csubstr(src));
+    EXPECT_EQ(emitrs<std::string>(t), src);
+    const size_t a = t.find_child(t.root_id(), "a");
+    t.set_val(t.find_child(a, "x"), "9");
+    EXPECT_EQ(emitrs<std::string>(t), R"(a:
+  x: 9
+  b:
+      c: 1  # c
+)");
+}
+
+TEST(emit_src_spans, flow_containers_are_reserialized)
+{
+    const std::string src = "{a: {b: 1}, c: [2, 3]}\n";
+    const Tree t = parse_in_arena_with_spans(to_csubstr(src));
+    EXPECT_EQ(emitrs<std::string>(t), emitrs<std::string>(parse_in_arena(to_csubstr(src))));
+}
+
+
+//-----------------------------------------------------------------------------
+
+template<class Emitter>
+void emit_events_sample(Emitter &em)
+{
+    em.begin_map();
+      em.key("a"); em.val("1");
+      em.key("b"); em.val("1", /*quoted*/true);
+      em.key("c"); em.begin_seq();
+        em.val("x");
+        em.begin_map();
+          em.key("y"); em.val("2");
+          em.key("z"); em.begin_seq(); em.end_seq();
+        em.end_map();
+        em.begin_seq();
+          em.val("u");
+          em.val("v");
+        em.end_seq();
+        em.begin_map(); em.end_map();
+      em.end_seq();
+      em.key("d"); em.begin_map();
+        em.key("e"); em.val("multi\nline\n");
+        em.key("f"); em.val("with: colon");
+      em.end_map();
+    em.end_map();
+}
+
+TEST(emit_events, same_output_as_tree)
+{
+    const std::string yaml = R"(a: 1
+b: '1'
+c:
+  - x
+  - y: 2
+    z: []
+  - - u
+    - v
+  - {}
+d:
+  e: |
+    multi
+    line
+  f: 'with: colon'
+)";
+    const Tree t = parse_in_arena(to_csubstr(yaml));
+    {
+        std::string out;
+        EventEmitterResizable<std::string> em(YAML, &out);
+        emit_events_sample(em);
+        EXPECT_EQ(em.depth(), 0u);
+        EXPECT_EQ(em.finish(), to_csubstr(out));
+        EXPECT_EQ(out, emitrs<std::string>(t));
+    }
+    {
+        std::string out;
+        EventEmitterResizable<std::string> em(JSON, &out);
+        emit_events_sample(em);
+        em.finish();
+        EXPECT_EQ(out, emitrs_json<std::string>(t));
+    }
+}
+
+TEST(emit_events, scalar_root)
+{
+    std::string out;
+    {
+        EventEmitterResizable<std::string> em(YAML, &out);
+        em.val("foo");
+        em.finish();
+    }
+    EXPECT_EQ(out, "foo\n");
+    out.clear();
+    {
+        EventEmitterResizable<std::string> em(JSON, &out);
+        em.val("123");
+        em.finish();
+    }
+    EXPECT_EQ(out, "123");
+}
+
+TEST(emit_events, buffer)
+{
+    char buf[64];
+    EventEmitterBuf em(YAML, substr(buf, sizeof(buf)));
+    em.begin_seq();
+    em.val("a");
+    em.val("b");
+    em.end_seq();
+    EXPECT_EQ(em.finish(), "- a\n- b\n");
+}
+
+/** forward the events, passing the scalars in a buffer which is
+ * reused for every scalar */
+struct ReusedBufferEvents
+{
+    EventEmitterIovec *em;
+    std::string buf;
+    csubstr _cp(csubstr s) { buf.assign(s.str, s.len); return to_csubstr(buf); }
+    void begin_map() { em->begin_map(); }
+    void begin_seq() { em->begin_seq(); }
+    void end_map() { em->end_map(); }
+    void end_seq() { em->end_seq(); }
+    void key(csubstr k, bool quoted=false) { em->key(_cp(k), quoted); }
+    void val(csubstr v, bool quoted=false) { em->val(_cp(v), quoted); }
+};
+
+TEST(emit_events, iovec_copies_the_scalars)
+{
+    for(EmitType_e type : {YAML, JSON})
+    {
+        std::string expected;
+        {
+            EventEmitterResizable<std::string> em(type, &expected);
+            emit_events_sample(em);
+            em.finish();
+        }
+        EventEmitterIovec em(type);
+        ReusedBufferEvents events{&em, {}};
+        emit_events_sample(events);
+        events.buf.assign(events.buf.size(), '?'); // overwrite the last scalar
+        EXPECT_EQ(em.finish().len, expected.size());
+        std::string out(expected.size(), '\0');
+        EXPECT_EQ(em.gather(to_substr(out)), expected.size());
+        EXPECT_EQ(out, expected);
+    }
+    // a scalar larger than the blocks of copies
+    {
+        const std::string large(3 * WriterIovec::copy_block_size, 'x');
+        EventEmitterIovec em(YAML);
+        em.begin_seq();
+        em.val(to_csubstr(std::string(large)));
+        em.val(to_csubstr(std::string("y")));
+        em.end_seq();
+        const std::string expected = "- " + large + "\n- y\n";
+        EXPECT_EQ(em.finish().len, expected.size());
+        std::string out(expected.size(), '\0');
+        EXPECT_EQ(em.gather(to_substr(out)), expected.size());
+        EXPECT_EQ(out, expected);
+    }
+}
+
+} // namespace yml
+} // namespace c4
@@ -0,0 +1,175 @@
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include "c4/yml/emit_parallel.hpp"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+
+namespace c4 {
+namespace yml {
+
+std::string make_parallel_yaml(size_t num_top, size_t num_nested)
+{
+    std::string yaml;
+    for(size_t i = 0; i < num_top; ++i)
+    {
+        yaml += "key" + std::to_string(i) + ":\n";
+        for(size_t j = 0; j < num_nested; ++j)
+        {
+            yaml += "  - name: item" + std::to_string(j) + "\n";
+            yaml += "    vals: [0, 1, {a: b}]\n";
+            yaml += "    nested:\n      - - deep\n        - " + std::to_string(i * j) + "\n";
+        }
+        yaml += "  - []\n";
+        yaml += "  - {}\n";
+    }
+    return yaml;
+}
+
+void test_parallel_same_output(Tree const& t)
+{
+    const std::string expected = emitrs<std::string>(t);
+    for(size_t num_threads : {size_t(1), size_t(2), size_t(3), size_t(4), size_t(7), size_t(16)})
+    {
+        SCOPED_TRACE(num_threads);
+        EXPECT_EQ(emitrs_parallel<std::string>(t, num_threads), expected);
+        std::vector<char> v;
+        EXPECT_EQ(emitrs_parallel(t, &v, num_threads), to_csubstr(expected));
+        EXPECT_EQ(v.size(), expected.size());
+        // the container is not shrunk if it was large enough
+        std::string large(expected.size() + 10, '?');
+        EXPECT_EQ(emitrs_parallel(t, &large, num_threads), to_csubstr(expected));
+        EXPECT_EQ(large.size(), expected.size() + 10);
+    }
+}
+
+TEST(emit_parallel, many_top_level_children)
+{
+    Tree t = parse_in_arena(to_csubstr(make_parallel_yaml(100, 3)));
+    test_parallel_same_output(t);
+}
+
+TEST(emit_parallel, few_top_level_children)
+{
+    Tree t = parse_in_arena(to_csubstr(make_parallel_yaml(2, 50)));
+    test_parallel_same_output(t);
+}
+
+TEST(emit_parallel, seq_of_seqs)
+{
+    Tree t = parse_in_arena("- - [a, b]\n  - - c\n    - d\n  - e\n- - f\n  - g: h\n    i: j\n- k\n");
+    test_parallel_same_output(t);
+}
+
+TEST(emit_parallel, props_at_top)
+{
+    Tree t = parse_in_arena("--- !!map &top\na: &a\n  b: c\n  d: [e]\nf: *a\n--- !!seq\n- 0\n- 1\n--- scalar\n");
+    test_parallel_same_output(t);
+    t = parse_in_arena("!!map\na: b\nc: d\n");
+    test_parallel_same_output(t);
+}
+
+TEST(emit_parallel, leaf_root)
+{
+    Tree t = parse_in_arena("just a scalar");
+    test_parallel_same_output(t);
+    t = parse_in_arena("[]");
+    test_parallel_same_output(t);
+    t = parse_in_arena("{}");
+    test_parallel_same_output(t);
+}
+
+TEST(emit_parallel, deep_single_child_chain)
+{
+    // deep enough to overflow the stack if the plan were made with
+    // recursion, or if it descended to the bottom of the chain
+    const size_t depth = 100000;
+    Tree t;
+    t.to_seq(t.root_id());
+    size_t node = t.root_id();
+    for(size_t i = 0; i < depth; ++i)
+    {
+        node = t.append_child(node);
+        t.to_seq(node);
+    }
+    t.to_val(t.append_child(node), "leaf");
+    test_parallel_same_output(t);
+}
+
+TEST(emit_parallel, file)
+{
+    Tree t = parse_in_arena(to_csubstr(make_parallel_yaml(10, 10)));
+    const std::string expected = emitrs<std::string>(t);
+    FILE *f = tmpfile();
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(emit_parallel(t, f, 4), expected.size());
+    rewind(f);
+    std::string out(expected.size() + 1, '\0');
+    out.resize(fread(&out[0], 1, out.size(), f));
+    fclose(f);
+    EXPECT_EQ(out, expected);
+}
+
+TEST(emit_parallel, partial_emission_is_consistent)
+{
+    Tree t = parse_in_arena(to_csubstr(make_parallel_yaml(3, 2)));
+    const std::string expected = emitrs<std::string>(t);
+    std::string out;
+    size_t root = t.root_id();
+    size_t do_indent = 1;
+    {
+        EmitterResizable<std::string> em(&out);
+        em.emit_open(t, root, 0, &do_indent);
+    }
+    ASSERT_NE(do_indent, NONE);
+    for(size_t ich = t.first_child(root); ich != NONE; ich = t.next_sibling(ich))
+    {
+        std::string part;
+        EmitterResizable<std::string> em(&part);
+        em.emit_children(t, root, ich, t.next_sibling(ich), 0, do_indent);
+        out += part;
+        do_indent = 1;
+    }
+    EXPECT_EQ(out, expected);
+}
+
+/** a container which cannot grow outside of the main thread, to
+ * make the workers throw */
+struct MainThreadString : public std::string
+{
+    static std::thread::id s_main_thread;
+    void resize(size_t sz)
+    {
+        if(std::this_thread::get_id() != s_main_thread)
+            throw std::runtime_error("resize outside of the main thread");
+        std::string::resize(sz);
+    }
+};
+std::thread::id MainThreadString::s_main_thread;
+
+TEST(emit_parallel, exception_in_worker_is_rethrown)
+{
+    Tree t = parse_in_arena(to_csubstr(make_parallel_yaml(20, 2)));
+    MainThreadString::s_main_thread = std::this_thread::get_id();
+    MainThreadString out;
+    EXPECT_THROW(emitrs_parallel(t, &out, 4), std::runtime_error);
+    EXPECT_EQ(emitrs_parallel<std::string>(t, 4), emitrs<std::string>(t));
+}
+
+TEST(emit_parallel, exception_in_caller_joins_the_workers)
+{
+    Tree t = parse_in_arena(to_csubstr(make_parallel_yaml(20, 2)));
+    detail::EmitParallel<std::string> ep(t, t.root_id(), 4);
+    size_t num_calls = 0;
+    // the workers would terminate the program if they were not joined
+    EXPECT_THROW(ep.run(4, [&](detail::EmitPart<std::string> &){
+        if(++num_calls == 2)
+            throw std::runtime_error("in the caller");
+    }), std::runtime_error);
+    EXPECT_EQ(num_calls, 2u);
+}
+
+} // namespace yml
+} // namespace c4
@@ -532,6 +532,60 @@ TEST(parse_in_arena, overloads)
     }
 }
 
+
+//-----------------------------------------------------------------------------
+
+TEST(ParserProfile, phase_names)
+{
+    for(int i = 0; i < PARSER_NUM_PHASES; ++i)
+    {
+        csubstr name = to_csubstr(ParserProfile::phase_name((ParserPhase_e)i));
+        EXPECT_NE(name, "unknown") << i;
+        for(int j = 0; j < i; ++j)
+            EXPECT_NE(name, to_csubstr(ParserProfile::phase_name((ParserPhase_e)j))) << i << " " << j;
+    }
+    EXPECT_EQ(to_csubstr(ParserProfile::phase_name(PARSER_NUM_PHASES)), "unknown");
+}
+
+#ifdef RYML_PROFILE
+TEST(ParserProfile, counts)
+{
+    Parser parser;
+    Tree t;
+    csubstr src = "a: 1\nb: [x, 'y z', \"w\\tq\"]\nc: |\n  block\n";
+    parser.parse_in_arena("file", src, &t);
+    ParserProfile const& prof = parser.profile();
+    EXPECT_EQ(prof[PARSER_PHASE_PARSE].calls, 1u);
+    EXPECT_GT(prof[PARSER_PHASE_HANDLE_LINE].calls, 0u);
+    EXPECT_GT(prof[PARSER_PHASE_HANDLE_MAP_IMPL].calls, 0u);
+    EXPECT_GT(prof[PARSER_PHASE_HANDLE_SEQ_EXPL].calls, 0u);
+    EXPECT_GT(prof[PARSER_PHASE_SCAN_SCALAR].calls, 0u);
+    EXPECT_GT(prof[PARSER_PHASE_SCAN_SQUOT_SCALAR].calls, 0u);
+    EXPECT_GT(prof[PARSER_PHASE_SCAN_DQUOT_SCALAR].calls, 0u);
+    EXPECT_GT(prof[PARSER_PHASE_SCAN_BLOCK].calls, 0u);
+    EXPECT_EQ(prof[PARSER_PHASE_HANDLE_SEQ_IMPL].calls, 0u);
+    #ifdef RYML_PROFILE_CYCLES
+    EXPECT_GT(prof[PARSER_PHASE_PARSE].ticks, 0u);
+    EXPECT_GE(prof[PARSER_PHASE_PARSE].ticks, prof[PARSER_PHASE_HANDLE_MAP_IMPL].ticks);
+    #endif
+    // the counts accumulate across parses
+    parser.parse_in_arena("file", src, &t);
+    EXPECT_EQ(prof[PARSER_PHASE_PARSE].calls, 2u);
+    // the report has one line per phase entered
+    char buf[2048];
+    const size_t len = prof.report(substr(buf, sizeof(buf)));
+    ASSERT_LE(len, sizeof(buf));
+    csubstr report(buf, len);
+    EXPECT_TRUE(report.begins_with("parse "));
+    EXPECT_NE(report.find("scan_block "), npos);
+    EXPECT_EQ(report.find("handle_seq_impl "), npos);
+    EXPECT_EQ(prof.report({}), len);
+    parser.reset_profile();
+    EXPECT_EQ(prof[PARSER_PHASE_PARSE].calls, 0u);
+    EXPECT_EQ(prof.report({}), 0u);
+}
+#endif
+
 } // namespace yml
 } // namespace c4
 
@@ -0,0 +1,116 @@
+#ifndef RYML_SINGLE_HEADER
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/parse.hpp"
+#include "c4/yml/emit.hpp"
+#include "c4/yml/reflect.hpp"
+#include <c4/yml/detail/checks.hpp>
+#endif
+
+#include <gtest/gtest.h>
+
+namespace foo {
+
+struct Color
+{
+    int r, g, b;
+};
+RYML_REFLECT(Color, r, g, b)
+
+struct Item
+{
+    std::string name;
+    double weight;
+    Color color;
+    std::vector<int> tags;
+    bool available;
+};
+RYML_REFLECT(Item, name, weight, color, tags, available)
+
+} // namespace foo
+
+
+namespace c4 {
+namespace yml {
+
+TEST(reflect, hash_matches)
+{
+    static_assert(detail::reflect_hash_lit("") == UINT64_C(14695981039346656037), "wrong hash");
+    EXPECT_EQ(detail::reflect_hash_lit("name"), detail::reflect_hash(csubstr("name")));
+    EXPECT_EQ(detail::reflect_hash_lit("weight"), detail::reflect_hash(csubstr("weight")));
+    EXPECT_NE(detail::reflect_hash(csubstr("r")), detail::reflect_hash(csubstr("g")));
+}
+
+TEST(reflect, write)
+{
+    foo::Item item{"box", 2.5, {1, 2, 3}, {7, 8}, true};
+    Tree t;
+    t.rootref() << item;
+    check_invariants(t);
+    EXPECT_EQ(emitrs<std::string>(t), R"(name: box
+weight: 2.5
+color:
+  r: 1
+  g: 2
+  b: 3
+tags:
+  - 7
+  - 8
+available: 1
+)");
+    // the keys are not copied to the arena
+    EXPECT_EQ(t.arena().find("name"), csubstr::npos);
+}
+
+TEST(reflect, read)
+{
+    C4_SUPPRESS_WARNING_GCC_CLANG_WITH_PUSH("-Wfloat-equal");
+    Tree t = parse_in_arena(R"(
+unknown: ignored
+available: 1
+color: {b: 30, r: 10, g: 20}
+tags: [1, 2, 3]
+name: chair
+)");
+    foo::Item item{"", 10.0, {}, {}, false};
+    t.rootref() >> item;
+    EXPECT_EQ(item.name, "chair");
+    EXPECT_EQ(item.weight, 10.0); // missing fields are left untouched
+    EXPECT_EQ(item.color.r, 10);
+    EXPECT_EQ(item.color.g, 20);
+    EXPECT_EQ(item.color.b, 30);
+    EXPECT_EQ(item.tags, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(item.available, true);
+    C4_SUPPRESS_WARNING_GCC_CLANG_POP
+}
+
+TEST(reflect, round_trip)
+{
+    C4_SUPPRESS_WARNING_GCC_CLANG_WITH_PUSH("-Wfloat-equal");
+    std::vector<foo::Item> items = {
+        {"a", 1.0, {0, 0, 0}, {}, false},
+        {"b", 0.1, {255, 128, 7}, {1}, true},
+    };
+    Tree t;
+    t.rootref() |= SEQ;
+    for(auto const& item : items)
+        t.rootref().append_child() << item;
+    std::string yaml = emitrs<std::string>(t);
+    Tree t2 = parse_in_arena(to_csubstr(yaml));
+    ASSERT_EQ(t2.rootref().num_children(), items.size());
+    for(size_t i = 0; i < items.size(); ++i)
+    {
+        foo::Item out;
+        t2[i] >> out;
+        EXPECT_EQ(out.name, items[i].name);
+        EXPECT_EQ(out.weight, items[i].weight);
+        EXPECT_EQ(out.color.r, items[i].color.r);
+        EXPECT_EQ(out.color.g, items[i].color.g);
+        EXPECT_EQ(out.color.b, items[i].color.b);
+        EXPECT_EQ(out.tags, items[i].tags);
+        EXPECT_EQ(out.available, items[i].available);
+    }
+    C4_SUPPRESS_WARNING_GCC_CLANG_POP
+}
+
+} // namespace yml
+} // namespace c4
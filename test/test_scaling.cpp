@@ -0,0 +1,300 @@
+#ifdef RYML_SINGLE_HEADER
+#include "ryml_all.hpp"
+#else
+#include "c4/yml/std/std.hpp"
+#include "c4/yml/yml.hpp"
+#include "c4/yml/alloc_stats.hpp"
+#endif
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+/* These tests generate adversarial inputs of growing size for the
+ * operations whose cost could become quadratic in the shape of the
+ * input (eg the width of a map or the number of anchors), and check
+ * that the cost grows linearly. This guards against latency blowups
+ * with untrusted input.
+ *
+ * Where the cost can be counted (eg the allocations), the counts are
+ * compared. Otherwise, each operation is timed at sizes n and 4*n
+ * (two doublings), taking the fastest of several repetitions, and the
+ * time ratio must be below 2.2*2.2: a quadratic operation has a ratio
+ * of 16. The sizes are small enough for the data to stay in the
+ * caches. As the timings depend on the machine, this test is built
+ * only with the cmake option RYML_TEST_SCALING, and the timed checks
+ * are skipped under instrumentation (sanitizers or valgrind). */
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define RYML_SCALING_INSTRUMENTED
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define RYML_SCALING_INSTRUMENTED
+#endif
+#endif
+
+namespace c4 {
+namespace yml {
+
+namespace {
+
+constexpr const double max_ratio_per_doubling = 2.2;
+/** the counts of an operation which reallocates geometrically (eg by
+ * doubling) can be rounded up to the next reallocation, so they are
+ * given more slack: linear growth stays below 4*2, quadratic growth
+ * is at 16 */
+constexpr const double max_count_ratio = 10.;
+constexpr const size_t num_reps = 7;
+constexpr const size_t num_attempts = 3;
+
+using clock_type = std::chrono::steady_clock;
+
+/** whether the timings are distorted: a debug build, sanitizers, or
+ * valgrind (which preloads its own libraries) */
+const char* instrumentation()
+{
+    #if defined(RYML_DBG)
+    return "the debug output";
+    #elif defined(RYML_SCALING_INSTRUMENTED)
+    return "the sanitizers";
+    #elif defined(_WIN32)
+    return nullptr;
+    #else
+    const char *preload = getenv("LD_PRELOAD");
+    if(preload && strstr(preload, "vgpreload"))
+        return "valgrind";
+    return nullptr;
+    #endif
+}
+
+/** the fastest of several runs of @p run at size @p n, in seconds.
+ * @p prepare is called (untimed) before each run. */
+double min_time(size_t n, std::function<void(size_t)> const& prepare, std::function<void(size_t)> const& run)
+{
+    double best = 1.e30;
+    for(size_t rep = 0; rep < num_reps; ++rep)
+    {
+        prepare(n);
+        const auto t0 = clock_type::now();
+        run(n);
+        const auto t1 = clock_type::now();
+        const double t = std::chrono::duration<double>(t1 - t0).count();
+        best = t < best ? t : best;
+    }
+    return best;
+}
+
+void check_scaling(const char *what, size_t n, std::function<void(size_t)> const& prepare, std::function<void(size_t)> const& run)
+{
+    if(const char *why = instrumentation())
+    {
+        GTEST_SKIP() << why << " would distort the timings";
+    }
+    const double max_ratio = max_ratio_per_doubling * max_ratio_per_doubling;
+    double small = 0., large = 0., ratio = 0.;
+    // retry before failing, as the machine may be busy
+    for(size_t attempt = 0; attempt < num_attempts; ++attempt)
+    {
+        small = min_time(n, prepare, run);
+        large = min_time(4 * n, prepare, run);
+        ratio = large / (small > 0. ? small : 1.e-9);
+        if(ratio <= max_ratio)
+            break;
+    }
+    EXPECT_LE(ratio, max_ratio) << what << ": the time is growing faster than linearly: "
+                                << "n=" << n << ": " << small << "s, "
+                                << "n=" << 4 * n << ": " << large << "s";
+}
+
+/** check that a count of the cost of an operation (eg the bytes
+ * allocated) grows linearly. This does not depend on the timings. */
+void check_count_scaling(const char *what, size_t n, std::function<size_t(size_t)> const& count)
+{
+    const size_t small = count(n);
+    const size_t large = count(4 * n);
+    ASSERT_GT(small, 0u) << what;
+    const double ratio = (double)large / (double)small;
+    EXPECT_LE(ratio, max_count_ratio) << what << ": the count is growing faster than linearly: "
+                                      << "n=" << n << ": " << small << ", "
+                                      << "n=" << 4 * n << ": " << large;
+}
+
+std::string wide_map(size_t n, const char *prefix="k")
+{
+    std::string s;
+    for(size_t i = 0; i < n; ++i)
+        s += prefix + std::to_string(i) + ": " + std::to_string(i) + "\n";
+    return s;
+}
+
+std::string long_seq(size_t n)
+{
+    std::string s;
+    for(size_t i = 0; i < n; ++i)
+        s += "- " + std::to_string(i) + "\n";
+    return s;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+
+TEST(scaling, parse_wide_map)
+{
+    std::string src;
+    check_scaling("parse_wide_map", 4000,
+                  [&](size_t n){ src = wide_map(n); },
+                  [&](size_t){
+                      Tree t = parse_in_arena(to_csubstr(src));
+                      EXPECT_TRUE(t.rootref().is_map());
+                  });
+}
+
+// find_child() walks the children, so looking up every key of a map
+// with it is quadratic; find_children() indexes the keys
+TEST(scaling, find_children_in_wide_map)
+{
+    Tree t;
+    std::vector<std::string> keys;
+    std::vector<csubstr> names;
+    std::vector<size_t> children;
+    check_scaling("find_children_in_wide_map", 4000,
+                  [&](size_t n){
+                      t = parse_in_arena(to_csubstr(wide_map(n)));
+                      keys.resize(n);
+                      names.resize(n);
+                      children.resize(n);
+                      // in reverse order, the worst case for walking the children
+                      for(size_t i = 0; i < n; ++i)
+                      {
+                          keys[i] = "k" + std::to_string(n - 1 - i);
+                          names[i] = to_csubstr(keys[i]);
+                      }
+                  },
+                  [&](size_t n){
+                      t.find_children(t.root_id(), names.data(), n, children.data());
+                      EXPECT_EQ(children[0], t.last_child(t.root_id()));
+                  });
+}
+
+TEST(scaling, child_in_long_seq)
+{
+    Tree t;
+    check_scaling("child_in_long_seq", 4000,
+                  [&](size_t n){ t = parse_in_arena(to_csubstr(long_seq(n))); },
+                  [&](size_t n){
+                      for(size_t rep = 0; rep < 64; ++rep)
+                          EXPECT_NE(t.child(t.root_id(), n / 2), NONE);
+                  });
+}
+
+TEST(scaling, resolve_many_anchors)
+{
+    // every ref is to the first anchor, so that looking backwards
+    // for the anchor would walk through all the anchors
+    Tree t;
+    check_scaling("resolve_many_anchors", 2000,
+                  [&](size_t n){
+                      std::string src;
+                      for(size_t i = 0; i < n; ++i)
+                          src += "- &a" + std::to_string(i) + " v" + std::to_string(i) + "\n";
+                      for(size_t i = 0; i < n; ++i)
+                          src += "- *a0\n";
+                      t = parse_in_arena(to_csubstr(src));
+                  },
+                  [&](size_t n){
+                      t.resolve();
+                      EXPECT_EQ(t[2 * n - 1].val(), "v0");
+                  });
+}
+
+TEST(scaling, resolve_merge_wide_map)
+{
+    // the merged map has a repetition for every merged key
+    Tree t;
+    check_scaling("resolve_merge_wide_map", 2000,
+                  [&](size_t n){
+                      std::string src = "base: &base\n";
+                      for(size_t i = 0; i < n; ++i)
+                          src += "  k" + std::to_string(i) + ": base\n";
+                      src += "derived:\n  <<: *base\n";
+                      for(size_t i = 0; i < n; ++i)
+                          src += "  k" + std::to_string(i) + ": derived\n";
+                      t = parse_in_arena(to_csubstr(src));
+                  },
+                  [&](size_t n){
+                      t.resolve();
+                      ASSERT_EQ(t["derived"].num_children(), n);
+                      EXPECT_EQ(t["derived"].last_child().val(), "derived");
+                  });
+}
+
+TEST(scaling, merge_with_wide_map)
+{
+    Tree dst, src;
+    check_scaling("merge_with_wide_map", 2000,
+                  [&](size_t n){
+                      dst = parse_in_arena(to_csubstr(wide_map(n)));
+                      src = parse_in_arena(to_csubstr(wide_map(n) + wide_map(n, "new")));
+                  },
+                  [&](size_t n){
+                      dst.merge_with(&src);
+                      EXPECT_EQ(dst.rootref().num_children(), 2 * n);
+                  });
+}
+
+#ifndef RYML_SINGLE_HEADER
+TEST(scaling, arena_growth)
+{
+    // each value goes to the arena, which grows and relocates while
+    // the number of nodes grows: the bytes allocated (and so copied
+    // when relocating) must grow linearly
+    for(AllocSite_e site : {ALLOC_SITE_TREE_ARENA, ALLOC_SITE_TREE_NODES})
+    {
+        check_count_scaling(AllocStats::site_name(site), 4000, [site](size_t n){
+            AllocStats stats;
+            Tree t(stats.callbacks());
+            NodeRef root = t.rootref();
+            root |= SEQ;
+            for(size_t i = 0; i < n; ++i)
+                root.append_child() << i;
+            EXPECT_EQ(t.num_children(t.root_id()), n);
+            return stats.site(site).bytes_total;
+        });
+    }
+}
+#endif
+
+TEST(scaling, emit_wide_map)
+{
+    Tree t;
+    std::string out;
+    check_scaling("emit_wide_map", 4000,
+                  [&](size_t n){ t = parse_in_arena(to_csubstr(wide_map(n))); out.clear(); },
+                  [&](size_t){
+                      emitrs(t, &out);
+                      EXPECT_FALSE(out.empty());
+                  });
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+// this is needed to use the test case library
+
+struct Case;
+Case const* get_case(csubstr /*name*/)
+{
+    return nullptr;
+}
+
+} // namespace yml
+} // namespace c4
@@ -117,6 +117,80 @@ TEST(serialize, std_vector_int)
     using L = std::initializer_list<T>;
     do_test_serialize<std::vector<T>>(L{1, 2, 3, 4, 5});
 }
+TEST(serialize, std_vector_double)
+{
+    using T = double;
+    using L = std::initializer_list<T>;
+    do_test_serialize<std::vector<T>>(L{0.1, 0.2 + 0.1, -1e300, 5e-324, 12345.6789, 0.});
+}
+TEST(serialize, std_vector_bulk)
+{
+    std::vector<int> vi;
+    for(int i = -500; i < 500; ++i)
+        vi.push_back(i * 997);
+    std::vector<float> vf;
+    for(int i = 0; i < 1000; ++i)
+        vf.push_back(1.f / float(i + 1));
+    Tree t;
+    t.rootref() |= MAP;
+    t["ints"] << vi;
+    t["floats"] << vf;
+    c4::yml::check_invariants(t);
+    ASSERT_EQ(t["ints"].num_children(), vi.size());
+    ASSERT_EQ(t["floats"].num_children(), vf.size());
+    EXPECT_EQ(t["ints"][0].val(), "-498500");
+    EXPECT_EQ(t["floats"][1].val(), "0.5");
+    std::vector<int> vi_out;
+    std::vector<float> vf_out;
+    t["ints"] >> vi_out;
+    t["floats"] >> vf_out;
+    EXPECT_EQ(vi_out, vi);
+    EXPECT_EQ(vf_out, vf);
+    // read in bulk into a plain array
+    int arr[3] = {};
+    EXPECT_TRUE(t["ints"].deserialize_children(arr, 3));
+    EXPECT_EQ(arr[0], vi[0]);
+    EXPECT_EQ(arr[1], vi[1]);
+    EXPECT_EQ(arr[2], vi[2]);
+    // more elements than children
+    std::vector<int> too_many(vi.size() + 1);
+    EXPECT_FALSE(t["ints"].deserialize_children(too_many.data(), too_many.size()));
+}
+
+TEST(serialize, append_children_serialized_parent_type)
+{
+    const int vals[] = {1, 2, 3};
+    // an empty parent without type becomes a seq
+    {
+        Tree t;
+        t.rootref().append_children_serialized(vals, 3);
+        c4::yml::check_invariants(t);
+        ASSERT_TRUE(t.rootref().is_seq());
+        ASSERT_EQ(t.rootref().num_children(), 3u);
+        EXPECT_EQ(t[2].val(), "3");
+    }
+    // the children of a map would have no keys
+    {
+        Tree t;
+        t.rootref() |= MAP;
+        ExpectError::do_check(&t, [&]{
+            t.rootref().append_children_serialized(vals, 3);
+        });
+        EXPECT_EQ(t.rootref().num_children(), 0u);
+    }
+    // a val cannot have children
+    {
+        Tree t;
+        t.rootref() |= MAP;
+        t["a"] = "b";
+        ExpectError::do_check(&t, [&]{
+            t["a"].append_children_serialized(vals, 3);
+        });
+        EXPECT_EQ(t["a"].val(), "b");
+        EXPECT_EQ(t["a"].num_children(), 0u);
+    }
+}
+
 TEST(serialize, std_vector_string)
 {
     using T = std::string;
@@ -137,6 +211,37 @@ TEST(serialize, std_map__int_int)
     using L = std::initializer_list<typename M::value_type>;
     do_test_serialize<M>(L{{10, 0}, {11, 1}, {22, 2}, {10001, 1000}, {20002, 2000}, {30003, 3000}});
 }
+/** a key type with no from_chars(): it can be read into a map only
+ * by constructing it from the characters of the key */
+struct CharsKey
+{
+    std::string s;
+    CharsKey(const char *str, size_t len) : s(str, len) {}
+    bool operator< (CharsKey const& that) const { return s < that.s; }
+    bool operator== (CharsKey const& that) const { return s == that.s; }
+};
+struct CharsKeyHash
+{
+    size_t operator() (CharsKey const& k) const { return std::hash<std::string>{}(k.s); }
+};
+TEST(serialize, map_keys_constructed_from_chars)
+{
+    Tree t = parse_in_arena("{a: 1, bb: 2, ccc: 3}");
+    std::map<CharsKey, int> m;
+    std::unordered_map<CharsKey, int, CharsKeyHash> um;
+    t.rootref() >> m;
+    t.rootref() >> um;
+    ASSERT_EQ(m.size(), 3u);
+    ASSERT_EQ(um.size(), 3u);
+    EXPECT_EQ(m.at(CharsKey("bb", 2)), 2);
+    EXPECT_EQ(um.at(CharsKey("ccc", 3)), 3);
+    // keys viewing the tree
+    std::map<csubstr, int> views;
+    t.rootref() >> views;
+    ASSERT_EQ(views.size(), 3u);
+    EXPECT_TRUE(t.arena().is_super(views.begin()->first));
+}
+
 TEST(serialize, std_map__std_string_int)
 {
     using M = std::map<std::string, int>;
@@ -163,6 +268,87 @@ TEST(serialize, std_vector__map_string_int)
 }
 
 
+TEST(serialize, std_unordered_map__std_string_int)
+{
+    using M = std::unordered_map<std::string, int>;
+    using L = std::initializer_list<typename M::value_type>;
+    do_test_serialize<M>(L{{"asdsdf", 0}, {"dfgdfgdfg", 1}, {"dfgjdfgkjh", 2}});
+}
+TEST(serialize, std_array)
+{
+    do_test_serialize<std::array<int, 4>>(std::array<int, 4>{{1, 2, 3, 4}});
+    do_test_serialize<std::array<double, 3>>(std::array<double, 3>{{0.1, 1e-300, 3.5}});
+    do_test_serialize<std::array<std::string, 2>>(std::array<std::string, 2>{{"a", "bcd"}});
+    // wrong number of children
+    Tree t = parse_in_arena("[1, 2, 3]");
+    std::array<int, 4> arr4;
+    std::array<std::string, 2> arr2;
+    EXPECT_FALSE(read(t.rootref(), &arr4));
+    EXPECT_FALSE(read(t.rootref(), &arr2));
+}
+#if C4_CPP >= 17
+TEST(serialize, std_optional)
+{
+    Tree t = parse_in_arena("{a: 1, b: ~, c: null, d: , e: '~', f: [1, 2], g: notanint}");
+    std::optional<int> i;
+    std::optional<std::string> s;
+    std::optional<std::vector<int>> v;
+    t["a"] >> i;
+    ASSERT_TRUE(i.has_value());
+    EXPECT_EQ(*i, 1);
+    t["b"] >> i;
+    EXPECT_FALSE(i.has_value());
+    t["c"] >> s;
+    EXPECT_FALSE(s.has_value());
+    t["d"] >> s;
+    EXPECT_FALSE(s.has_value());
+    t["e"] >> s;
+    ASSERT_TRUE(s.has_value());
+    EXPECT_EQ(*s, "~");
+    t["f"] >> v;
+    ASSERT_TRUE(v.has_value());
+    EXPECT_EQ(*v, (std::vector<int>{1, 2}));
+    // a failed read leaves the optional empty
+    i = 1;
+    EXPECT_FALSE(read(t["g"], &i));
+    EXPECT_FALSE(i.has_value());
+    Tree out;
+    out.rootref() |= MAP;
+    out["x"] << std::optional<int>{};
+    out["y"] << std::optional<int>{42};
+    EXPECT_EQ(emitrs<std::string>(out), "x: ~\ny: 42\n");
+}
+#endif
+TEST(serialize, num_children_is_kept)
+{
+    Tree t = parse_in_arena("[0, 1, 2, 3, 4, 5, 6, 7]");
+    NodeRef r = t.rootref();
+    EXPECT_EQ(r.num_children(), 8u);
+    for(size_t i = 0; i < 8; ++i)
+        EXPECT_EQ(r[i].val(), t.val(t.child(r.id(), i)));
+    EXPECT_EQ(t.child(r.id(), 8), NONE);
+    r.remove_child(3);
+    EXPECT_EQ(r.num_children(), 7u);
+    EXPECT_EQ(r[3].val(), "4");
+    EXPECT_EQ(r[6].val(), "7");
+    r.append_child() << 8;
+    r.prepend_child() << -1;
+    EXPECT_EQ(r.num_children(), 9u);
+    EXPECT_EQ(r[0].val(), "-1");
+    r[1].move(r[8]);
+    EXPECT_EQ(r.num_children(), 9u);
+    EXPECT_EQ(r[8].val(), "0");
+    r.append_child() |= SEQ;
+    r[9].append_child() << 10;
+    r[1].move(r[9], r[9].first_child());
+    EXPECT_EQ(r.num_children(), 9u);
+    EXPECT_EQ(r[8].num_children(), 2u);
+    c4::yml::check_invariants(t);
+    r.clear_children();
+    EXPECT_EQ(r.num_children(), 0u);
+    c4::yml::check_invariants(t);
+}
+
 TEST(serialize, bool)
 {
     Tree t = parse_in_arena("{a: 0, b: false, c: 1, d: true}");
@@ -407,6 +593,67 @@ set:
     C4_SUPPRESS_WARNING_GCC_CLANG_POP
 }
 
+TEST(serialize, float_shortest)
+{
+    C4_SUPPRESS_WARNING_GCC_CLANG_WITH_PUSH("-Wfloat-equal");
+    Tree t;
+    EXPECT_EQ(t.to_arena(0.124f), "0.124");
+    EXPECT_EQ(t.to_arena(0.234), "0.234");
+    EXPECT_EQ(t.to_arena(0.1 + 0.2), "0.30000000000000004");
+    EXPECT_EQ(t.to_arena(100.), "100");
+    EXPECT_EQ(t.to_arena(-0.), "-0");
+    EXPECT_EQ(t.to_arena(1e22), "1e+22");
+    EXPECT_EQ(t.to_arena(1e-5), "1e-05");
+    EXPECT_EQ(t.to_arena(0.0001), "0.0001");
+    EXPECT_EQ(t.to_arena(5e-324), "5e-324");
+    EXPECT_EQ(t.to_arena(1.7976931348623157e308), "1.7976931348623157e+308");
+    EXPECT_EQ(t.to_arena(std::numeric_limits<float>::max()), "3.4028235e+38");
+    // every value must read back to itself
+    const double dvals[] = {0.1, 1./3., 2./3., 1e-300, 123456789.125, 9007199254740993., 2.2250738585072014e-308};
+    for(double d : dvals)
+    {
+        double r = 0.;
+        ASSERT_TRUE(from_chars_float(t.to_arena(d), &r));
+        EXPECT_EQ(r, d);
+        float f = static_cast<float>(d), rf = 0.f;
+        ASSERT_TRUE(from_chars_float(t.to_arena(f), &rf));
+        EXPECT_EQ(rf, f);
+    }
+    C4_SUPPRESS_WARNING_GCC_CLANG_POP
+}
+
+TEST(serialize, float_fast_path)
+{
+    C4_SUPPRESS_WARNING_GCC_CLANG_WITH_PUSH("-Wfloat-equal");
+    double d = 0.;
+    EXPECT_TRUE(detail::scan_float_fast(csubstr("-12.25"), &d));
+    EXPECT_EQ(d, -12.25);
+    EXPECT_TRUE(detail::scan_float_fast(csubstr("12e-3"), &d));
+    EXPECT_EQ(d, 0.012);
+    EXPECT_TRUE(detail::scan_float_fast(csubstr("1e22"), &d));
+    EXPECT_EQ(d, 1e22);
+    // these are left to the full conversion
+    EXPECT_FALSE(detail::scan_float_fast(csubstr("1e23"), &d));
+    EXPECT_FALSE(detail::scan_float_fast(csubstr("12345678901234567890"), &d));
+    EXPECT_FALSE(detail::scan_float_fast(csubstr(".5"), &d));
+    EXPECT_FALSE(detail::scan_float_fast(csubstr("1."), &d));
+    EXPECT_FALSE(detail::scan_float_fast(csubstr("0x1p3"), &d));
+    EXPECT_FALSE(detail::scan_float_fast(csubstr(".inf"), &d));
+    EXPECT_FALSE(detail::scan_float_fast(csubstr(""), &d));
+    // ... but must still be read
+    EXPECT_TRUE(from_chars_float(csubstr("1e23"), &d));
+    EXPECT_EQ(d, 1e23);
+    EXPECT_TRUE(from_chars_float(csubstr("12345678901234567890"), &d));
+    EXPECT_EQ(d, 12345678901234567890.);
+    float f = 0.f;
+    EXPECT_TRUE(detail::scan_float_fast(csubstr("3.25"), &f));
+    EXPECT_EQ(f, 3.25f);
+    EXPECT_FALSE(detail::scan_float_fast(csubstr("123456789"), &f));
+    EXPECT_TRUE(from_chars_float(csubstr("123456789"), &f));
+    EXPECT_EQ(f, 123456789.f);
+    C4_SUPPRESS_WARNING_GCC_CLANG_POP
+}
+
 TEST(serialize, std_string)
 {
     auto t = parse_in_arena("{foo: bar}");
@@ -2600,6 +2600,35 @@ seq: &seq [*valref, bar]
     EXPECT_EQ(val.child(0).id(), t.child(val_id, 0));
 }
 
+TEST(Tree, append_children)
+{
+    Tree t = parse_in_arena("[a, b]");
+    const size_t seq = t.root_id();
+    const size_t prev_size = t.size();
+    EXPECT_EQ(t.append_children(seq, 0), (size_t)NONE);
+    const size_t first = t.append_children(seq, 100);
+    ASSERT_NE(first, (size_t)NONE);
+    EXPECT_EQ(t.size(), prev_size + 100u);
+    EXPECT_EQ(t.num_children(seq), 102u);
+    EXPECT_EQ(t.child(seq, 2), first);
+    EXPECT_EQ(t.last_child(seq), t.child(seq, 101));
+    EXPECT_EQ(t.prev_sibling(first), t.child(seq, 1));
+    for(size_t ch = first; ch != NONE; ch = t.next_sibling(ch))
+    {
+        EXPECT_EQ(t.parent(ch), seq);
+        EXPECT_EQ(t.num_children(ch), 0u);
+        t.to_val(ch, "c");
+    }
+    check_invariants(t);
+    // appending to an empty container
+    const size_t map = t.append_child(seq);
+    t.to_map(map);
+    const size_t mfirst = t.append_children(map, 3);
+    EXPECT_EQ(t.first_child(map), mfirst);
+    EXPECT_EQ(t.num_children(map), 3u);
+    EXPECT_EQ(t.last_child(map), t.child(map, 2));
+}
+
 TEST(Tree, find_child_by_name)
 {
     Tree t = parse_in_arena(R"(---
@@ -2625,6 +2654,41 @@ seq: &seq [*valref, bar]
     EXPECT_EQ(map.find_child("bar").id(), t.find_child(map_id, "bar"));
 }
 
+TEST(Tree, find_children)
+{
+    Tree t = parse_in_arena("{k0: 0, k1: 1, k2: 2, k3: 3, k4: 4, k5: 5, k6: 6, k7: 7}");
+    const size_t root = t.root_id();
+    // a repeated key: the first child with the key is found
+    t.to_keyval(t.append_child(root), "k3", "repeated");
+    const csubstr names[] = {"k7", "k3", "missing", "k0", "k5", "k3", "", "k1"};
+    const size_t num = sizeof(names) / sizeof(names[0]);
+    for(size_t num_names : {size_t(0), size_t(1), size_t(4), num})
+    {
+        SCOPED_TRACE(num_names);
+        size_t children[num];
+        for(size_t &ch : children)
+            ch = 12345u;
+        t.find_children(root, names, num_names, children);
+        for(size_t i = 0; i < num_names; ++i)
+        {
+            EXPECT_EQ(children[i], t.find_child(root, names[i])) << names[i];
+        }
+        for(size_t i = num_names; i < num; ++i)
+        {
+            EXPECT_EQ(children[i], 12345u);
+        }
+    }
+    EXPECT_EQ(t.val(t.find_child(root, "k3")), "3");
+    // an empty map
+    Tree empty = parse_in_arena("{}");
+    size_t children[num];
+    empty.find_children(empty.root_id(), names, num, children);
+    for(size_t ch : children)
+    {
+        EXPECT_EQ(ch, (size_t)NONE);
+    }
+}
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -3593,6 +3657,63 @@ doc4
     }
 }
 
+TEST(Tree, deep_nesting)
+{
+    // deep enough to overflow the stack if the tree is visited with
+    // recursion
+    const size_t depth = 100000;
+    Tree t;
+    t.to_seq(t.root_id());
+    size_t node = t.root_id();
+    for(size_t i = 0; i < depth; ++i)
+    {
+        node = t.append_child(node);
+        t.to_seq(node);
+    }
+    const std::string expected = std::string(depth + 1, '[') + std::string(depth + 1, ']');
+    EXPECT_EQ(emitrs_json<std::string>(t), expected);
+    Tree cp;
+    cp.to_seq(cp.root_id());
+    cp.duplicate_children(&t, t.root_id(), cp.root_id(), NONE);
+    EXPECT_EQ(cp.size(), t.size());
+    EXPECT_EQ(emitrs_json<std::string>(cp), expected);
+    cp.resolve();
+    EXPECT_EQ(cp.size(), t.size());
+    // in flow style
+    cp.rootref() |= FLOW_SL;
+    EXPECT_EQ(emitrs<std::string>(cp), expected + "\n");
+    EXPECT_EQ(EmitterBuf(substr{}).emit(YAML_FLOW_SL, cp, /*error_on_excess*/false).len, expected.size() + 1);
+    t.remove_children(t.root_id());
+    EXPECT_EQ(t.size(), 1u);
+    EXPECT_EQ(emitrs_json<std::string>(t), "[]");
+}
+
+TEST(Tree, deep_nesting_flow_ml)
+{
+    // the indentation makes the output quadratic in the depth, so
+    // this is not as deep as above
+    const size_t depth = 1000;
+    Tree t;
+    t.to_seq(t.root_id());
+    size_t node = t.root_id();
+    std::string expected;
+    for(size_t i = 0; i < depth; ++i)
+    {
+        node = t.append_child(node);
+        t.to_seq(node);
+        expected += "[\n" + std::string(2 * (i + 1), ' ');
+    }
+    expected += "[]";
+    for(size_t i = depth; i > 0; --i)
+        expected += "\n" + std::string(2 * (i - 1), ' ') + "]";
+    expected += "\n";
+    t.rootref() |= FLOW_ML;
+    EXPECT_EQ(emitrs<std::string>(t), expected);
+    // a single line container within the multi line container
+    t.rootref().first_child() |= FLOW_SL;
+    EXPECT_EQ(emitrs<std::string>(t), "[\n  " + std::string(depth, '[') + std::string(depth, ']') + "\n]\n");
+}
+
 
 //-------------------------------------------
 // this is needed to use the test case library
@@ -75,18 +75,25 @@ INSTRUCTIONS:
         am.onlyif(with_c4core, c4core_amalgamated),
         "src/c4/yml/export.hpp",
         "src/c4/yml/common.hpp",
+        "src/c4/yml/detail/fpconv.hpp",
         "src/c4/yml/tree.hpp",
         "src/c4/yml/node.hpp",
+        "src/c4/yml/detail/stack.hpp",
         "src/c4/yml/writer.hpp",
+        "src/c4/yml/detail/scalar_scan.hpp",
         "src/c4/yml/detail/parser_dbg.hpp",
         am.injcode("#define C4_YML_EMIT_DEF_HPP_"),
         "src/c4/yml/emit.hpp",
         "src/c4/yml/emit.def.hpp",
-        "src/c4/yml/detail/stack.hpp",
+        "src/c4/yml/emit_events.hpp",
         "src/c4/yml/parse.hpp",
+        "src/c4/yml/reflect.hpp",
         am.onlyif(with_stl, "src/c4/yml/std/map.hpp"),
         am.onlyif(with_stl, "src/c4/yml/std/string.hpp"),
         am.onlyif(with_stl, "src/c4/yml/std/vector.hpp"),
+        am.onlyif(with_stl, "src/c4/yml/std/unordered_map.hpp"),
+        am.onlyif(with_stl, "src/c4/yml/std/array.hpp"),
+        am.onlyif(with_stl, "src/c4/yml/std/optional.hpp"),
         am.onlyif(with_stl, "src/c4/yml/std/std.hpp"),
         "src/c4/yml/common.cpp",
         "src/c4/yml/tree.cpp",
@@ -0,0 +1,208 @@
+"""Compare two runs of the benchmarks, and flag the regressions.
+
+The runs are the json results of the benchmarks (obtained with
+--benchmark_out=<file>.json --benchmark_out_format=json, which the
+benchmark targets do into bm/bm-results in the build directory). Each
+run can be a results file or a directory of results files; the files of
+the two directories are matched by name. Within a file, the benchmarks
+are matched by name.
+
+For each benchmark, the mean of the repetitions of the two runs are
+compared with Welch's t-test. A benchmark is a regression when it is
+worse by more than the threshold, and the difference is significant
+(p-value below alpha). Without repetitions (see RYML_BM_REPETITIONS)
+there is no significance test, and only the threshold is used.
+
+The exit status is 1 if there is any regression, so this can be used as
+a go/no-go check; eg, to check an upgrade of ryml:
+
+    python tools/bm_compare.py --threshold 5 \\
+        build-old/bm/bm-results build-new/bm/bm-results
+"""
+
+import os
+import re
+import sys
+import math
+import json
+import argparse
+
+
+# the metrics where more is better; for the others, less is better
+_higher_is_better = {
+    "bytes_per_second", "items_per_second", "ipc", "efficiency", "thread_MBps",
+}
+
+
+# -----------------------------------------------------------------------------
+# statistics
+
+def _betacf(a, b, x):
+    """continued fraction for the incomplete beta function (Numerical
+    Recipes, 6.4)"""
+    tiny = 1.e-300
+    qab, qap, qam = a + b, a + 1., a - 1.
+    c, d = 1., 1. - qab * x / qap
+    d = 1. / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1. + aa * d
+        d = 1. / (d if abs(d) > tiny else tiny)
+        c = 1. + aa / c
+        c = c if abs(c) > tiny else tiny
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1. + aa * d
+        d = 1. / (d if abs(d) > tiny else tiny)
+        c = 1. + aa / c
+        c = c if abs(c) > tiny else tiny
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.) < 1.e-12:
+            break
+    return h
+
+
+def _betai(a, b, x):
+    """the regularized incomplete beta function I_x(a, b)"""
+    if x <= 0.:
+        return 0.
+    if x >= 1.:
+        return 1.
+    lbeta = math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+    front = math.exp(lbeta + a * math.log(x) + b * math.log(1. - x))
+    if x < (a + 1.) / (a + b + 2.):
+        return front * _betacf(a, b, x) / a
+    return 1. - front * _betacf(b, a, 1. - x) / b
+
+
+def welch(n1, mean1, var1, n2, mean2, var2):
+    """two-sided p-value of Welch's t-test, or None if it cannot be
+    computed (ie without repetitions)"""
+    if n1 < 2 or n2 < 2:
+        return None
+    se1, se2 = var1 / n1, var2 / n2
+    if se1 + se2 <= 0.:
+        return 0. if mean1 != mean2 else 1.
+    t = (mean1 - mean2) / math.sqrt(se1 + se2)
+    dof = (se1 + se2) ** 2 / (se1 ** 2 / (n1 - 1) + se2 ** 2 / (n2 - 1))
+    return _betai(dof / 2., 0.5, dof / (dof + t * t))
+
+
+class Samples:
+    """the values of a metric in the repetitions of a benchmark"""
+
+    def __init__(self):
+        self.values = []
+        self.aggregates = {}  # name -> value, when only the aggregates were reported
+
+    def stats(self):
+        """return (n, mean, variance)"""
+        v = self.values
+        if v:
+            n = len(v)
+            mean = sum(v) / n
+            var = sum((x - mean) ** 2 for x in v) / (n - 1) if n > 1 else 0.
+            return n, mean, var
+        n = self.aggregates.get("repetitions", 1)
+        mean = self.aggregates.get("mean", self.aggregates.get("median"))
+        std = self.aggregates.get("stddev", 0.)
+        return n, mean, std * std
+
+
+# -----------------------------------------------------------------------------
+# loading
+
+def load_file(filename, metric):
+    """return a dict of benchmark name -> Samples"""
+    with open(filename) as f:
+        results = json.load(f)
+    out = {}
+    for r in results.get("benchmarks", []):
+        if r.get("error_occurred") or metric not in r:
+            continue
+        # match the runs regardless of their number of repetitions
+        name = re.sub(r"/repeats:[0-9]+", "", r.get("run_name", r["name"]))
+        s = out.setdefault(name, Samples())
+        if r.get("run_type", "iteration") == "iteration":
+            s.values.append(float(r[metric]))
+        elif r.get("aggregate_unit", "time") != "percentage":
+            s.aggregates[r["aggregate_name"]] = float(r[metric])
+            s.aggregates["repetitions"] = r.get("repetitions", 1)
+    return out
+
+
+def load(path, metric):
+    """return a dict of case -> benchmark name -> Samples; the case is
+    the name of the results file"""
+    if os.path.isdir(path):
+        files = sorted(f for f in os.listdir(path) if f.endswith(".json"))
+        return {os.path.splitext(f)[0]: load_file(os.path.join(path, f), metric) for f in files}
+    return {"": load_file(path, metric)}
+
+
+# -----------------------------------------------------------------------------
+
+def compare(baseline, candidate, metric, threshold, alpha):
+    """return a list of rows (case, name, base, cand, change_pct, pvalue, verdict)"""
+    higher_is_better = metric in _higher_is_better
+    rows = []
+    single_files = list(baseline) == [""] and list(candidate) == [""]
+    for case in sorted(set(baseline) | set(candidate)):
+        if not single_files and (case not in baseline or case not in candidate):
+            rows.append((case, "*", None, None, None, None, "missing in " + ("baseline" if case not in baseline else "candidate")))
+            continue
+        bcase, ccase = baseline.get(case, {}), candidate.get(case, {})
+        for name in list(bcase) + [n for n in ccase if n not in bcase]:
+            if name not in bcase or name not in ccase:
+                rows.append((case, name, None, None, None, None, "missing in " + ("baseline" if name not in bcase else "candidate")))
+                continue
+            n1, m1, v1 = bcase[name].stats()
+            n2, m2, v2 = ccase[name].stats()
+            if m1 is None or m2 is None or m1 == 0.:
+                rows.append((case, name, m1, m2, None, None, "no data"))
+                continue
+            change = 100. * (m2 - m1) / m1
+            worse = -change if higher_is_better else change
+            p = welch(n1, m1, v1, n2, m2, v2)
+            significant = p is None or p < alpha
+            if worse > threshold and significant:
+                verdict = "REGRESSION"
+            elif -worse > threshold and significant:
+                verdict = "improvement"
+            else:
+                verdict = ""
+            rows.append((case, name, m1, m2, change, p, verdict))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--metric", default="real_time", help="the value to compare: real_time (default), cpu_time, or any counter, eg bytes_per_second")
+    parser.add_argument("--threshold", type=float, default=5., help="the change in percent beyond which a benchmark is flagged (default: 5)")
+    parser.add_argument("--alpha", type=float, default=0.05, help="the significance level of the t-test (default: 0.05)")
+    parser.add_argument("--all", action="store_true", help="show all the benchmarks, not only the flagged ones")
+    parser.add_argument("baseline", help="the results of the baseline: a json file or a directory of json files")
+    parser.add_argument("candidate", help="the results to compare with the baseline: a json file or a directory of json files")
+    args = parser.parse_args()
+    rows = compare(load(args.baseline, args.metric), load(args.candidate, args.metric),
+                   args.metric, args.threshold, args.alpha)
+    shown = rows if args.all else [r for r in rows if r[6]]
+    def fmt(v, spec):
+        return "-" if v is None else format(v, spec)
+    if shown:
+        wcase = max([len("Case")] + [len(r[0]) for r in shown])
+        wname = max([len("Benchmark")] + [len(r[1]) for r in shown])
+        print(f"{'Case':<{wcase}}  {'Benchmark':<{wname}}  {'Baseline':>14}  {'Candidate':>14}  {'Change':>9}  {'p-value':>8}  Verdict")
+        for case, name, m1, m2, change, p, verdict in shown:
+            change = "-" if change is None else f"{change:+.2f}%"
+            print(f"{case:<{wcase}}  {name:<{wname}}  {fmt(m1, '.6g'):>14}  {fmt(m2, '.6g'):>14}  {change:>9}  {fmt(p, '.4f'):>8}  {verdict}")
+    num_regressions = sum(1 for r in rows if r[6] == "REGRESSION")
+    print(f"{len(rows)} benchmarks compared ({args.metric}): {num_regressions} regressions beyond {args.threshold}%")
+    return 1 if num_regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
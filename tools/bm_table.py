@@ -0,0 +1,88 @@
+"""Format the json results of the benchmarks (obtained with
+--benchmark_out=<file>.json --benchmark_out_format=json) as the tables
+in bm/results, with all the counters (including the performance and
+allocation counters) in the UserCounters column.
+
+Each results file is a block of the table; eg, to compare compilers:
+
+    python tools/bm_table.py --case travis \\
+        clang-Release:parse_travis_clang.json \\
+        gcc-Release:parse_travis_gcc.json
+"""
+
+import json
+import argparse
+
+
+# the fields of a benchmark run which are not counters
+_not_counters = {
+    "name", "family_index", "per_family_instance_index", "run_name",
+    "run_type", "repetitions", "repetition_index", "threads",
+    "iterations", "real_time", "cpu_time", "time_unit",
+    "aggregate_name", "aggregate_unit", "error_occurred",
+    "error_message", "label",
+}
+
+_rates = {"bytes_per_second": 1024., "items_per_second": 1000.}
+
+
+def human(val, base=1000.):
+    """format a number as the benchmark console does, eg 2.17586M"""
+    for suffix in ("", "k", "M", "G", "T"):
+        if abs(val) < base or suffix == "T":
+            return f"{val:.6g}{suffix}"
+        val /= base
+    return f"{val:.6g}"
+
+
+def counters(run):
+    out = []
+    for k, v in run.items():
+        if k in _not_counters or not isinstance(v, (int, float)):
+            continue
+        if k in _rates:
+            out.append(f"{k}={human(v, _rates[k])}/s")
+        else:
+            out.append(f"{k}={human(v)}")
+    return out
+
+
+def load(spec):
+    """spec is [compilation:]file.json"""
+    compilation, _, filename = spec.rpartition(":")
+    with open(filename) as f:
+        results = json.load(f)
+    if not compilation:
+        compilation = results.get("context", {}).get("library_build_type", "")
+    return compilation, results["benchmarks"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--case", default="", help="the name of the case, for the first column")
+    parser.add_argument("results", nargs="+", help="the results files, as [compilation:]file.json")
+    args = parser.parse_args()
+    blocks = [load(spec) for spec in args.results]
+    # the column widths
+    wcase = max(len("Case"), len(args.case))
+    wname = max([len("Benchmark")] + [len(r["name"].replace("bm_", "", 1)) for _, runs in blocks for r in runs])
+    wcomp = max([len("Compilation")] + [len(c) for c, _ in blocks])
+    sep = "-" * (wcase + wname + wcomp + 48 + len("UserCounters...") + 4)
+    print(sep)
+    print(f"{'Case':<{wcase}}  {'Benchmark':<{wname}}  {'Compilation':>{wcomp}}  {'Time':>15}  {'CPU':>15}  {'Iterations':>12}  UserCounters...")
+    print(sep)
+    for compilation, runs in blocks:
+        for r in runs:
+            name = r["name"].replace("bm_", "", 1)
+            if r.get("error_occurred"):
+                print(f"{args.case:<{wcase}}  {name:<{wname}}  {compilation:>{wcomp}}  ERROR: {r.get('error_message', '')}")
+                continue
+            unit = r.get("time_unit", "ns")
+            real = f"{r['real_time']:.0f} {unit}"
+            cpu = f"{r['cpu_time']:.0f} {unit}"
+            print(f"{args.case:<{wcase}}  {name:<{wname}}  {compilation:>{wcomp}}  {real:>15}  {cpu:>15}  {r['iterations']:>12}  " + " ".join(counters(r)))
+        print(sep)
+
+
+if __name__ == "__main__":
+    main()